@@ -0,0 +1,255 @@
+// compares the decisions of alternative engines with those of the default ones on simulated data
+// - mismappers: seed-and-extend alignment (default) vs. banded local alignment (-W) of reads against a gene
+// - homologs: exact homology check vs. homology check with a pre-screen based on sketches of the genes
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "common.hpp"
+#include "annotation.hpp"
+#include "assembly.hpp"
+#include "filter_mismappers.hpp"
+#include "filter_homologs.hpp"
+
+using namespace std;
+
+// defined in arriba.cpp, which is not linked
+const string FILTER_NAMES[FILTER_COUNT];
+unordered_map<string,filter_t> FILTERS;
+
+const char KMER_LENGTH = 8; // as in arriba.cpp
+
+string random_sequence(mt19937& random, const unsigned int length) {
+	string sequence(length, 'N');
+	for (unsigned int i = 0; i < length; ++i)
+		sequence[i] = "ACGT"[random() % 4];
+	return sequence;
+}
+
+void mutate(mt19937& random, string& sequence, const unsigned int mismatch_rate) {
+	for (unsigned int i = 0; i < sequence.size(); ++i)
+		if (random() % mismatch_rate == 0)
+			sequence[i] = "ACGT"[random() % 4];
+}
+
+// score of the best ungapped local alignment of a read on the diagonal it was simulated from,
+// scored like align_banded() (+1 per match, -1 per mismatch)
+int ungapped_local_score(const string& read_sequence, const string& contig_sequence, const position_t origin) {
+	int score = 0, best_score = 0;
+	for (unsigned int i = 0; i < read_sequence.size(); ++i) {
+		score = max(0, score + ((read_sequence[i] == contig_sequence[origin + i]) ? 1 : -1));
+		best_score = max(best_score, score);
+	}
+	return best_score;
+}
+
+// simulate reads of different kinds from a gene and check if the two engines align them
+// a read counts as aligned if it aligns to either strand, as in the filter 'mismappers'
+// two kinds of genes are simulated:
+// - dispersed: random sequence with a few copies of short segments
+// - repetitive: the whole gene consists of diverged copies of a short unit (worst case for the runtime per read)
+// for reads with mismatches only, the decisions are also compared with the exact ungapped alignment score on the diagonal of origin
+int compare_mismapper_engines() {
+	const char* genes[] = { "dispersed", "repetitive" };
+	const unsigned int gene_kind_count = 2;
+	const char* kinds[] = { "random", "mismatches", "spliced", "indel" };
+	const unsigned int kind_count = 4;
+	const int min_score = 40; // as in filter_mismappers()
+	const float min_align_percent = 0.8;
+	int errors = 0;
+
+	cout << "#mismappers\tgene\treads\taligned_by_default\taligned_by_banded\tagreeing\taligned_by_reference\tdefault_agrees_with_reference\tbanded_agrees_with_reference" << endl;
+	for (unsigned int gene_kind = 0; gene_kind < gene_kind_count; ++gene_kind) {
+		unsigned int reads[kind_count] = {0}, aligned_default[kind_count] = {0}, aligned_banded[kind_count] = {0}, agreeing[kind_count] = {0};
+		unsigned int aligned_reference = 0, default_agrees_with_reference = 0, banded_agrees_with_reference = 0;
+		double seconds_default = 0, seconds_banded = 0, max_seconds_default = 0, max_seconds_banded = 0;
+
+		mt19937 random(1);
+		for (unsigned int round = 0; round < 40; ++round) {
+
+			// make a contig with a gene that has repeats and introns
+			string contig_sequence = random_sequence(random, 30000);
+			if (gene_kind == 0) {
+				for (unsigned int repeat = 0; repeat < 20; ++repeat)
+					contig_sequence.replace(random() % 29000, 200, contig_sequence.substr(random() % 29000, 200));
+			} else {
+				const string unit = random_sequence(random, 300);
+				for (position_t copy = 5000; copy < 25000; copy += unit.size()) {
+					string diverged_unit = unit;
+					mutate(random, diverged_unit, 20);
+					contig_sequence.replace(copy, diverged_unit.size(), diverged_unit);
+				}
+				contig_sequence.resize(30000);
+			}
+			assembly_t assembly;
+			assembly[0] = contig_sequence;
+			gene_annotation_record_t gene, other_gene;
+			gene.contig = other_gene.contig = 0;
+			gene.strand = other_gene.strand = FORWARD;
+			gene.start = 5000; gene.end = 25000;
+			other_gene.start = 0; other_gene.end = 1000;
+			splice_sites_t splice_sites;
+			for (position_t splice_site = 6000; splice_site < 24000; splice_site += 1500)
+				splice_sites.insert(splice_site);
+
+			// index the gene as make_kmer_index() does for genes involved in fusions
+			fusions_t fusions;
+			fusion_t& fusion = fusions[fusions_t::key_type(0, 1, 0, 0, 0, 0, UPSTREAM, DOWNSTREAM)];
+			fusion.gene1 = &gene;
+			fusion.gene2 = &other_gene;
+			kmer_indices_t kmer_indices;
+			make_kmer_index(fusions, assembly, KMER_LENGTH, kmer_indices);
+			const position_t window_start = gene.start - 100;
+			const position_t window_end = gene.end + 100;
+
+			for (unsigned int read = 0; read < 200; ++read) {
+				const unsigned int kind = random() % kind_count;
+				const unsigned int length = 20 + random() % 80;
+				string read_sequence;
+				position_t origin = 0;
+				if (kind == 0) {
+					read_sequence = random_sequence(random, length);
+				} else {
+					origin = gene.start + random() % (gene.end - gene.start - 1000);
+					read_sequence = contig_sequence.substr(origin, length);
+					if (kind == 2) { // jump from the next splice site to a position further downstream
+						const splice_sites_t::const_iterator splice_site = splice_sites.lower_bound(origin);
+						if (splice_site != splice_sites.end() && *splice_site + 10 < origin + (int) length)
+							read_sequence = contig_sequence.substr(origin, *splice_site - origin + 1) + contig_sequence.substr(*splice_site + 301 + random() % 500, length - (*splice_site - origin + 1));
+					}
+					mutate(random, read_sequence, 12);
+					if (kind == 3 && length > 30)
+						read_sequence.erase(length / 2, 1 + random() % 3);
+				}
+				string reverse_complement;
+				dna_to_reverse_complement(read_sequence, reverse_complement);
+				const int read_min_score = min(min_score, (int) (min_align_percent * read_sequence.size() + 0.5));
+
+				chrono::steady_clock::time_point start = chrono::steady_clock::now();
+				const bool default_aligns = align(0, read_sequence, 0, contig_sequence, window_start, window_start, window_end, kmer_indices[0], KMER_LENGTH, splice_sites, read_min_score, 1) ||
+				                            align(0, reverse_complement, 0, contig_sequence, window_start, window_start, window_end, kmer_indices[0], KMER_LENGTH, splice_sites, read_min_score, 1);
+				chrono::steady_clock::time_point middle = chrono::steady_clock::now();
+				const bool banded_aligns = align_banded(read_sequence, contig_sequence, window_start, window_end, kmer_indices[0], KMER_LENGTH, splice_sites, read_min_score) ||
+				                           align_banded(reverse_complement, contig_sequence, window_start, window_end, kmer_indices[0], KMER_LENGTH, splice_sites, read_min_score);
+				chrono::steady_clock::time_point end = chrono::steady_clock::now();
+				seconds_default += chrono::duration<double>(middle - start).count();
+				seconds_banded += chrono::duration<double>(end - middle).count();
+				max_seconds_default = max(max_seconds_default, chrono::duration<double>(middle - start).count());
+				max_seconds_banded = max(max_seconds_banded, chrono::duration<double>(end - middle).count());
+
+				reads[kind]++;
+				aligned_default[kind] += default_aligns;
+				aligned_banded[kind] += banded_aligns;
+				agreeing[kind] += default_aligns == banded_aligns;
+				if (kind == 1) {
+					const bool reference_aligns = ungapped_local_score(read_sequence, contig_sequence, origin) >= read_min_score;
+					aligned_reference += reference_aligns;
+					default_agrees_with_reference += default_aligns == reference_aligns;
+					banded_agrees_with_reference += banded_aligns == reference_aligns;
+				}
+			}
+		}
+
+		unsigned int total_reads = 0, total_agreeing = 0;
+		for (unsigned int kind = 0; kind < kind_count; ++kind) {
+			cout << kinds[kind] << "\t" << genes[gene_kind] << "\t" << reads[kind] << "\t" << aligned_default[kind] << "\t" << aligned_banded[kind] << "\t" << agreeing[kind];
+			if (kind == 1)
+				cout << "\t" << aligned_reference << "\t" << default_agrees_with_reference << "\t" << banded_agrees_with_reference << endl;
+			else
+				cout << "\t.\t.\t." << endl;
+			total_reads += reads[kind];
+			total_agreeing += agreeing[kind];
+		}
+		cout << "total\t" << genes[gene_kind] << "\t" << total_reads << "\t.\t.\t" << total_agreeing << "\t.\t.\t." << endl;
+		cout << "seconds\t" << genes[gene_kind] << "\t.\t" << seconds_default << "\t" << seconds_banded << "\t.\t.\t.\t." << endl;
+		cout << "max_microseconds_per_read\t" << genes[gene_kind] << "\t.\t" << max_seconds_default * 1000000 << "\t" << max_seconds_banded * 1000000 << "\t.\t.\t.\t." << endl;
+
+		// the engines are expected to differ for reads with indels, but random reads must never align
+		if (aligned_banded[0] > 0) {
+			cerr << "ERROR: banded alignment aligned random reads in " << genes[gene_kind] << " genes" << endl;
+			errors++;
+		}
+	}
+	return errors;
+}
+
+// simulate pairs of genes with varying degrees of sequence similarity and check if the homology check
+// gives the same result with and without the pre-screen
+// the pre-screen rejects pairs based on an estimate, but on these genes it is not expected to change the result, so any disagreement is an error
+int compare_homolog_engines() {
+	const float max_identity_fraction = 0.3; // default of -L
+	const unsigned int gene_count = 40;
+	unsigned int pairs = 0, homologs_exact = 0, homologs_screened = 0, agreeing = 0;
+	double seconds_exact = 0, seconds_screened = 0;
+
+	mt19937 random(1);
+	for (unsigned int round = 0; round < 20; ++round) {
+
+		// make genes of random length on random strands
+		string contig_sequence = random_sequence(random, 2000000);
+		vector<gene_annotation_record_t> genes(gene_count);
+		for (unsigned int gene = 0; gene < gene_count; ++gene) {
+			genes[gene].contig = 0;
+			genes[gene].start = gene * 50000 + 10;
+			genes[gene].end = genes[gene].start + 1000 + random() % 40000;
+			genes[gene].strand = (random() % 2) ? FORWARD : REVERSE;
+		}
+
+		// make every other gene similar to the preceding one by copying a random fraction of it with a random mismatch rate
+		for (unsigned int gene = 0; gene + 1 < gene_count; gene += 2) {
+			const unsigned int length = min(genes[gene].length(), genes[gene+1].length()) * (random() % 100) / 100;
+			string copy = contig_sequence.substr(genes[gene].start, length);
+			mutate(random, copy, 5 + random() % 30);
+			if (genes[gene].strand != genes[gene+1].strand)
+				copy = dna_to_reverse_complement(copy);
+			contig_sequence.replace(genes[gene+1].start, copy.size(), copy);
+		}
+		assembly_t assembly;
+		assembly[0] = contig_sequence;
+
+		// index the genes as make_kmer_index() does for genes involved in fusions
+		fusions_t fusions;
+		for (unsigned int gene = 0; gene + 1 < gene_count; gene += 2) {
+			fusion_t& fusion = fusions[fusions_t::key_type(gene, gene+1, 0, 0, 0, 0, UPSTREAM, DOWNSTREAM)];
+			fusion.gene1 = &genes[gene];
+			fusion.gene2 = &genes[gene+1];
+		}
+		kmer_indices_t kmer_indices;
+		make_kmer_index(fusions, assembly, KMER_LENGTH, kmer_indices);
+
+		// compare all pairs of genes, the time of the screened check includes making the sketches
+		gene_sketches_t gene_sketches;
+		for (unsigned int gene1 = 0; gene1 < gene_count; ++gene1) {
+			for (unsigned int gene2 = gene1 + 1; gene2 < gene_count; ++gene2) {
+				chrono::steady_clock::time_point start = chrono::steady_clock::now();
+				const bool exact = is_homolog(&genes[gene1], &genes[gene2], kmer_indices, KMER_LENGTH, assembly, max_identity_fraction, NULL);
+				chrono::steady_clock::time_point middle = chrono::steady_clock::now();
+				const bool screened = is_homolog(&genes[gene1], &genes[gene2], kmer_indices, KMER_LENGTH, assembly, max_identity_fraction, &gene_sketches);
+				chrono::steady_clock::time_point end = chrono::steady_clock::now();
+				seconds_exact += chrono::duration<double>(middle - start).count();
+				seconds_screened += chrono::duration<double>(end - middle).count();
+				pairs++;
+				homologs_exact += exact;
+				homologs_screened += screened;
+				agreeing += exact == screened;
+			}
+		}
+	}
+
+	cout << "#homologs\tpairs\thomologs_by_exact\thomologs_by_screened\tagreeing\tseconds_exact\tseconds_screened" << endl;
+	cout << "total\t" << pairs << "\t" << homologs_exact << "\t" << homologs_screened << "\t" << agreeing << "\t" << seconds_exact << "\t" << seconds_screened << endl;
+
+	if (agreeing != pairs) {
+		cerr << "ERROR: the pre-screen changed the result of the homology check" << endl;
+		return 1;
+	}
+	return 0;
+}
+
+int main(int argc, char **argv) {
+	const int mismapper_errors = compare_mismapper_engines();
+	const int homolog_errors = compare_homolog_engines();
+	return (mismapper_errors || homolog_errors) ? 1 : 0;
+}
@@ -0,0 +1,527 @@
+// generates a synthetic data set to benchmark Arriba on:
+// a random assembly, a matching annotation in GTF format, and a BAM file like the one STAR writes
+// when run with '--chimOutType WithinBAM SoftClip', containing a controlled number of normal fragments,
+// split reads, discordant mates, and read-through fragments
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "sam.h"
+
+using namespace std;
+
+const unsigned int CONTIGS = 4;
+const unsigned int GENES_PER_CONTIG = 250;
+const int READ_LENGTH = 100;
+const int MIN_ANCHOR_LENGTH = 20;
+const int MIN_FUSION_PARTNER_LENGTH = 300; // minimum length of either part of a fusion transcript, so that all kinds of fragments fit
+
+struct exon_t {
+	int start; // 0-based
+	int end; // exclusive
+};
+
+struct gene_t {
+	string name;
+	unsigned int contig;
+	vector<exon_t> exons;
+};
+
+// a stretch of a transcript which maps to a contiguous region of the genome
+// stretches of the same block are aligned in one piece (with introns in between),
+// a new block begins after the breakpoint of a fusion
+struct segment_t {
+	unsigned int contig;
+	int start;
+	int end;
+	unsigned int block;
+};
+typedef vector<segment_t> transcript_t;
+
+struct event_t {
+	string type; // "translocation/inversion/deletion" or "read-through"
+	unsigned int gene1;
+	unsigned int gene2;
+	transcript_t transcript;
+	int junction; // position of the breakpoint in the transcript
+	int breakpoint1; // last base of the 5' gene (1-based)
+	int breakpoint2; // first base of the 3' gene (1-based)
+	unsigned int split_reads;
+	unsigned int discordant_mates;
+};
+
+// alignment of (part of) a read
+struct alignment_t {
+	unsigned int contig;
+	int position;
+	string cigar;
+	int read_start; // first aligned base in the read
+	int read_end; // one past the last aligned base in the read
+	unsigned int block;
+};
+
+struct options_t {
+	string output_directory;
+	long unsigned int records;
+	unsigned int fusions;
+	unsigned int read_through_events;
+	double split_read_fraction;
+	double discordant_mate_fraction;
+	double read_through_fraction;
+	unsigned int seed;
+	bool sorted;
+};
+
+void print_usage(const string& program) {
+	cout << "Usage: " << program << " -o OUTPUT_DIRECTORY -n RECORDS [-f FUSIONS] [-t READ_THROUGH_EVENTS] [-s SPLIT_READ_FRACTION] [-d DISCORDANT_MATE_FRACTION] [-r READ_THROUGH_FRACTION] [-x SEED] [-c]" << endl
+	     << endl
+	     << "Writes the files assembly.fa(.fai), annotation.gtf, Aligned.out.bam, and truth.tsv to OUTPUT_DIRECTORY." << endl
+	     << "The BAM file holds approximately RECORDS records. The fractions are relative to the number of fragments." << endl
+	     << "With -c, the BAM file is sorted by coordinate and indexed (Aligned.out.bam.bai) like the output of" << endl
+	     << "STAR with '--outSAMtype BAM SortedByCoordinate'. All records are held in memory for sorting." << endl;
+}
+
+options_t parse_arguments(int argc, char **argv) {
+	options_t options;
+	options.records = 0;
+	options.fusions = 50;
+	options.read_through_events = 10;
+	options.split_read_fraction = 0.001;
+	options.discordant_mate_fraction = 0.001;
+	options.read_through_fraction = 0.001;
+	options.seed = 1;
+	options.sorted = false;
+
+	int c;
+	while ((c = getopt(argc, argv, "o:n:f:t:s:d:r:x:ch")) != -1) {
+		char* end;
+		switch (c) {
+			case 'o': options.output_directory = optarg; break;
+			case 'n': options.records = strtoul(optarg, &end, 10); if (*end != '\0') options.records = 0; break;
+			case 'f': options.fusions = strtoul(optarg, &end, 10); if (*end != '\0') options.fusions = 0; break;
+			case 't': options.read_through_events = strtoul(optarg, &end, 10); if (*end != '\0') options.read_through_events = 0; break;
+			case 's': options.split_read_fraction = strtod(optarg, &end); if (*end != '\0') options.split_read_fraction = -1; break;
+			case 'd': options.discordant_mate_fraction = strtod(optarg, &end); if (*end != '\0') options.discordant_mate_fraction = -1; break;
+			case 'r': options.read_through_fraction = strtod(optarg, &end); if (*end != '\0') options.read_through_fraction = -1; break;
+			case 'x': options.seed = strtoul(optarg, &end, 10); break;
+			case 'c': options.sorted = true; break;
+			case 'h': print_usage(argv[0]); exit(0);
+			default: print_usage(argv[0]); exit(1);
+		}
+	}
+
+	if (options.output_directory.empty() || options.records == 0) {
+		print_usage(argv[0]);
+		exit(1);
+	}
+	if (options.fusions == 0 || options.read_through_events == 0) {
+		cerr << "ERROR: there must be at least one fusion and one read-through event." << endl;
+		exit(1);
+	}
+	if (options.split_read_fraction < 0 || options.discordant_mate_fraction < 0 || options.read_through_fraction < 0 ||
+	    options.split_read_fraction + options.discordant_mate_fraction + options.read_through_fraction >= 1) {
+		cerr << "ERROR: fractions must be positive and sum up to less than 1." << endl;
+		exit(1);
+	}
+	return options;
+}
+
+int transcript_length(const transcript_t& transcript) {
+	int length = 0;
+	for (auto segment = transcript.begin(); segment != transcript.end(); ++segment)
+		length += segment->end - segment->start;
+	return length;
+}
+
+// make a transcript from the exons <first_exon> to <last_exon> of a gene
+void append_exons(const gene_t& gene, const unsigned int first_exon, const unsigned int last_exon, const unsigned int block, transcript_t& transcript) {
+	for (unsigned int exon = first_exon; exon <= last_exon; ++exon) {
+		segment_t segment = { gene.contig, gene.exons[exon].start, gene.exons[exon].end, block };
+		transcript.push_back(segment);
+	}
+}
+
+// find the alignments of the read which covers the bases <from> to <to> of a transcript
+void align_read(const transcript_t& transcript, const int from, const int to, vector<alignment_t>& alignments, string& sequence, const vector<string>& assembly) {
+	alignments.clear();
+	sequence.clear();
+	int transcript_position = 0;
+	int previous_end = -1;
+	for (auto segment = transcript.begin(); segment != transcript.end(); ++segment) {
+		const int segment_length = segment->end - segment->start;
+		const int overlap_start = max(from, transcript_position);
+		const int overlap_end = min(to, transcript_position + segment_length);
+		if (overlap_start < overlap_end) {
+			const int genomic_start = segment->start + overlap_start - transcript_position;
+			const int genomic_end = segment->start + overlap_end - transcript_position;
+			ostringstream cigar;
+			if (alignments.empty() || alignments.back().block != segment->block) {
+				alignment_t alignment = { segment->contig, genomic_start, "", overlap_start - from, overlap_start - from, segment->block };
+				alignments.push_back(alignment);
+			} else {
+				cigar << (genomic_start - previous_end) << "N";
+			}
+			cigar << (genomic_end - genomic_start) << "M";
+			alignments.back().cigar += cigar.str();
+			alignments.back().read_end = overlap_end - from;
+			sequence += assembly[segment->contig].substr(genomic_start, genomic_end - genomic_start);
+			previous_end = genomic_end;
+		}
+		transcript_position += segment_length;
+	}
+
+	// soft-clip the parts of the read which belong to another block
+	for (auto alignment = alignments.begin(); alignment != alignments.end(); ++alignment) {
+		if (alignment->read_start > 0)
+			alignment->cigar = to_string(static_cast<long long int>(alignment->read_start)) + "S" + alignment->cigar;
+		if (alignment->read_end < to - from)
+			alignment->cigar += to_string(static_cast<long long int>(to - from - alignment->read_end)) + "S";
+	}
+}
+
+// records are written right away, unless <sort_buffer> is given, in which case they are collected for sorting
+void write_record(samFile* bam_file, bam_hdr_t* bam_header, bam1_t* bam_record, string& line, vector<bam1_t*>* sort_buffer) {
+	kstring_t sam_line = { line.size(), line.size() + 1, &line[0] };
+	if (sam_parse1(&sam_line, bam_header, bam_record) < 0 ||
+	    sort_buffer == NULL && sam_write1(bam_file, bam_header, bam_record) < 0) {
+		cerr << "ERROR: failed to write BAM record: " << line << endl;
+		exit(1);
+	}
+	if (sort_buffer != NULL)
+		sort_buffer->push_back(bam_dup1(bam_record));
+}
+
+// order of records in a BAM file sorted by coordinate
+// records at the same position keep the order in which they were generated, so the output is reproducible
+bool bam_record_position_less(const bam1_t* x, const bam1_t* y) {
+	return x->core.tid < y->core.tid || x->core.tid == y->core.tid && x->core.pos < y->core.pos;
+}
+
+// writes the records of a fragment the way STAR does it:
+// - both mates are aligned in one piece => normal fragment (proper pair) or discordant mates
+// - one mate is aligned in two pieces => split read, the longer piece becomes the primary alignment, the other one the supplementary
+// returns the number of records written
+unsigned int write_fragment(const string& name, const transcript_t& transcript, const int fragment_start, const int fragment_length, const vector<string>& contig_names, const vector<string>& assembly, samFile* bam_file, bam_hdr_t* bam_header, bam1_t* bam_record, vector<bam1_t*>* sort_buffer) {
+
+	// mate1 is on the forward strand, mate2 on the reverse strand,
+	// since all genes are on the forward strand, the sequence of both mates can be taken from the transcript
+	vector<alignment_t> alignments[2];
+	string sequences[2];
+	align_read(transcript, fragment_start, fragment_start + READ_LENGTH, alignments[0], sequences[0], assembly);
+	align_read(transcript, fragment_start + fragment_length - READ_LENGTH, fragment_start + fragment_length, alignments[1], sequences[1], assembly);
+
+	// pick primary alignments
+	unsigned int primary[2];
+	for (unsigned int mate = 0; mate <= 1; ++mate) {
+		primary[mate] = 0;
+		for (unsigned int i = 1; i < alignments[mate].size(); ++i)
+			if (alignments[mate][i].read_end - alignments[mate][i].read_start > alignments[mate][primary[mate]].read_end - alignments[mate][primary[mate]].read_start)
+				primary[mate] = i;
+	}
+
+	const bool proper_pair = alignments[0].size() == 1 && alignments[1].size() == 1 && alignments[0][0].block == alignments[1][0].block;
+	unsigned int records = 0;
+	for (unsigned int mate = 0; mate <= 1; ++mate) {
+		const alignment_t& mate_alignment = alignments[1-mate][primary[1-mate]];
+		for (unsigned int i = 0; i < alignments[mate].size(); ++i) {
+			const alignment_t& alignment = alignments[mate][i];
+			unsigned int flag = BAM_FPAIRED | ((mate == 0) ? BAM_FREAD1 | BAM_FMREVERSE : BAM_FREAD2 | BAM_FREVERSE);
+			if (proper_pair)
+				flag |= BAM_FPROPER_PAIR;
+			if (i != primary[mate])
+				flag |= BAM_FSUPPLEMENTARY;
+			int template_length = 0;
+			if (proper_pair)
+				template_length = (mate == 0) ? fragment_length : -fragment_length;
+			ostringstream line;
+			line << name << "\t" << flag << "\t" << contig_names[alignment.contig] << "\t" << (alignment.position + 1) << "\t255\t" << alignment.cigar << "\t"
+			     << ((mate_alignment.contig == alignment.contig) ? "=" : contig_names[mate_alignment.contig]) << "\t" << (mate_alignment.position + 1) << "\t" << template_length << "\t"
+			     << sequences[mate] << "\t*\tNH:i:1";
+			if (alignments[mate].size() > 1) {
+				const alignment_t& other = alignments[mate][1-i];
+				line << "\tSA:Z:" << contig_names[other.contig] << "," << (other.position + 1) << "," << ((mate == 0) ? "+" : "-") << "," << other.cigar << ",255,0;";
+			}
+			string sam_line = line.str();
+			write_record(bam_file, bam_header, bam_record, sam_line, sort_buffer);
+			++records;
+		}
+	}
+	return records;
+}
+
+// pick the last exon of the 5' gene and the first exon of the 3' gene of a fusion,
+// such that both parts of the fusion transcript are long enough to accomodate all kinds of fragments
+bool pick_breakpoint_exons(const gene_t& gene1, const gene_t& gene2, mt19937_64& random, unsigned int& exon1, unsigned int& exon2) {
+	vector<unsigned int> candidates1, candidates2;
+	int length = 0;
+	for (unsigned int exon = 0; exon + 1 < gene1.exons.size(); ++exon) {
+		length += gene1.exons[exon].end - gene1.exons[exon].start;
+		if (length >= MIN_FUSION_PARTNER_LENGTH)
+			candidates1.push_back(exon);
+	}
+	length = 0;
+	for (unsigned int exon = gene2.exons.size() - 1; exon > 0; --exon) {
+		length += gene2.exons[exon].end - gene2.exons[exon].start;
+		if (length >= MIN_FUSION_PARTNER_LENGTH)
+			candidates2.push_back(exon);
+	}
+	if (candidates1.empty() || candidates2.empty())
+		return false;
+	exon1 = candidates1[uniform_int_distribution<size_t>(0, candidates1.size()-1)(random)];
+	exon2 = candidates2[uniform_int_distribution<size_t>(0, candidates2.size()-1)(random)];
+	return true;
+}
+
+event_t make_event(const string& type, const vector<gene_t>& genes, const unsigned int gene1, const unsigned int gene2, const unsigned int exon1, const unsigned int exon2) {
+	event_t event;
+	event.type = type;
+	event.gene1 = gene1;
+	event.gene2 = gene2;
+	append_exons(genes[gene1], 0, exon1, 0, event.transcript);
+	event.junction = transcript_length(event.transcript);
+	event.breakpoint1 = genes[gene1].exons[exon1].end;
+	event.breakpoint2 = genes[gene2].exons[exon2].start + 1;
+	// read-through transcripts are aligned in one piece, i.e., the intergenic region is treated like an intron
+	append_exons(genes[gene2], exon2, genes[gene2].exons.size() - 1, (type == "read-through") ? 0 : 1, event.transcript);
+	event.split_reads = 0;
+	event.discordant_mates = 0;
+	return event;
+}
+
+int main(int argc, char **argv) {
+
+	options_t options = parse_arguments(argc, argv);
+	mt19937_64 random(options.seed);
+	const string nucleotides = "ACGT";
+
+	// make random contigs with genes on the forward strand
+	cout << "Generating assembly and annotation" << endl;
+	vector<string> contig_names;
+	vector<string> assembly;
+	vector<gene_t> genes;
+	for (unsigned int contig = 0; contig < CONTIGS; ++contig) {
+		contig_names.push_back(to_string(static_cast<long long unsigned int>(contig + 1)));
+		int position = uniform_int_distribution<int>(2000, 20000)(random);
+		for (unsigned int gene = 0; gene < GENES_PER_CONTIG; ++gene) {
+			gene_t new_gene;
+			new_gene.name = "GENE" + to_string(static_cast<long long unsigned int>(genes.size() + 1));
+			new_gene.contig = contig;
+			const unsigned int exons = uniform_int_distribution<unsigned int>(4, 8)(random);
+			for (unsigned int exon = 0; exon < exons; ++exon) {
+				if (exon > 0)
+					position += uniform_int_distribution<int>(500, 5000)(random); // intron
+				exon_t new_exon;
+				new_exon.start = position;
+				position += uniform_int_distribution<int>(100, 300)(random);
+				new_exon.end = position;
+				new_gene.exons.push_back(new_exon);
+			}
+			genes.push_back(new_gene);
+			position += uniform_int_distribution<int>(2000, 20000)(random); // intergenic region
+		}
+		string sequence(position, 'N');
+		for (auto base = sequence.begin(); base != sequence.end(); ++base)
+			*base = nucleotides[random() & 3];
+		assembly.push_back(sequence);
+	}
+
+	// write assembly and index
+	{
+		ofstream fasta(options.output_directory + "/assembly.fa");
+		ofstream fasta_index(options.output_directory + "/assembly.fa.fai");
+		if (!fasta.is_open() || !fasta_index.is_open()) {
+			cerr << "ERROR: failed to open assembly in '" << options.output_directory << "' for writing." << endl;
+			exit(1);
+		}
+		const unsigned int line_bases = 60;
+		long unsigned int offset = 0;
+		for (unsigned int contig = 0; contig < CONTIGS; ++contig) {
+			offset += contig_names[contig].size() + 2;
+			fasta << ">" << contig_names[contig] << "\n";
+			fasta_index << contig_names[contig] << "\t" << assembly[contig].size() << "\t" << offset << "\t" << line_bases << "\t" << (line_bases + 1) << "\n";
+			for (string::size_type position = 0; position < assembly[contig].size(); position += line_bases) {
+				const string line = assembly[contig].substr(position, line_bases);
+				fasta << line << "\n";
+				offset += line.size() + 1;
+			}
+		}
+	}
+
+	// write annotation
+	{
+		ofstream gtf(options.output_directory + "/annotation.gtf");
+		if (!gtf.is_open()) {
+			cerr << "ERROR: failed to open annotation in '" << options.output_directory << "' for writing." << endl;
+			exit(1);
+		}
+		for (auto gene = genes.begin(); gene != genes.end(); ++gene) {
+			const string attributes = "gene_id \"" + gene->name + "\"; transcript_id \"" + gene->name + ".1\"; gene_name \"" + gene->name + "\"; gene_type \"protein_coding\";";
+			const string& contig = contig_names[gene->contig];
+			gtf << contig << "\tbenchmark\tgene\t" << (gene->exons.front().start + 1) << "\t" << gene->exons.back().end << "\t.\t+\t.\t" << attributes << "\n"
+			    << contig << "\tbenchmark\ttranscript\t" << (gene->exons.front().start + 1) << "\t" << gene->exons.back().end << "\t.\t+\t.\t" << attributes << "\n";
+			int coding_length = 0;
+			for (auto exon = gene->exons.begin(); exon != gene->exons.end(); ++exon) {
+				gtf << contig << "\tbenchmark\texon\t" << (exon->start + 1) << "\t" << exon->end << "\t.\t+\t.\t" << attributes << "\n"
+				    << contig << "\tbenchmark\tCDS\t" << (exon->start + 1) << "\t" << exon->end << "\t.\t+\t" << ((3 - coding_length % 3) % 3) << "\t" << attributes << "\n";
+				coding_length += exon->end - exon->start;
+			}
+		}
+	}
+
+	// simulate fusions between random genes and read-through fusions between neighboring genes
+	vector<event_t> fusions, read_through_events;
+	while (fusions.size() < options.fusions) {
+		const unsigned int gene1 = uniform_int_distribution<unsigned int>(0, genes.size()-1)(random);
+		const unsigned int gene2 = uniform_int_distribution<unsigned int>(0, genes.size()-1)(random);
+		unsigned int exon1, exon2;
+		if (genes[gene1].contig == genes[gene2].contig && abs((int) gene1 - (int) gene2) <= 1 || // neighbors would be read-through fusions
+		    !pick_breakpoint_exons(genes[gene1], genes[gene2], random, exon1, exon2))
+			continue;
+		const string type = (genes[gene1].contig != genes[gene2].contig) ? "translocation" : (gene1 < gene2) ? "deletion" : "duplication";
+		fusions.push_back(make_event(type, genes, gene1, gene2, exon1, exon2));
+	}
+	while (read_through_events.size() < options.read_through_events) {
+		const unsigned int gene1 = uniform_int_distribution<unsigned int>(0, genes.size()-2)(random);
+		const unsigned int gene2 = gene1 + 1;
+		unsigned int exon1, exon2;
+		if (genes[gene1].contig != genes[gene2].contig ||
+		    !pick_breakpoint_exons(genes[gene1], genes[gene2], random, exon1, exon2))
+			continue;
+		read_through_events.push_back(make_event("read-through", genes, gene1, gene2, exon1, exon2));
+	}
+
+	// normal transcripts with skewed expression
+	vector<transcript_t> transcripts(genes.size());
+	vector<double> expression(genes.size());
+	for (unsigned int gene = 0; gene < genes.size(); ++gene) {
+		append_exons(genes[gene], 0, genes[gene].exons.size() - 1, 0, transcripts[gene]);
+		expression[gene] = 1.0 / (1 + (random() % genes.size()));
+	}
+	discrete_distribution<unsigned int> pick_gene(expression.begin(), expression.end());
+
+	// determine number of fragments of each kind, such that the total number of records is approximately as requested
+	const double records_per_fragment = 2 + options.split_read_fraction;
+	const long unsigned int fragments = options.records / records_per_fragment;
+	long unsigned int remaining[4]; // normal, split reads, discordant mates, read-through
+	remaining[1] = llround(fragments * options.split_read_fraction);
+	remaining[2] = llround(fragments * options.discordant_mate_fraction);
+	remaining[3] = llround(fragments * options.read_through_fraction);
+	remaining[0] = fragments - remaining[1] - remaining[2] - remaining[3];
+
+	// write header of BAM file
+	// the header is parsed from a temporary SAM file, because the API to construct headers differs between versions of htslib
+	cout << "Generating " << fragments << " fragments" << endl;
+	const string header_file_path = options.output_directory + "/header.sam";
+	{
+		ofstream header_file(header_file_path);
+		header_file << "@HD\tVN:1.4\tSO:" << (options.sorted ? "coordinate" : "unsorted") << "\n";
+		for (unsigned int contig = 0; contig < CONTIGS; ++contig)
+			header_file << "@SQ\tSN:" << contig_names[contig] << "\tLN:" << assembly[contig].size() << "\n";
+		header_file << "@PG\tID:generate_benchmark_data\tPN:generate_benchmark_data\n";
+	}
+	samFile* header_file = sam_open(header_file_path.c_str(), "r");
+	bam_hdr_t* bam_header = (header_file != NULL) ? sam_hdr_read(header_file) : NULL;
+	if (bam_header == NULL) {
+		cerr << "ERROR: failed to make BAM header." << endl;
+		exit(1);
+	}
+	sam_close(header_file);
+	unlink(header_file_path.c_str());
+	const string bam_file_path = options.output_directory + "/Aligned.out.bam";
+	samFile* bam_file = sam_open(bam_file_path.c_str(), "wb1");
+	if (bam_file == NULL || sam_hdr_write(bam_file, bam_header) < 0) {
+		cerr << "ERROR: failed to open '" << bam_file_path << "' for writing." << endl;
+		exit(1);
+	}
+	bam1_t* bam_record = bam_init1();
+	vector<bam1_t*> sort_buffer;
+	vector<bam1_t*>* sort_buffer_pointer = options.sorted ? &sort_buffer : NULL;
+
+	// write fragments of all kinds in random order
+	long unsigned int records = 0;
+	uniform_int_distribution<int> pick_fragment_length(200, 300);
+	uniform_int_distribution<int> pick_anchor_length(MIN_ANCHOR_LENGTH, READ_LENGTH - MIN_ANCHOR_LENGTH);
+	for (long unsigned int fragment = 0; fragment < fragments; ++fragment) {
+		const long unsigned int remaining_fragments = fragments - fragment;
+		long unsigned int drawn = uniform_int_distribution<long unsigned int>(0, remaining_fragments - 1)(random);
+		unsigned int kind = 0;
+		while (drawn >= remaining[kind]) {
+			drawn -= remaining[kind];
+			++kind;
+		}
+		--remaining[kind];
+
+		const string name = "read" + to_string(static_cast<long long unsigned int>(fragment));
+		int fragment_length = pick_fragment_length(random);
+		if (kind == 0) { // normal fragment
+			const transcript_t& transcript = transcripts[pick_gene(random)];
+			fragment_length = min(fragment_length, transcript_length(transcript));
+			const int fragment_start = uniform_int_distribution<int>(0, transcript_length(transcript) - fragment_length)(random);
+			records += write_fragment(name, transcript, fragment_start, fragment_length, contig_names, assembly, bam_file, bam_header, bam_record, sort_buffer_pointer);
+		} else {
+			event_t& event = (kind == 3) ?
+				read_through_events[uniform_int_distribution<size_t>(0, read_through_events.size()-1)(random)] :
+				fusions[uniform_int_distribution<size_t>(0, fusions.size()-1)(random)];
+			int fragment_start;
+			if (kind == 1 || kind == 3 && random() % 2 == 0) { // one of the mates overlaps the breakpoint
+				const int anchor_length = pick_anchor_length(random);
+				fragment_start = (random() % 2 == 0) ?
+					event.junction - anchor_length : // mate1 overlaps the breakpoint
+					event.junction - anchor_length + READ_LENGTH - fragment_length; // mate2 overlaps the breakpoint
+				++event.split_reads;
+			} else { // the breakpoint is between the mates
+				fragment_length = max(fragment_length, 2 * READ_LENGTH + MIN_ANCHOR_LENGTH);
+				fragment_start = uniform_int_distribution<int>(event.junction - fragment_length + READ_LENGTH, event.junction - READ_LENGTH)(random);
+				++event.discordant_mates;
+			}
+			records += write_fragment(name, event.transcript, fragment_start, fragment_length, contig_names, assembly, bam_file, bam_header, bam_record, sort_buffer_pointer);
+		}
+	}
+	bam_destroy1(bam_record);
+
+	// write records collected for sorting
+	if (options.sorted) {
+		cout << "Sorting " << sort_buffer.size() << " records" << endl;
+		stable_sort(sort_buffer.begin(), sort_buffer.end(), bam_record_position_less);
+		for (auto sorted_record = sort_buffer.begin(); sorted_record != sort_buffer.end(); ++sorted_record) {
+			if (sam_write1(bam_file, bam_header, *sorted_record) < 0) {
+				cerr << "ERROR: failed to write '" << bam_file_path << "'." << endl;
+				exit(1);
+			}
+			bam_destroy1(*sorted_record);
+		}
+		sort_buffer.clear();
+	}
+
+	bam_hdr_destroy(bam_header);
+	if (sam_close(bam_file) < 0) {
+		cerr << "ERROR: failed to write '" << bam_file_path << "'." << endl;
+		exit(1);
+	}
+	if (options.sorted && sam_index_build(bam_file_path.c_str(), 0) < 0) {
+		cerr << "ERROR: failed to index '" << bam_file_path << "'." << endl;
+		exit(1);
+	}
+
+	// write list of simulated events
+	ofstream truth(options.output_directory + "/truth.tsv");
+	truth << "#gene1\tgene2\tbreakpoint1\tbreakpoint2\ttype\tsplit_reads\tdiscordant_mates" << endl;
+	for (unsigned int i = 0; i < fusions.size() + read_through_events.size(); ++i) {
+		const event_t& event = (i < fusions.size()) ? fusions[i] : read_through_events[i - fusions.size()];
+		truth << genes[event.gene1].name << "\t" << genes[event.gene2].name << "\t"
+		      << contig_names[genes[event.gene1].contig] << ":" << event.breakpoint1 << "\t"
+		      << contig_names[genes[event.gene2].contig] << ":" << event.breakpoint2 << "\t"
+		      << event.type << "\t" << event.split_reads << "\t" << event.discordant_mates << endl;
+	}
+
+	cout << "Wrote " << records << " records to '" << bam_file_path << "'" << endl;
+	return 0;
+}
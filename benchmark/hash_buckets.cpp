@@ -0,0 +1,75 @@
+// measures how well the hash function of tuples (see common.hpp) spreads the keys of fusions_t over the buckets
+// for keys from clustered breakpoints (many breakpoints of one gene pair, as is typical for Arriba) and for random keys;
+// the hash function which was used before common.hpp mixed every element into the hash is measured for comparison
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "common.hpp"
+
+using namespace std;
+
+typedef fusions_t::key_type fusion_key_t;
+
+// the former hash function of tuples, which XOR-ed the hashes of the elements, each shifted by 4 bits more than the last
+template <typename tuple_t> struct legacy_tuple_hash_t {
+
+	size_t operator()(const tuple_t& tuple, integral_constant<int, tuple_size<tuple_t>::value>) const {
+		return 0;
+	}
+
+	template<int element = 0> size_t operator()(const tuple_t& tuple, integral_constant<int,element> = integral_constant<int,0>()) const {
+		return hash< typename tuple_element<element,tuple_t>::type >()(get<element>(tuple)) ^ operator()(tuple, integral_constant<int,element+1>()) <<4;
+	}
+};
+
+template <typename hash_t> void measure(const string& description, const vector<fusion_key_t>& keys) {
+	unordered_map<fusion_key_t,unsigned int,hash_t> map;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (auto key = keys.begin(); key != keys.end(); ++key)
+		map[*key]++;
+	unsigned int found = 0;
+	for (auto key = keys.begin(); key != keys.end(); ++key)
+		found += map.count(*key);
+	double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	size_t empty_buckets = 0, longest_chain = 0;
+	for (size_t bucket = 0; bucket < map.bucket_count(); ++bucket) {
+		if (map.bucket_size(bucket) == 0)
+			++empty_buckets;
+		longest_chain = max(longest_chain, map.bucket_size(bucket));
+	}
+	double mean_chain = 0; // average length of the chain a key resides in, i.e., the cost of a lookup
+	for (auto key = map.begin(); key != map.end(); ++key)
+		mean_chain += map.bucket_size(map.bucket(key->first));
+	mean_chain /= map.size();
+
+	cout << description << "\t" << map.size() << "\t" << map.bucket_count() << "\t" << map.load_factor() << "\t"
+	     << (double) empty_buckets / map.bucket_count() << "\t" << longest_chain << "\t" << mean_chain << "\t" << elapsed << endl;
+	if (found != keys.size())
+		cerr << "ERROR: lookup failed" << endl;
+}
+
+int main(int argc, char **argv) {
+	const unsigned int key_count = 800000;
+
+	// breakpoints of a single gene pair in a window of 1000 x 800 bases
+	vector<fusion_key_t> clustered_keys;
+	for (unsigned int i = 0; i < key_count; ++i)
+		clustered_keys.push_back(make_tuple(1, 2, 0, 1, 1000000 + i % 1000, 2000000 + i / 1000, (direction_t) UPSTREAM, (direction_t) DOWNSTREAM));
+
+	// random gene pairs and breakpoints
+	mt19937_64 random(1);
+	vector<fusion_key_t> random_keys;
+	for (unsigned int i = 0; i < key_count; ++i)
+		random_keys.push_back(make_tuple(random() % 60000, random() % 60000, random() % 25, random() % 25, random() % 250000000, random() % 250000000, (direction_t) (random() % 2), (direction_t) (random() % 2)));
+
+	cout << "#keys\thash\tdistinct_keys\tbuckets\tload_factor\tempty_bucket_fraction\tlongest_chain\tmean_chain_per_key\tseconds" << endl;
+	measure< legacy_tuple_hash_t<fusion_key_t> >("clustered\tlegacy", clustered_keys);
+	measure< hash<fusion_key_t> >("clustered\tcurrent", clustered_keys);
+	measure< legacy_tuple_hash_t<fusion_key_t> >("random\tlegacy", random_keys);
+	measure< hash<fusion_key_t> >("random\tcurrent", random_keys);
+	return 0;
+}
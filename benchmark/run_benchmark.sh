@@ -0,0 +1,145 @@
+#!/bin/bash
+
+if [ $# -eq 1 ] && [ "$1" = "-h" ]; then
+	echo "Usage: $(basename $0) [RECORDS ...]" 1>&2
+	echo "Runs Arriba on synthetic data sets of the given sizes (default: 1000000 records) and" 1>&2
+	echo "compares the results and the runtime of each step with the baseline in $(dirname $0)/baseline." 1>&2
+	echo "Every size is run twice: on an unsorted BAM file and on a BAM file which is sorted by coordinate and indexed." 1>&2
+	echo "Each data set is analyzed once more with a different number of threads (1 or 4) to check that the results are the same." 1>&2
+	echo "A data set without a baseline is an error. A baseline must be made with UPDATE_BASELINE=1 on a build known to be good." 1>&2
+	echo "Environment variables: THREADS (default: 1), TOLERANCE (maximum ratio of runtime to baseline, default: 1.2)," 1>&2
+	echo "MIN_SECONDS (steps which take less time in the baseline are not compared, default: 1), UPDATE_BASELINE (set to 1 to overwrite the baseline)," 1>&2
+	echo "ALLOW_MISSING_BASELINE (set to 1 to skip data sets without a baseline instead of failing)" 1>&2
+	exit 1
+fi
+
+# tell bash to abort on error
+set -o pipefail
+set -e -u
+
+# get arguments
+SCALES="${*:-1000000}"
+THREADS="${THREADS-1}"
+TOLERANCE="${TOLERANCE-1.2}"
+MIN_SECONDS="${MIN_SECONDS-1}"
+UPDATE_BASELINE="${UPDATE_BASELINE-0}"
+ALLOW_MISSING_BASELINE="${ALLOW_MISSING_BASELINE-0}"
+
+# find installation directory of arriba
+BASE_DIR=$(dirname "$0")
+ARRIBA="$BASE_DIR/../arriba"
+DATA_DIR="$BASE_DIR/data"
+RESULTS_DIR="$BASE_DIR/results"
+BASELINE_DIR="$BASE_DIR/baseline"
+
+REGRESSIONS=0
+MISSING_BASELINES=0
+# unsorted input is read sequentially, sorted and indexed input is processed contig by contig
+for SCALE in $(for RECORDS in $SCALES; do echo "$RECORDS" "$RECORDS.sorted"; done); do
+
+	# synthetic data is generated only once and reused by subsequent runs
+	if [ ! -e "$DATA_DIR/$SCALE/Aligned.out.bam" ]; then
+		mkdir -p "$DATA_DIR/$SCALE"
+		if [ "${SCALE%.sorted}" != "$SCALE" ]; then
+			"$BASE_DIR/generate_benchmark_data" -o "$DATA_DIR/$SCALE" -n "${SCALE%.sorted}" -c
+		else
+			"$BASE_DIR/generate_benchmark_data" -o "$DATA_DIR/$SCALE" -n "$SCALE"
+		fi
+	fi
+
+	# run arriba with all filters which do not require additional input files
+	mkdir -p "$RESULTS_DIR/$SCALE"
+	"$ARRIBA" \
+		-x "$DATA_DIR/$SCALE/Aligned.out.bam" \
+		-a "$DATA_DIR/$SCALE/assembly.fa" -g "$DATA_DIR/$SCALE/annotation.gtf" -f blacklist \
+		-o "$RESULTS_DIR/$SCALE/fusions.tsv" -O "$RESULTS_DIR/$SCALE/fusions.discarded.tsv" \
+		-t "$RESULTS_DIR/$SCALE/metrics.tsv" -@ "$THREADS" > "$RESULTS_DIR/$SCALE/arriba.log"
+
+	# the results must not depend on the number of threads
+	if [ "$THREADS" = "4" ]; then OTHER_THREADS=1; else OTHER_THREADS=4; fi
+	"$ARRIBA" \
+		-x "$DATA_DIR/$SCALE/Aligned.out.bam" \
+		-a "$DATA_DIR/$SCALE/assembly.fa" -g "$DATA_DIR/$SCALE/annotation.gtf" -f blacklist \
+		-o "$RESULTS_DIR/$SCALE/fusions.threads$OTHER_THREADS.tsv" -O "$RESULTS_DIR/$SCALE/fusions.discarded.threads$OTHER_THREADS.tsv" \
+		-@ "$OTHER_THREADS" > "$RESULTS_DIR/$SCALE/arriba.threads$OTHER_THREADS.log"
+	for OUTPUT in fusions fusions.discarded; do
+		if ! cmp -s "$RESULTS_DIR/$SCALE/$OUTPUT.tsv" "$RESULTS_DIR/$SCALE/$OUTPUT.threads$OTHER_THREADS.tsv"; then
+			echo "[$SCALE] REGRESSION: $OUTPUT differ between $THREADS and $OTHER_THREADS threads (diff '$RESULTS_DIR/$SCALE/$OUTPUT.tsv' '$RESULTS_DIR/$SCALE/$OUTPUT.threads$OTHER_THREADS.tsv')"
+			REGRESSIONS=$((REGRESSIONS+1))
+		fi
+	done
+
+	# report how many of the simulated events were found
+	awk -F '\t' '
+		FILENAME == ARGV[1] && !/^#/ { simulated[$1"\t"$2] = $5 }
+		FILENAME == ARGV[2] && !/^#/ { found[$1"\t"$2] = 1 }
+		END {
+			for (pair in simulated) { total[simulated[pair]]++; if (pair in found) detected[simulated[pair]]++ }
+			for (type in total) printf "%s: found %d of %d simulated events\n", type, detected[type], total[type]
+		}
+	' "$DATA_DIR/$SCALE/truth.tsv" "$RESULTS_DIR/$SCALE/fusions.tsv" | sed -e "s/^/[$SCALE] /"
+
+	if [ "$UPDATE_BASELINE" = "1" ]; then
+		mkdir -p "$BASELINE_DIR/$SCALE"
+		cp "$RESULTS_DIR/$SCALE/fusions.tsv" "$RESULTS_DIR/$SCALE/metrics.tsv" "$BASELINE_DIR/$SCALE/"
+		echo "[$SCALE] baseline written to '$BASELINE_DIR/$SCALE'"
+		continue
+	fi
+
+	# the baseline is never made implicitly, since a build with a regression would otherwise become its own reference
+	if [ ! -e "$BASELINE_DIR/$SCALE/fusions.tsv" ] || [ ! -e "$BASELINE_DIR/$SCALE/metrics.tsv" ]; then
+		if [ "$ALLOW_MISSING_BASELINE" = "1" ]; then
+			echo "[$SCALE] SKIPPED: no baseline in '$BASELINE_DIR/$SCALE'"
+		else
+			echo "[$SCALE] ERROR: no baseline in '$BASELINE_DIR/$SCALE'; run with UPDATE_BASELINE=1 on a build known to be good to make one or set ALLOW_MISSING_BASELINE=1 to skip it"
+		fi
+		MISSING_BASELINES=$((MISSING_BASELINES+1))
+		continue
+	fi
+
+	# the results must not change
+	if ! cmp -s "$BASELINE_DIR/$SCALE/fusions.tsv" "$RESULTS_DIR/$SCALE/fusions.tsv"; then
+		echo "[$SCALE] REGRESSION: fusions differ from baseline (diff '$BASELINE_DIR/$SCALE/fusions.tsv' '$RESULTS_DIR/$SCALE/fusions.tsv')"
+		REGRESSIONS=$((REGRESSIONS+1))
+	fi
+
+	# compare wall time of each step with the baseline
+	# steps may occur more than once (e.g., select_best), so they are matched by name and occurrence
+	if ! awk -F '\t' -v tolerance="$TOLERANCE" -v min_seconds="$MIN_SECONDS" -v scale="$SCALE" '
+		/^#/ || $2 == "." { next }
+		{ key = $1 "#" (++occurrence[FILENAME, $1]) }
+		FILENAME == ARGV[1] { baseline[key] = $2; baseline_total += $2; next }
+		{
+			total += $2
+			if (key in baseline) {
+				printf "[%s] %-30s %10.2fs (baseline %.2fs)\n", scale, $1, $2, baseline[key]
+				if (baseline[key] >= min_seconds && $2 > baseline[key] * tolerance) {
+					printf "[%s] REGRESSION: step %s is %.0f%% slower than baseline\n", scale, $1, ($2 / baseline[key] - 1) * 100
+					regressions++
+				}
+			}
+		}
+		END {
+			printf "[%s] %-30s %10.2fs (baseline %.2fs)\n", scale, "total", total, baseline_total
+			if (baseline_total >= min_seconds && total > baseline_total * tolerance) {
+				printf "[%s] REGRESSION: total runtime is %.0f%% slower than baseline\n", scale, (total / baseline_total - 1) * 100
+				regressions++
+			}
+			exit (regressions > 0)
+		}
+	' "$BASELINE_DIR/$SCALE/metrics.tsv" "$RESULTS_DIR/$SCALE/metrics.tsv"; then
+		REGRESSIONS=$((REGRESSIONS+1))
+	fi
+
+done
+
+if [ $MISSING_BASELINES -gt 0 ]; then
+	echo "$MISSING_BASELINES data sets were not compared, because they have no baseline" 1>&2
+	if [ "$ALLOW_MISSING_BASELINE" != "1" ]; then
+		exit 1
+	fi
+fi
+if [ $REGRESSIONS -gt 0 ]; then
+	echo "Performance or result regressions found" 1>&2
+	exit 1
+fi
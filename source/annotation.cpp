@@ -9,6 +9,7 @@
 #include <set>
 #include <tuple>
 #include <unordered_map>
+#include <unordered_set>
 #include "sam.h"
 #include "common.hpp"
 #include "annotation.hpp"
@@ -169,7 +170,7 @@ struct coding_region_t {
 	string transcript_id;
 };
 
-void read_annotation_gtf(const string& filename, const string& gtf_features_string, contigs_t& contigs, gene_annotation_t& gene_annotation, transcript_annotation_t& transcript_annotation, exon_annotation_t& exon_annotation, unordered_map<string,gene_t>& gene_names) {
+void read_annotation_gtf(const string& filename, const string& gtf_features_string, contigs_t& contigs, gene_annotation_t& gene_annotation, transcript_annotation_t& transcript_annotation, exon_annotation_t& exon_annotation, unordered_map<string,gene_t>& gene_names, vector<string>& contigs_in_gtf) {
 
 	gtf_features_t gtf_features;
 	parse_gtf_features(gtf_features_string, gtf_features);
@@ -181,6 +182,10 @@ void read_annotation_gtf(const string& filename, const string& gtf_features_stri
 
 	gene_set_t bogus_genes; // genes with bogus annotation are ignored
 
+	// remember the order in which contigs appear in the GTF file, so that the annotation cache can assign the same contig IDs
+	unordered_set<string> seen_contigs;
+	string previous_contig;
+
 	stringstream gtf_file;
 	autodecompress_file(filename, gtf_file);
 	string line;
@@ -212,6 +217,11 @@ void read_annotation_gtf(const string& filename, const string& gtf_features_stri
 
 			// convert string representation of contig to numeric ID
 			contig = removeChr(contig);
+			if (contig != previous_contig) {
+				if (seen_contigs.insert(contig).second)
+					contigs_in_gtf.push_back(contig);
+				previous_contig = contig;
+			}
 			pair<contigs_t::iterator,bool> find_contig_by_name = contigs.insert(pair<string,contig_t>(contig, contigs.size())); // this adds a new contig only if it does not yet exist
 
 			// make annotation record
@@ -360,7 +370,7 @@ void read_annotation_gtf(const string& filename, const string& gtf_features_stri
 
 }
 
-bool filter_exons_near_splice_site(const gene_t gene, const direction_t direction, const position_t breakpoint, const exon_set_t& exons_near_splice_site) {
+bool filter_exons_near_splice_site(const gene_t gene, const direction_t direction, const position_t breakpoint, const exon_view_t& exons_near_splice_site) {
 	// return only exons which
 	// - belong to given gene
 	// - have a boundary within MAX_SPLICE_SITE_DISTANCE from the breakpoint
@@ -368,7 +378,7 @@ bool filter_exons_near_splice_site(const gene_t gene, const direction_t directio
 	// - unless:
 	//   - the transcript has only one exon
 	//   - the gene misses a start/stop codon (=> indicates incomplete annotation)
-	for (exon_set_t::const_iterator exon = exons_near_splice_site.begin(); exon != exons_near_splice_site.end(); ++exon)
+	for (exon_view_t::const_iterator exon = exons_near_splice_site.begin(); exon != exons_near_splice_site.end(); ++exon)
 		if ((**exon).gene == gene)
 			if (direction == UPSTREAM &&
 			    abs((**exon).start - breakpoint) <= MAX_SPLICE_SITE_DISTANCE &&
@@ -539,17 +549,6 @@ void annotate_alignments(mates_t& mates, const exon_annotation_index_t& exon_ann
 }
 
 // when a read overlaps with multiple genes, this function returns the boundaries of the biggest one
-void get_boundaries_of_biggest_gene(gene_set_t& genes, position_t& start, position_t& end) {
-	start = -1;
-	end = -1;
-	for (gene_set_t::iterator gene = genes.begin(); gene != genes.end(); ++gene) {
-		if (start == -1 || start > (**gene).start)
-			start = (**gene).start;
-		if (end == -1 || end < (**gene).end)
-			end = (**gene).end;
-	}
-}
-
 // get the distance between two positions after splicing (i.e., ignoring introns)
 int get_spliced_distance(const contig_t contig, position_t position1, position_t position2, direction_t direction1, direction_t direction2, const gene_t gene, const exon_annotation_index_t& exon_annotation_index) {
 
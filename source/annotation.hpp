@@ -27,19 +27,21 @@ bool parse_gtf_features(string gtf_features_string, gtf_features_t& gtf_features
 string removeChr(string contig);
 string addChr(string contig);
 
-void read_annotation_gtf(const string& filename, const string& gtf_features_string, contigs_t& contigs, gene_annotation_t& gene_annotation, transcript_annotation_t& transcript_annotation, exon_annotation_t& exon_annotation, unordered_map<string,gene_t>& gene_names);
+void read_annotation_gtf(const string& filename, const string& gtf_features_string, contigs_t& contigs, gene_annotation_t& gene_annotation, transcript_annotation_t& transcript_annotation, exon_annotation_t& exon_annotation, unordered_map<string,gene_t>& gene_names, vector<string>& contigs_in_gtf);
 
-template <class T> void make_annotation_index(annotation_t<T>& annotation, annotation_index_t<T*>& annotation_index, const contigs_t& contigs);
+template <class T> void make_annotation_index(annotation_t<T>& annotation, annotation_index_t<T*>& annotation_index);
 
 bool is_breakpoint_spliced(const gene_t gene, const direction_t direction, const position_t breakpoint, const exon_annotation_index_t& exon_annotation_index);
 
-template <class T> void combine_annotations(const annotation_set_t<T>& genes1, const annotation_set_t<T>& genes2, annotation_set_t<T>& combined, bool make_union = true);
+template <class S, class T> void combine_annotations(const S& genes1, const S& genes2, annotation_set_t<T>& combined, bool make_union = true);
+
+template <class T> annotation_view_t<T> get_annotation_at_position(const contig_t contig, const position_t position, const annotation_index_t<T>& annotation_index);
 
 template <class T> void get_annotation_by_coordinate(const contig_t contig, const position_t start, const position_t end, annotation_set_t<T>& annotation_set, const annotation_index_t<T>& annotation_index);
 
 void annotate_alignments(mates_t& mates, const exon_annotation_index_t& exon_annotation_index);
 
-void get_boundaries_of_biggest_gene(gene_set_t& genes, position_t& start, position_t& end);
+template <class S> void get_boundaries_of_biggest_gene(const S& genes, position_t& start, position_t& end);
 
 int get_spliced_distance(const contig_t contig, const position_t position1, const position_t position2, const direction_t direction1, const direction_t direction2, const gene_t gene, const exon_annotation_index_t& exon_annotation_index);
 
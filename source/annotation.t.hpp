@@ -24,27 +24,51 @@ using namespace std;
 // - chr1:13,001-20,000 gene1
 template <class T> void make_annotation_index(annotation_t<T>& annotation, annotation_index_t<T*>& annotation_index) {
 	annotation_index.resize(annotation.size()); // create a contig_annotation_index_t for each contig
+
+	// group features by contig
+	vector< vector<T*> > features_by_contig(annotation_index.size());
 	for (typename annotation_t<T>::iterator feature = annotation.begin(); feature != annotation.end(); ++feature) {
+		if ((unsigned int) feature->contig >= features_by_contig.size()) {
+			annotation_index.resize(feature->contig + 1);
+			features_by_contig.resize(feature->contig + 1);
+		}
+		features_by_contig[feature->contig].push_back(&(*feature));
+	}
+
+	for (contig_t contig = 0; (unsigned int) contig < features_by_contig.size(); ++contig) {
+		vector<T*>& features = features_by_contig[contig];
+		if (features.empty())
+			continue;
 
-		typename contig_annotation_index_t<T*>::const_iterator overlapping_features = annotation_index[feature->contig].lower_bound(feature->end);
-		if (overlapping_features == annotation_index[feature->contig].end())
-			annotation_index[feature->contig][feature->end]; // this creates an empty gene set, if it does not exist yet
-		else
-			annotation_index[feature->contig][feature->end] = overlapping_features->second;
-
-		overlapping_features = annotation_index[feature->contig].lower_bound(feature->start-1);
-		if (overlapping_features == annotation_index[feature->contig].end())
-			annotation_index[feature->contig][feature->start-1]; // this creates an empty gene set, if it does not exist yet
-		else
-			annotation_index[feature->contig][feature->start-1] = overlapping_features->second;
-
-		// add the gene to all gene sets between start and end of the gene
-		for (typename contig_annotation_index_t<T*>::iterator annotation_set = annotation_index[feature->contig].lower_bound(feature->end); annotation_set->first >= feature->start; --annotation_set)
-			annotation_set->second.insert(&(*feature));
+		// the boundaries of the regions are the ends of the features and the positions before their starts
+		vector<position_t> boundaries;
+		boundaries.reserve(features.size() * 2);
+		for (typename vector<T*>::iterator feature = features.begin(); feature != features.end(); ++feature) {
+			boundaries.push_back((**feature).start - 1);
+			boundaries.push_back((**feature).end);
+		}
+		sort(boundaries.begin(), boundaries.end());
+		boundaries.erase(unique(boundaries.begin(), boundaries.end()), boundaries.end());
+
+		// sweep over the boundaries and keep track of the features overlapping the current region
+		sort(features.begin(), features.end(), [](const T* x, const T* y) { return x->start < y->start; });
+		typename vector<T*>::iterator next_feature = features.begin();
+		annotation_set_t<T*> overlapping_features;
+		for (vector<position_t>::iterator boundary = boundaries.begin(); boundary != boundaries.end(); ++boundary) {
+			for (; next_feature != features.end() && (**next_feature).start <= *boundary; ++next_feature)
+				overlapping_features.insert(*next_feature);
+			for (typename annotation_set_t<T*>::iterator feature = overlapping_features.begin(); feature != overlapping_features.end();)
+				if ((**feature).end < *boundary)
+					feature = overlapping_features.erase(feature);
+				else
+					++feature;
+			annotation_index[contig].append_region(*boundary, overlapping_features.begin(), overlapping_features.end());
+		}
+		annotation_index[contig].make_views();
 	}
 }
 
-template <class T> void combine_annotations(const annotation_set_t<T>& genes1, const annotation_set_t<T>& genes2, annotation_set_t<T>& combined, bool make_union) {
+template <class S, class T> void combine_annotations(const S& genes1, const S& genes2, annotation_set_t<T>& combined, bool make_union) {
 	// when the two ends of a read map to different genes, the mapping is ambiguous
 	// in this case, we try to resolve the ambiguity by taking the gene that both - start and end - overlap with
 	set_intersection(genes1.begin(), genes1.end(), genes2.begin(), genes2.end(), back_inserter(combined));
@@ -52,6 +76,17 @@ template <class T> void combine_annotations(const annotation_set_t<T>& genes1, c
 		set_union(genes1.begin(), genes1.end(), genes2.begin(), genes2.end(), back_inserter(combined));
 }
 
+// get the features overlapping the given position without copying them
+template <class T> annotation_view_t<T> get_annotation_at_position(const contig_t contig, const position_t position, const annotation_index_t<T>& annotation_index) {
+	static const vector<T> no_features;
+	if ((unsigned int) contig < annotation_index.size()) {
+		typename contig_annotation_index_t<T>::const_iterator region = annotation_index[contig].lower_bound(position);
+		if (region != annotation_index[contig].end())
+			return region->second;
+	}
+	return annotation_view_t<T>(no_features.begin(), no_features.end()); // return empty set
+}
+
 template <class T> void get_annotation_by_coordinate(const contig_t contig, position_t start, position_t end, annotation_set_t<T>& annotation_set, const annotation_index_t<T>& annotation_index) {
 	if ((unsigned int) contig >= annotation_index.size()) {
 		annotation_set.clear(); // return empty set
@@ -61,11 +96,8 @@ template <class T> void get_annotation_by_coordinate(const contig_t contig, posi
 	if (start == end) {
 
 		// get all features at position
-		typename contig_annotation_index_t<T>::const_iterator position = annotation_index[contig].lower_bound(start);
-		if (position != annotation_index[contig].end())
-			annotation_set = position->second;
-		else
-			annotation_set.clear(); // return empty set
+		annotation_view_t<T> features_at_position = get_annotation_at_position(contig, start, annotation_index);
+		annotation_set.assign(features_at_position.begin(), features_at_position.end());
 
 	} else {
 		if (start > end)
@@ -75,7 +107,7 @@ template <class T> void get_annotation_by_coordinate(const contig_t contig, posi
 		annotation_set_t<T> result_start;
 		typename contig_annotation_index_t<T>::const_iterator position_start = annotation_index[contig].lower_bound(start);
 		if (position_start != annotation_index[contig].end()) {
-			result_start = position_start->second;
+			result_start.assign(position_start->second.begin(), position_start->second.end());
 			if (position_start->first - start <= 2) {
 				++position_start;
 				if (position_start != annotation_index[contig].end())
@@ -87,7 +119,7 @@ template <class T> void get_annotation_by_coordinate(const contig_t contig, posi
 		annotation_set_t<T> result_end;
 		typename contig_annotation_index_t<T>::const_iterator position_end = annotation_index[contig].lower_bound(end);
 		if (position_end != annotation_index[contig].end())
-			result_end = position_end->second;
+			result_end.assign(position_end->second.begin(), position_end->second.end());
 		if (position_end != annotation_index[contig].begin() && annotation_index[contig].size() > 0) {
 			--position_end;
 			if (end - position_end->first <= 2)
@@ -99,3 +131,15 @@ template <class T> void get_annotation_by_coordinate(const contig_t contig, posi
 	}
 }
 
+// find the start of the leftmost and the end of the rightmost of the given genes
+template <class S> void get_boundaries_of_biggest_gene(const S& genes, position_t& start, position_t& end) {
+	start = -1;
+	end = -1;
+	for (typename S::const_iterator gene = genes.begin(); gene != genes.end(); ++gene) {
+		if (start == -1 || start > (**gene).start)
+			start = (**gene).start;
+		if (end == -1 || end < (**gene).end)
+			end = (**gene).end;
+	}
+}
+
@@ -0,0 +1,307 @@
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+#include <zlib.h>
+#include "common.hpp"
+#include "annotation_cache.hpp"
+
+using namespace std;
+
+const char ANNOTATION_CACHE_MAGIC[8] = { 'A', 'R', 'R', 'I', 'B', 'A', 'G', 'C' };
+const uint32_t NO_EXON = UINT32_MAX;
+
+// the cache is only valid for the GTF file it was made from,
+// so it stores the size and the checksum of the (possibly compressed) GTF file
+bool get_gtf_checksum(const string& gtf_file, uint64_t& size, uint32_t& checksum) {
+	ifstream gtf(gtf_file.c_str(), ios::binary);
+	if (!gtf.is_open())
+		return false;
+	vector<char> buffer(1024*1024);
+	size = 0;
+	checksum = crc32(0L, Z_NULL, 0);
+	while (gtf.read(buffer.data(), buffer.size()) || gtf.gcount() > 0) {
+		checksum = crc32(checksum, (const Bytef*) buffer.data(), gtf.gcount());
+		size += gtf.gcount();
+	}
+	return true;
+}
+
+template <class T> void write_value(ofstream& cache, const T value) {
+	cache.write((const char*) &value, sizeof(T));
+}
+
+void write_string(ofstream& cache, const string& value) {
+	write_value<uint32_t>(cache, value.size());
+	cache.write(value.data(), value.size());
+}
+
+// reads values from a memory-mapped cache file and keeps track of whether the end of the file was reached prematurely
+class cache_reader_t {
+	public:
+		cache_reader_t(const char* data, const size_t size): position(data), end(data + size), truncated(false) {};
+		template <class T> T read_value() {
+			T value = T();
+			if ((size_t) (end - position) < sizeof(T)) {
+				truncated = true;
+			} else {
+				memcpy(&value, position, sizeof(T));
+				position += sizeof(T);
+			}
+			return value;
+		};
+		string read_string() {
+			uint32_t length = read_value<uint32_t>();
+			if (truncated || (size_t) (end - position) < length) {
+				truncated = true;
+				return "";
+			}
+			string value(position, length);
+			position += length;
+			return value;
+		};
+		// reads the number of records of a list, which is implausible if the rest of the file cannot hold that many records
+		uint32_t read_count(const size_t min_record_size) {
+			uint32_t count = read_value<uint32_t>();
+			if (!truncated && (size_t) (end - position) / min_record_size < count) {
+				truncated = true;
+				count = 0;
+			}
+			return count;
+		};
+		bool is_truncated() const { return truncated; };
+	private:
+		const char* position;
+		const char* end;
+		bool truncated;
+};
+
+// returns false, if the cache does not exist or if it was made from a different GTF file or with different GTF features
+// a corrupt cache is rejected with a warning, so that it is made anew from the GTF file
+bool load_annotation_cache(const string& cache_file, const string& gtf_file, const string& gtf_features, contigs_t& contigs, gene_annotation_t& gene_annotation, transcript_annotation_t& transcript_annotation, exon_annotation_t& exon_annotation, unordered_map<string,gene_t>& gene_names) {
+
+	// map cache file into memory
+	int file_descriptor = open(cache_file.c_str(), O_RDONLY);
+	if (file_descriptor == -1)
+		return false;
+	struct stat file_status;
+	if (fstat(file_descriptor, &file_status) != 0 || file_status.st_size < (off_t) sizeof(ANNOTATION_CACHE_MAGIC)) {
+		close(file_descriptor);
+		return false;
+	}
+	void* mapped_file = mmap(NULL, file_status.st_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+	close(file_descriptor);
+	if (mapped_file == MAP_FAILED)
+		return false;
+	cache_reader_t cache((const char*) mapped_file, file_status.st_size);
+
+	// check if the cache is compatible with the given input
+	bool compatible = memcmp(mapped_file, ANNOTATION_CACHE_MAGIC, sizeof(ANNOTATION_CACHE_MAGIC)) == 0;
+	if (compatible) {
+		for (unsigned int i = 0; i < sizeof(ANNOTATION_CACHE_MAGIC); ++i)
+			cache.read_value<char>();
+		compatible = cache.read_value<uint32_t>() == ANNOTATION_CACHE_VERSION;
+	}
+	if (compatible) {
+		uint64_t gtf_size;
+		uint32_t gtf_checksum;
+		if (!get_gtf_checksum(gtf_file, gtf_size, gtf_checksum)) {
+			cerr << "ERROR: failed to open GTF file '" << gtf_file << "'" << endl;
+			exit(1);
+		}
+		compatible = cache.read_value<uint64_t>() == gtf_size &&
+		             cache.read_value<uint32_t>() == gtf_checksum &&
+		             cache.read_string() == gtf_features &&
+		             !cache.is_truncated();
+	}
+	if (!compatible) {
+		munmap(mapped_file, file_status.st_size);
+		return false;
+	}
+
+	// the annotation is loaded into separate containers, which are only handed over to the caller when the cache is intact
+	// pointers remain valid when the lists are swapped
+	contigs_t loaded_contigs = contigs;
+	gene_annotation_t loaded_gene_annotation;
+	transcript_annotation_t loaded_transcript_annotation;
+	exon_annotation_t loaded_exon_annotation;
+	unordered_map<string,gene_t> loaded_gene_names;
+	bool corrupt = false; // an index into one of the lists is out of range
+
+	// assign IDs to contigs in the same order as when parsing the GTF file
+	vector<contig_t> contig_ids(cache.read_count(sizeof(uint32_t)/*name*/));
+	for (unsigned int i = 0; i < contig_ids.size(); ++i)
+		contig_ids[i] = loaded_contigs.insert(pair<string,contig_t>(cache.read_string(), loaded_contigs.size())).first->second;
+
+	// load transcripts
+	vector<transcript_t> transcripts(cache.read_count(3 * sizeof(uint32_t)/*id, start, end*/));
+	for (unsigned int i = 0; i < transcripts.size() && !cache.is_truncated(); ++i) {
+		transcript_annotation_record_t transcript;
+		transcript.id = cache.read_value<uint32_t>();
+		transcript.start = cache.read_value<int32_t>();
+		transcript.end = cache.read_value<int32_t>();
+		loaded_transcript_annotation.push_back(transcript);
+		transcripts[i] = &(*loaded_transcript_annotation.rbegin());
+	}
+
+	// load genes
+	vector<gene_t> genes(cache.read_count(6 * sizeof(uint32_t)/*contig, start, end, id, name, exonic length*/ + 3 * sizeof(uint8_t)/*strand, flags*/));
+	for (unsigned int i = 0; i < genes.size() && !cache.is_truncated() && !corrupt; ++i) {
+		gene_annotation_record_t gene;
+		const uint32_t contig_index = cache.read_value<uint32_t>();
+		corrupt = contig_index >= contig_ids.size();
+		gene.contig = corrupt ? 0 : contig_ids[contig_index];
+		gene.start = cache.read_value<int32_t>();
+		gene.end = cache.read_value<int32_t>();
+		gene.strand = cache.read_value<uint8_t>();
+		gene.id = cache.read_value<uint32_t>();
+		gene.name = cache.read_string();
+		gene.exonic_length = cache.read_value<int32_t>();
+		gene.is_dummy = cache.read_value<uint8_t>();
+		gene.is_protein_coding = cache.read_value<uint8_t>();
+		loaded_gene_annotation.push_back(gene);
+		genes[i] = &(*loaded_gene_annotation.rbegin());
+		loaded_gene_names[gene.name] = genes[i];
+	}
+
+	// load exons, the links to neighboring exons are resolved once all exons have been loaded
+	vector<exon_t> exons(cache.read_count(9 * sizeof(uint32_t)/*contig, start, end, gene, transcript, coding region, neighbors*/ + sizeof(uint8_t)/*strand*/));
+	vector< pair<uint32_t,uint32_t> > neighboring_exons(exons.size());
+	for (unsigned int i = 0; i < exons.size() && !cache.is_truncated() && !corrupt; ++i) {
+		exon_annotation_record_t exon;
+		const uint32_t contig_index = cache.read_value<uint32_t>();
+		exon.start = cache.read_value<int32_t>();
+		exon.end = cache.read_value<int32_t>();
+		exon.strand = cache.read_value<uint8_t>();
+		const uint32_t gene_index = cache.read_value<uint32_t>();
+		const uint32_t transcript_index = cache.read_value<uint32_t>();
+		exon.coding_region_start = cache.read_value<int32_t>();
+		exon.coding_region_end = cache.read_value<int32_t>();
+		neighboring_exons[i].first = cache.read_value<uint32_t>();
+		neighboring_exons[i].second = cache.read_value<uint32_t>();
+		corrupt = contig_index >= contig_ids.size() || gene_index >= genes.size() || transcript_index >= transcripts.size() ||
+		          neighboring_exons[i].first != NO_EXON && neighboring_exons[i].first >= exons.size() ||
+		          neighboring_exons[i].second != NO_EXON && neighboring_exons[i].second >= exons.size();
+		if (corrupt)
+			break;
+		exon.contig = contig_ids[contig_index];
+		exon.gene = genes[gene_index];
+		exon.transcript = transcripts[transcript_index];
+		loaded_exon_annotation.push_back(exon);
+		exons[i] = &(*loaded_exon_annotation.rbegin());
+	}
+	munmap(mapped_file, file_status.st_size);
+	if (cache.is_truncated() || corrupt) {
+		cerr << "WARNING: annotation cache '" << cache_file << "' is " << (corrupt ? "corrupt" : "truncated") << ", it is made anew from the GTF file" << endl;
+		return false;
+	}
+	for (unsigned int i = 0; i < exons.size(); ++i) {
+		exons[i]->previous_exon = (neighboring_exons[i].first == NO_EXON) ? NULL : exons[neighboring_exons[i].first];
+		exons[i]->next_exon = (neighboring_exons[i].second == NO_EXON) ? NULL : exons[neighboring_exons[i].second];
+	}
+
+	contigs.swap(loaded_contigs);
+	gene_annotation.swap(loaded_gene_annotation);
+	transcript_annotation.swap(loaded_transcript_annotation);
+	exon_annotation.swap(loaded_exon_annotation);
+	gene_names.swap(loaded_gene_names);
+	return true;
+}
+
+void save_annotation_cache(const string& cache_file, const string& gtf_file, const string& gtf_features, const vector<string>& contigs_in_gtf, const contigs_t& contigs, const gene_annotation_t& gene_annotation, const transcript_annotation_t& transcript_annotation, const exon_annotation_t& exon_annotation) {
+
+	// write to temporary file first and rename it when done, so that concurrent runs never see an incomplete cache
+	const string temporary_file = cache_file + ".tmp" + to_string(static_cast<long long int>(getpid()));
+	ofstream cache(temporary_file.c_str(), ios::binary | ios::trunc);
+	if (!cache.is_open()) {
+		cerr << "WARNING: failed to open annotation cache '" << cache_file << "' for writing, annotation is not cached" << endl;
+		return;
+	}
+
+	// header
+	uint64_t gtf_size;
+	uint32_t gtf_checksum;
+	if (!get_gtf_checksum(gtf_file, gtf_size, gtf_checksum)) {
+		cerr << "WARNING: failed to open GTF file '" << gtf_file << "', annotation is not cached" << endl;
+		cache.close();
+		unlink(temporary_file.c_str());
+		return;
+	}
+	cache.write(ANNOTATION_CACHE_MAGIC, sizeof(ANNOTATION_CACHE_MAGIC));
+	write_value<uint32_t>(cache, ANNOTATION_CACHE_VERSION);
+	write_value<uint64_t>(cache, gtf_size);
+	write_value<uint32_t>(cache, gtf_checksum);
+	write_string(cache, gtf_features);
+
+	// contig names in the order of their appearance in the GTF file
+	unordered_map<contig_t,uint32_t> contig_indices;
+	write_value<uint32_t>(cache, contigs_in_gtf.size());
+	for (unsigned int i = 0; i < contigs_in_gtf.size(); ++i) {
+		write_string(cache, contigs_in_gtf[i]);
+		contig_indices[contigs.at(contigs_in_gtf[i])] = i;
+	}
+
+	// pointers are stored as indices into the respective lists
+	unordered_map<transcript_t,uint32_t> transcript_indices;
+	write_value<uint32_t>(cache, transcript_annotation.size());
+	for (transcript_annotation_t::const_iterator transcript = transcript_annotation.begin(); transcript != transcript_annotation.end(); ++transcript) {
+		const uint32_t index = transcript_indices.size();
+		transcript_indices[const_cast<transcript_t>(&(*transcript))] = index;
+		write_value<uint32_t>(cache, transcript->id);
+		write_value<int32_t>(cache, transcript->start);
+		write_value<int32_t>(cache, transcript->end);
+	}
+
+	unordered_map<gene_t,uint32_t> gene_indices;
+	write_value<uint32_t>(cache, gene_annotation.size());
+	for (gene_annotation_t::const_iterator gene = gene_annotation.begin(); gene != gene_annotation.end(); ++gene) {
+		const uint32_t index = gene_indices.size();
+		gene_indices[const_cast<gene_t>(&(*gene))] = index;
+		write_value<uint32_t>(cache, contig_indices.at(gene->contig));
+		write_value<int32_t>(cache, gene->start);
+		write_value<int32_t>(cache, gene->end);
+		write_value<uint8_t>(cache, gene->strand);
+		write_value<uint32_t>(cache, gene->id);
+		write_string(cache, gene->name);
+		write_value<int32_t>(cache, gene->exonic_length);
+		write_value<uint8_t>(cache, gene->is_dummy);
+		write_value<uint8_t>(cache, gene->is_protein_coding);
+	}
+
+	unordered_map<exon_t,uint32_t> exon_indices;
+	for (exon_annotation_t::const_iterator exon = exon_annotation.begin(); exon != exon_annotation.end(); ++exon) {
+		const uint32_t index = exon_indices.size();
+		exon_indices[const_cast<exon_t>(&(*exon))] = index;
+	}
+	auto get_exon_index = [&](const exon_t exon) {
+		unordered_map<exon_t,uint32_t>::const_iterator exon_index = exon_indices.find(exon);
+		return (exon_index == exon_indices.end()) ? NO_EXON : exon_index->second;
+	};
+	write_value<uint32_t>(cache, exon_annotation.size());
+	for (exon_annotation_t::const_iterator exon = exon_annotation.begin(); exon != exon_annotation.end(); ++exon) {
+		write_value<uint32_t>(cache, contig_indices.at(exon->contig));
+		write_value<int32_t>(cache, exon->start);
+		write_value<int32_t>(cache, exon->end);
+		write_value<uint8_t>(cache, exon->strand);
+		write_value<uint32_t>(cache, gene_indices.at(exon->gene));
+		write_value<uint32_t>(cache, transcript_indices.at(exon->transcript));
+		write_value<int32_t>(cache, exon->coding_region_start);
+		write_value<int32_t>(cache, exon->coding_region_end);
+		write_value<uint32_t>(cache, get_exon_index(exon->previous_exon));
+		write_value<uint32_t>(cache, get_exon_index(exon->next_exon));
+	}
+
+	cache.close();
+	if (cache.fail() || rename(temporary_file.c_str(), cache_file.c_str()) != 0) {
+		cerr << "WARNING: failed to write annotation cache '" << cache_file << "', annotation is not cached" << endl;
+		unlink(temporary_file.c_str());
+	}
+}
+
@@ -0,0 +1,18 @@
+#ifndef _ANNOTATION_CACHE_H
+#define _ANNOTATION_CACHE_H 1
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "common.hpp"
+
+using namespace std;
+
+// increment whenever the layout of the cache file changes
+const unsigned int ANNOTATION_CACHE_VERSION = 1;
+
+bool load_annotation_cache(const string& cache_file, const string& gtf_file, const string& gtf_features, contigs_t& contigs, gene_annotation_t& gene_annotation, transcript_annotation_t& transcript_annotation, exon_annotation_t& exon_annotation, unordered_map<string,gene_t>& gene_names);
+
+void save_annotation_cache(const string& cache_file, const string& gtf_file, const string& gtf_features, const vector<string>& contigs_in_gtf, const contigs_t& contigs, const gene_annotation_t& gene_annotation, const transcript_annotation_t& transcript_annotation, const exon_annotation_t& exon_annotation);
+
+#endif /* _ANNOTATION_CACHE_H */
@@ -9,8 +9,10 @@
 #include <vector>
 #include "common.hpp"
 #include "annotation.hpp"
+#include "annotation_cache.hpp"
 #include "assembly.hpp"
 #include "options.hpp"
+#include "metrics.hpp"
 #include "read_stats.hpp"
 #include "read_chimeric_alignments.hpp"
 #include "filter_multi_mappers.hpp"
@@ -25,6 +27,7 @@
 #include "filter_hairpin.hpp"
 #include "filter_mismatches.hpp"
 #include "filter_low_entropy.hpp"
+#include "filter_chain.hpp"
 #include "fusions.hpp"
 #include "filter_relative_support.hpp"
 #include "filter_both_intronic.hpp"
@@ -40,6 +43,9 @@
 #include "filter_end_to_end.hpp"
 #include "filter_short_anchor.hpp"
 #include "filter_homologs.hpp"
+#include "homology_cache.hpp"
+#include "coverage_file.hpp"
+#include "checkpoint.hpp"
 #include "filter_mismappers.hpp"
 #include "filter_no_coverage.hpp"
 #include "filter_genomic_support.hpp"
@@ -49,39 +55,40 @@
 
 using namespace std;
 
-unordered_map<string,filter_t> FILTERS({
-	{"inconsistently_clipped", static_cast<string*>(NULL)},
-	{"homopolymer", static_cast<string*>(NULL)},
-	{"duplicates", static_cast<string*>(NULL)},
-	{"read_through", static_cast<string*>(NULL)},
-	{"same_gene", static_cast<string*>(NULL)},
-	{"small_insert_size", static_cast<string*>(NULL)},
-	{"long_gap", static_cast<string*>(NULL)},
-	{"hairpin", static_cast<string*>(NULL)},
-	{"mismatches", static_cast<string*>(NULL)},
-	{"mismappers", static_cast<string*>(NULL)},
-	{"relative_support", static_cast<string*>(NULL)},
-	{"intronic", static_cast<string*>(NULL)},
-	{"non_coding_neighbors", static_cast<string*>(NULL)},
-	{"intragenic_exonic", static_cast<string*>(NULL)},
-	{"min_support", static_cast<string*>(NULL)},
-	{"known_fusions", static_cast<string*>(NULL)},
-	{"spliced", static_cast<string*>(NULL)},
-	{"blacklist", static_cast<string*>(NULL)},
-	{"end_to_end", static_cast<string*>(NULL)},
-	{"pcr_fusions", static_cast<string*>(NULL)},
-	{"merge_adjacent", static_cast<string*>(NULL)},
-	{"select_best", static_cast<string*>(NULL)},
-	{"short_anchor", static_cast<string*>(NULL)},
-	{"no_coverage", static_cast<string*>(NULL)},
-	{"many_spliced", static_cast<string*>(NULL)},
-	{"no_genomic_support", static_cast<string*>(NULL)},
-	{"uninteresting_contigs", static_cast<string*>(NULL)},
-	{"genomic_support", static_cast<string*>(NULL)},
-	{"isoforms", static_cast<string*>(NULL)},
-	{"low_entropy", static_cast<string*>(NULL)},
-	{"homologs", static_cast<string*>(NULL)}
-});
+const string FILTER_NAMES[FILTER_COUNT] = {
+	"inconsistently_clipped",
+	"homopolymer",
+	"duplicates",
+	"read_through",
+	"same_gene",
+	"small_insert_size",
+	"long_gap",
+	"hairpin",
+	"mismatches",
+	"mismappers",
+	"relative_support",
+	"intronic",
+	"non_coding_neighbors",
+	"intragenic_exonic",
+	"min_support",
+	"known_fusions",
+	"spliced",
+	"blacklist",
+	"end_to_end",
+	"pcr_fusions",
+	"merge_adjacent",
+	"select_best",
+	"short_anchor",
+	"no_coverage",
+	"many_spliced",
+	"no_genomic_support",
+	"uninteresting_contigs",
+	"genomic_support",
+	"isoforms",
+	"low_entropy",
+	"homologs"
+};
+unordered_map<string,filter_t> FILTERS;
 
 string get_time_string() {
 	time_t now = time(0);
@@ -93,12 +100,15 @@ string get_time_string() {
 int main(int argc, char **argv) {
 
 	// initialize filter names
-	for (auto i = FILTERS.begin(); i != FILTERS.end(); ++i)
-		i->second = &i->first; // filters are represented by pointers to the name of the filter (this saves memory compared to storing strings)
+	for (unsigned int filter = 0; filter < FILTER_COUNT; ++filter)
+		FILTERS[FILTER_NAMES[filter]] = get_filter((filter_id_t) filter);
 
 	// parse command-line options
 	options_t options = parse_arguments(argc, argv);
 
+	// measure the resource consumption of each step
+	metrics_t metrics;
+
 	// convert options.interesting_contigs from string to contigs_t
 	contigs_t interesting_contigs;
 	if (options.filters.at("uninteresting_contigs") && !options.interesting_contigs.empty()) {
@@ -112,13 +122,24 @@ int main(int argc, char **argv) {
 	}
 	contigs_t contigs = interesting_contigs;
 
-	// load GTF file
-	cout << get_time_string() << " Loading annotation from '" << options.gene_annotation_file << "'" << endl << flush;
+	// load GTF file (or the annotation cache made from it)
+	start_stage(metrics, "annotation");
 	gene_annotation_t gene_annotation;
 	transcript_annotation_t transcript_annotation;
 	exon_annotation_t exon_annotation;
 	unordered_map<string,gene_t> gene_names;
-	read_annotation_gtf(options.gene_annotation_file, options.gtf_features, contigs, gene_annotation, transcript_annotation, exon_annotation, gene_names);
+	if (!options.annotation_cache_file.empty() &&
+	    load_annotation_cache(options.annotation_cache_file, options.gene_annotation_file, options.gtf_features, contigs, gene_annotation, transcript_annotation, exon_annotation, gene_names)) {
+		cout << get_time_string() << " Loaded annotation from cache '" << options.annotation_cache_file << "'" << endl << flush;
+	} else {
+		cout << get_time_string() << " Loading annotation from '" << options.gene_annotation_file << "'" << endl << flush;
+		vector<string> contigs_in_gtf;
+		read_annotation_gtf(options.gene_annotation_file, options.gtf_features, contigs, gene_annotation, transcript_annotation, exon_annotation, gene_names, contigs_in_gtf);
+		if (!options.annotation_cache_file.empty()) {
+			cout << get_time_string() << " Writing annotation cache '" << options.annotation_cache_file << "'" << endl << flush;
+			save_annotation_cache(options.annotation_cache_file, options.gene_annotation_file, options.gtf_features, contigs_in_gtf, contigs, gene_annotation, transcript_annotation, exon_annotation);
+		}
+	}
 
 	// sort genes and exons by coordinate (make index)
 	exon_annotation_index_t exon_annotation_index;
@@ -126,10 +147,33 @@ int main(int argc, char **argv) {
 	gene_annotation_index_t gene_annotation_index;
 	make_annotation_index(gene_annotation, gene_annotation_index);
 
+	// calculate sum of the lengths of all exons for each gene
+	// we will need this to normalize the number of events over the gene length
+	for (exon_annotation_index_t::iterator contig = exon_annotation_index.begin(); contig != exon_annotation_index.end(); ++contig) {
+		position_t region_start = 0;
+		for (exon_contig_annotation_index_t::iterator region = contig->begin(); region != contig->end(); ++region) {
+			gene_t previous_gene = NULL;
+			for (exon_view_t::const_iterator overlapping_exon = region->second.begin(); overlapping_exon != region->second.end(); ++overlapping_exon) {
+				gene_t& current_gene = (**overlapping_exon).gene;
+				if (previous_gene != current_gene) {
+					current_gene->exonic_length += region->first - region_start;
+					previous_gene = current_gene;
+				}
+			}
+			region_start = region->first;
+		}
+	}
+	for (gene_annotation_t::iterator gene = gene_annotation.begin(); gene != gene_annotation.end(); ++gene)
+		if (gene->exonic_length == 0)
+			gene->exonic_length = gene->end - gene->start; // use total gene length, if the gene has no exons
+	end_stage(metrics);
+
 	// load sequences of contigs from assembly
 	cout << get_time_string() << " Loading assembly from '" << options.assembly_file << "'" << endl;
+	start_stage(metrics, "assembly");
 	assembly_t assembly;
 	load_assembly(assembly, options.assembly_file, contigs, interesting_contigs);
+	end_stage(metrics);
 
 	// prevent htslib from downloading the assembly via the Internet, if CRAM is used
 	setenv("REF_PATH", ".", 0);
@@ -138,14 +182,62 @@ int main(int argc, char **argv) {
 	chimeric_alignments_t chimeric_alignments;
 	unsigned long int mapped_reads = 0;
 	coverage_t coverage(contigs, assembly);
-	if (!options.chimeric_bam_file.empty()) { // when STAR was run with --chimOutType SeparateSAMold, chimeric alignments must be read from a separate file named Chimeric.out.sam
-		cout << get_time_string() << " Reading chimeric alignments from '" << options.chimeric_bam_file << "'" << flush;
-		cout << " (total=" << read_chimeric_alignments(options.chimeric_bam_file, options.assembly_file, chimeric_alignments, mapped_reads, coverage, contigs, interesting_contigs, gene_annotation_index, true, false) << ")" << endl;
+	strandedness_t strandedness = options.strandedness;
+
+	if (!options.extraction_output_file.empty()) { // only extract what later runs need from Aligned.out.bam and stop
+		cout << get_time_string() << " Extracting chimeric reads from '" << options.rna_bam_file << "' to '" << options.extraction_output_file << "'" << flush;
+		start_stage(metrics, "extract_chimeric_reads");
+		cout << " (extracted=" << end_stage(metrics, extract_chimeric_reads(options.rna_bam_file, options.extraction_output_file, options.assembly_file, mapped_reads, coverage, contigs, interesting_contigs, gene_annotation_index, options.threads)) << ")" << endl;
+
+		cout << get_time_string() << " Saving coverage to '" << options.coverage_output_file << "'" << endl << flush;
+		start_stage(metrics, "save_coverage");
+		save_coverage(options.coverage_output_file, coverage, contigs, mapped_reads);
+		end_stage(metrics);
+
+		if (!options.metrics_file.empty()) {
+			cout << get_time_string() << " Writing metrics to file '" << options.metrics_file << "'" << endl;
+			write_metrics(options.metrics_file, metrics);
+		}
+		return 0;
+	}
+
+	if (!options.checkpoint_input_file.empty()) { // the alignments have been read and annotated by a previous run
+		cout << get_time_string() << " Resuming from checkpoint '" << options.checkpoint_input_file << "'" << flush;
+		start_stage(metrics, "load_checkpoint");
+		cout << " (total=" << end_stage(metrics, load_checkpoint(options.checkpoint_input_file, chimeric_alignments, mapped_reads, coverage, strandedness, contigs, gene_annotation)) << ")" << endl;
+	} else {
+		// when the coverage is loaded from a file, normal reads are neither counted nor added to the coverage
+		// (a coverage_t without any windows ignores all fragments)
+		coverage_t ignored_coverage;
+		unsigned long int ignored_mapped_reads = 0;
+		coverage_t& read_coverage = (options.coverage_input_file.empty()) ? coverage : ignored_coverage;
+		unsigned long int& read_mapped_reads = (options.coverage_input_file.empty()) ? mapped_reads : ignored_mapped_reads;
+		if (!options.coverage_input_file.empty()) {
+			cout << get_time_string() << " Loading coverage from '" << options.coverage_input_file << "'" << flush;
+			start_stage(metrics, "load_coverage");
+			load_coverage(options.coverage_input_file, coverage, contigs, mapped_reads);
+			end_stage(metrics);
+			cout << " (mapped_reads=" << mapped_reads << ")" << endl;
+		}
+
+		if (!options.chimeric_bam_file.empty()) { // when STAR was run with --chimOutType SeparateSAMold, chimeric alignments must be read from a separate file named Chimeric.out.sam
+			cout << get_time_string() << " Reading chimeric alignments from '" << options.chimeric_bam_file << "'" << flush;
+			start_stage(metrics, "read_chimeric_sam");
+			cout << " (total=" << end_stage(metrics, read_chimeric_alignments(options.chimeric_bam_file, options.assembly_file, chimeric_alignments, read_mapped_reads, read_coverage, contigs, interesting_contigs, gene_annotation_index, true, false, options.threads)) << ")" << endl;
+		}
+
+		// extract chimeric alignments and read-through alignments from Aligned.out.bam
+		cout << get_time_string() << " Reading chimeric alignments from '" << options.rna_bam_file << "'" << flush;
+		start_stage(metrics, "read_alignments");
+		cout << " (total=" << end_stage(metrics, read_chimeric_alignments(options.rna_bam_file, options.assembly_file, chimeric_alignments, read_mapped_reads, read_coverage, contigs, interesting_contigs, gene_annotation_index, !options.chimeric_bam_file.empty(), true, options.threads)) << ")" << endl;
 	}
 
-	// extract chimeric alignments and read-through alignments from Aligned.out.bam
-	cout << get_time_string() << " Reading chimeric alignments from '" << options.rna_bam_file << "'" << flush;
-	cout << " (total=" << read_chimeric_alignments(options.rna_bam_file, options.assembly_file, chimeric_alignments, mapped_reads, coverage, contigs, interesting_contigs, gene_annotation_index, !options.chimeric_bam_file.empty(), true) << ")" << endl;
+	if (!options.coverage_output_file.empty()) {
+		cout << get_time_string() << " Saving coverage to '" << options.coverage_output_file << "'" << endl << flush;
+		start_stage(metrics, "save_coverage");
+		save_coverage(options.coverage_output_file, coverage, contigs, mapped_reads);
+		end_stage(metrics);
+	}
 
 	// map contig IDs to names
 	vector<string> contigs_by_id(contigs.size());
@@ -157,152 +249,154 @@ int main(int argc, char **argv) {
 	gene_annotation_index.resize(contigs.size());
 	exon_annotation_index.resize(contigs.size());
 
-	cout << get_time_string() << " Filtering multi-mappers and single mates" << flush;
-	cout << " (remaining=" << filter_multi_mappers(chimeric_alignments) << ")" << endl;
-
-	strandedness_t strandedness = options.strandedness;
-	if (options.strandedness == STRANDEDNESS_AUTO) {
-		cout << get_time_string() << " Detecting strandedness" << flush;
-		strandedness = detect_strandedness(chimeric_alignments, gene_annotation_index, exon_annotation_index);
-		switch (strandedness) {
-			case STRANDEDNESS_YES: cout << " (yes)" << endl; break;
-			case STRANDEDNESS_REVERSE: cout << " (reverse)" << endl; break;
-			default: cout << " (no)" << endl;
-		}
-	}
-	if (strandedness != STRANDEDNESS_NO) {
-		cout << get_time_string() << " Assigning strands to alignments" << endl << flush;
-		assign_strands_from_strandedness(chimeric_alignments, strandedness);
-	}
-
-	cout << get_time_string() << " Annotating alignments" << flush << endl;
-	// calculate sum of the lengths of all exons for each gene
-	// we will need this to normalize the number of events over the gene length
-	for (exon_annotation_index_t::iterator contig = exon_annotation_index.begin(); contig != exon_annotation_index.end(); ++contig) {
-		position_t region_start = 0;
-		for (exon_contig_annotation_index_t::iterator region = contig->begin(); region != contig->end(); ++region) {
-			gene_t previous_gene = NULL;
-			for (exon_set_t::iterator overlapping_exon = region->second.begin(); overlapping_exon != region->second.end(); ++overlapping_exon) {
-				gene_t& current_gene = (**overlapping_exon).gene;
-				if (previous_gene != current_gene) {
-					current_gene->exonic_length += region->first - region_start;
-					previous_gene = current_gene;
-				}
+	if (options.checkpoint_input_file.empty()) { // the alignments have not been annotated by a previous run yet
+		cout << get_time_string() << " Filtering multi-mappers and single mates" << flush;
+		start_stage(metrics, "multi_mappers");
+		cout << " (remaining=" << end_stage(metrics, filter_multi_mappers(chimeric_alignments)) << ")" << endl;
+
+		start_stage(metrics, "strandedness");
+		if (options.strandedness == STRANDEDNESS_AUTO) {
+			cout << get_time_string() << " Detecting strandedness" << flush;
+			strandedness = detect_strandedness(chimeric_alignments, gene_annotation_index, exon_annotation_index);
+			switch (strandedness) {
+				case STRANDEDNESS_YES: cout << " (yes)" << endl; break;
+				case STRANDEDNESS_REVERSE: cout << " (reverse)" << endl; break;
+				default: cout << " (no)" << endl;
 			}
-			region_start = region->first;
 		}
-	}
-	for (gene_annotation_t::iterator gene = gene_annotation.begin(); gene != gene_annotation.end(); ++gene)
-		if (gene->exonic_length == 0)
-			gene->exonic_length = gene->end - gene->start; // use total gene length, if the gene has no exons
+		if (strandedness != STRANDEDNESS_NO) {
+			cout << get_time_string() << " Assigning strands to alignments" << endl << flush;
+			assign_strands_from_strandedness(chimeric_alignments, strandedness);
+		}
+		end_stage(metrics);
 
-	// first, try to annotate with exons
-	for (chimeric_alignments_t::iterator mates = chimeric_alignments.begin(); mates != chimeric_alignments.end(); ++mates)
-		annotate_alignments(mates->second, exon_annotation_index);
+		cout << get_time_string() << " Annotating alignments" << flush << endl;
+		start_stage(metrics, "annotate_alignments");
 
-	// if the alignment does not map to an exon, try to map it to a gene
-	for (chimeric_alignments_t::iterator chimeric_alignment = chimeric_alignments.begin(); chimeric_alignment != chimeric_alignments.end(); ++chimeric_alignment) {
-		for (mates_t::iterator mate = chimeric_alignment->second.begin(); mate != chimeric_alignment->second.end(); ++mate) {
-			if (mate->genes.empty())
-				get_annotation_by_coordinate(mate->contig, mate->start, mate->end, mate->genes, gene_annotation_index);
-		}
-		// try to resolve ambiguous mappings using mapping information from mate
-		if (chimeric_alignment->second.size() == 3) {
-			gene_set_t combined;
-			combine_annotations(chimeric_alignment->second[SPLIT_READ].genes, chimeric_alignment->second[MATE1].genes, combined);
-			if (chimeric_alignment->second[MATE1].genes.empty() || combined.size() < chimeric_alignment->second[MATE1].genes.size())
-				chimeric_alignment->second[MATE1].genes = combined;
-			if (chimeric_alignment->second[SPLIT_READ].genes.empty() || combined.size() < chimeric_alignment->second[SPLIT_READ].genes.size())
-				chimeric_alignment->second[SPLIT_READ].genes = combined;
-		}
-	}
+		// first, try to annotate with exons
+		for (chimeric_alignments_t::iterator mates = chimeric_alignments.begin(); mates != chimeric_alignments.end(); ++mates)
+			annotate_alignments(mates->second, exon_annotation_index);
 
-	// if the alignment maps neither to an exon nor to a gene, make a dummy gene which subsumes all alignments with a distance of 10kb
-	gene_annotation_t unmapped_alignments;
-	for (chimeric_alignments_t::iterator chimeric_alignment = chimeric_alignments.begin(); chimeric_alignment != chimeric_alignments.end(); ++chimeric_alignment) {
-		gene_annotation_record_t gene_annotation_record;
-		if (chimeric_alignment->second.size() == 3) { // split-read
-			if (chimeric_alignment->second[SPLIT_READ].genes.empty()) {
-				gene_annotation_record.contig = chimeric_alignment->second[SPLIT_READ].contig;
-				gene_annotation_record.start = gene_annotation_record.end = (chimeric_alignment->second[SPLIT_READ].strand == FORWARD) ? chimeric_alignment->second[SPLIT_READ].start : chimeric_alignment->second[SPLIT_READ].end;
-				unmapped_alignments.push_back(gene_annotation_record);
+		// if the alignment does not map to an exon, try to map it to a gene
+		for (chimeric_alignments_t::iterator chimeric_alignment = chimeric_alignments.begin(); chimeric_alignment != chimeric_alignments.end(); ++chimeric_alignment) {
+			for (mates_t::iterator mate = chimeric_alignment->second.begin(); mate != chimeric_alignment->second.end(); ++mate) {
+				if (mate->genes.empty())
+					get_annotation_by_coordinate(mate->contig, mate->start, mate->end, mate->genes, gene_annotation_index);
 			}
-			if (chimeric_alignment->second[SUPPLEMENTARY].genes.empty()) {
-				gene_annotation_record.contig = chimeric_alignment->second[SUPPLEMENTARY].contig;
-				gene_annotation_record.start = gene_annotation_record.end = (chimeric_alignment->second[SUPPLEMENTARY].strand == FORWARD) ? chimeric_alignment->second[SUPPLEMENTARY].end : chimeric_alignment->second[SUPPLEMENTARY].start;
-				unmapped_alignments.push_back(gene_annotation_record);
+			// try to resolve ambiguous mappings using mapping information from mate
+			if (chimeric_alignment->second.size() == 3) {
+				gene_set_t combined;
+				combine_annotations(chimeric_alignment->second[SPLIT_READ].genes, chimeric_alignment->second[MATE1].genes, combined);
+				if (chimeric_alignment->second[MATE1].genes.empty() || combined.size() < chimeric_alignment->second[MATE1].genes.size())
+					chimeric_alignment->second[MATE1].genes = combined;
+				if (chimeric_alignment->second[SPLIT_READ].genes.empty() || combined.size() < chimeric_alignment->second[SPLIT_READ].genes.size())
+					chimeric_alignment->second[SPLIT_READ].genes = combined;
 			}
-		} else { // discordant mates
-			for (mates_t::iterator mate = chimeric_alignment->second.begin(); mate != chimeric_alignment->second.end(); ++mate) {
-				if (mate->genes.empty()) {
-					gene_annotation_record.contig = mate->contig;
-					gene_annotation_record.start = gene_annotation_record.end = (mate->strand == FORWARD) ? mate->end : mate->start;
+		}
+
+		// if the alignment maps neither to an exon nor to a gene, make a dummy gene which subsumes all alignments with a distance of 10kb
+		gene_annotation_t unmapped_alignments;
+		for (chimeric_alignments_t::iterator chimeric_alignment = chimeric_alignments.begin(); chimeric_alignment != chimeric_alignments.end(); ++chimeric_alignment) {
+			gene_annotation_record_t gene_annotation_record;
+			if (chimeric_alignment->second.size() == 3) { // split-read
+				if (chimeric_alignment->second[SPLIT_READ].genes.empty()) {
+					gene_annotation_record.contig = chimeric_alignment->second[SPLIT_READ].contig;
+					gene_annotation_record.start = gene_annotation_record.end = (chimeric_alignment->second[SPLIT_READ].strand == FORWARD) ? chimeric_alignment->second[SPLIT_READ].start : chimeric_alignment->second[SPLIT_READ].end;
+					unmapped_alignments.push_back(gene_annotation_record);
+				}
+				if (chimeric_alignment->second[SUPPLEMENTARY].genes.empty()) {
+					gene_annotation_record.contig = chimeric_alignment->second[SUPPLEMENTARY].contig;
+					gene_annotation_record.start = gene_annotation_record.end = (chimeric_alignment->second[SUPPLEMENTARY].strand == FORWARD) ? chimeric_alignment->second[SUPPLEMENTARY].end : chimeric_alignment->second[SUPPLEMENTARY].start;
 					unmapped_alignments.push_back(gene_annotation_record);
 				}
+			} else { // discordant mates
+				for (mates_t::iterator mate = chimeric_alignment->second.begin(); mate != chimeric_alignment->second.end(); ++mate) {
+					if (mate->genes.empty()) {
+						gene_annotation_record.contig = mate->contig;
+						gene_annotation_record.start = gene_annotation_record.end = (mate->strand == FORWARD) ? mate->end : mate->start;
+						unmapped_alignments.push_back(gene_annotation_record);
+					}
+				}
 			}
 		}
-	}
-	if (unmapped_alignments.size() > 0) {
-		unmapped_alignments.sort();
-		gene_annotation_record_t gene_annotation_record;
-		gene_annotation_record.contig = unmapped_alignments.begin()->contig;
-		gene_annotation_record.start = unmapped_alignments.begin()->start;
-		gene_annotation_record.end = unmapped_alignments.begin()->end;
-		gene_annotation_record.strand = FORWARD;
-		gene_annotation_record.exonic_length = 10000; //TODO more exact estimation of exonic_length
-		gene_annotation_record.is_dummy = true;
-		gene_annotation_record.is_protein_coding = false;
-		gene_contig_annotation_index_t::iterator next_known_gene = gene_annotation_index[unmapped_alignments.begin()->contig].lower_bound(unmapped_alignments.begin()->end);
-		for (gene_annotation_t::iterator unmapped_alignment = next(unmapped_alignments.begin()); ; ++unmapped_alignment) {
-			// subsume all unmapped alignments in a range of 10kb into a dummy gene with the generic name "contig:start-end"
-			if (unmapped_alignment == unmapped_alignments.end() || // all unmapped alignments have been processed => add last record
-			    gene_annotation_record.end+10000 < unmapped_alignment->start || // current alignment is too far away
-			    (next_known_gene != gene_annotation_index[gene_annotation_record.contig].end() && next_known_gene->first <= unmapped_alignment->start) || // dummy gene must not overlap known genes
-			    unmapped_alignment->contig != gene_annotation_record.contig) { // end of contig reached
-				gene_annotation_record.name = contigs_by_id[gene_annotation_record.contig] + ":" + to_string(static_cast<long long int>(gene_annotation_record.start)) + "-" + to_string(static_cast<long long int>(gene_annotation_record.end));
-				gene_annotation.push_back(gene_annotation_record);
-				if (unmapped_alignment != unmapped_alignments.end()) {
-					gene_annotation_record.contig = unmapped_alignment->contig;
-					gene_annotation_record.start = unmapped_alignment->start;
-					next_known_gene = gene_annotation_index[unmapped_alignment->contig].lower_bound(unmapped_alignment->end);
-				} else {
-					break;
+		if (unmapped_alignments.size() > 0) {
+			unmapped_alignments.sort();
+			gene_annotation_record_t gene_annotation_record;
+			gene_annotation_record.contig = unmapped_alignments.begin()->contig;
+			gene_annotation_record.start = unmapped_alignments.begin()->start;
+			gene_annotation_record.end = unmapped_alignments.begin()->end;
+			gene_annotation_record.strand = FORWARD;
+			gene_annotation_record.exonic_length = 10000; //TODO more exact estimation of exonic_length
+			gene_annotation_record.is_dummy = true;
+			gene_annotation_record.is_protein_coding = false;
+			gene_contig_annotation_index_t::iterator next_known_gene = gene_annotation_index[unmapped_alignments.begin()->contig].lower_bound(unmapped_alignments.begin()->end);
+			for (gene_annotation_t::iterator unmapped_alignment = next(unmapped_alignments.begin()); ; ++unmapped_alignment) {
+				// subsume all unmapped alignments in a range of 10kb into a dummy gene with the generic name "contig:start-end"
+				if (unmapped_alignment == unmapped_alignments.end() || // all unmapped alignments have been processed => add last record
+				    gene_annotation_record.end+10000 < unmapped_alignment->start || // current alignment is too far away
+				    (next_known_gene != gene_annotation_index[gene_annotation_record.contig].end() && next_known_gene->first <= unmapped_alignment->start) || // dummy gene must not overlap known genes
+				    unmapped_alignment->contig != gene_annotation_record.contig) { // end of contig reached
+					gene_annotation_record.name = contigs_by_id[gene_annotation_record.contig] + ":" + to_string(static_cast<long long int>(gene_annotation_record.start)) + "-" + to_string(static_cast<long long int>(gene_annotation_record.end));
+					gene_annotation.push_back(gene_annotation_record);
+					if (unmapped_alignment != unmapped_alignments.end()) {
+						gene_annotation_record.contig = unmapped_alignment->contig;
+						gene_annotation_record.start = unmapped_alignment->start;
+						next_known_gene = gene_annotation_index[unmapped_alignment->contig].lower_bound(unmapped_alignment->end);
+					} else {
+						break;
+					}
 				}
+				gene_annotation_record.end = unmapped_alignment->end;
 			}
-			gene_annotation_record.end = unmapped_alignment->end;
 		}
-	}
 
-	// map yet unmapped alignments to the newly created dummy genes
-	gene_annotation_index.clear();
-	make_annotation_index(gene_annotation, gene_annotation_index); // index needs to be regenerated after adding dummy genes
-	for (chimeric_alignments_t::iterator chimeric_alignment = chimeric_alignments.begin(); chimeric_alignment != chimeric_alignments.end(); ++chimeric_alignment) {
-		for (mates_t::iterator mate = chimeric_alignment->second.begin(); mate != chimeric_alignment->second.end(); ++mate) {
-			if (mate->genes.empty())
-				get_annotation_by_coordinate(mate->contig, mate->start, mate->end, mate->genes, gene_annotation_index);
+		// map yet unmapped alignments to the newly created dummy genes
+		gene_annotation_index.clear();
+		make_annotation_index(gene_annotation, gene_annotation_index); // index needs to be regenerated after adding dummy genes
+		for (chimeric_alignments_t::iterator chimeric_alignment = chimeric_alignments.begin(); chimeric_alignment != chimeric_alignments.end(); ++chimeric_alignment) {
+			for (mates_t::iterator mate = chimeric_alignment->second.begin(); mate != chimeric_alignment->second.end(); ++mate) {
+				if (mate->genes.empty())
+					get_annotation_by_coordinate(mate->contig, mate->start, mate->end, mate->genes, gene_annotation_index);
+			}
+			if (chimeric_alignment->second.size() == 3) // split-read
+				if (chimeric_alignment->second[MATE1].genes.empty()) // copy dummy gene from split-read, if mate1 still has no annotation
+					chimeric_alignment->second[MATE1].genes = chimeric_alignment->second[SPLIT_READ].genes;
 		}
-		if (chimeric_alignment->second.size() == 3) // split-read
-			if (chimeric_alignment->second[MATE1].genes.empty()) // copy dummy gene from split-read, if mate1 still has no annotation
-				chimeric_alignment->second[MATE1].genes = chimeric_alignment->second[SPLIT_READ].genes;
+
+		// assign IDs to genes
+		// this is necessary for deterministic behavior, because fusions are hashed by genes
+		unsigned int gene_id = 0;
+		for (gene_annotation_t::iterator gene = gene_annotation.begin(); gene != gene_annotation.end(); ++gene)
+			gene->id = gene_id++;
+		end_stage(metrics);
+
+	} else {
+		// the dummy genes restored from the checkpoint must be indexed
+		gene_annotation_index.clear();
+		make_annotation_index(gene_annotation, gene_annotation_index);
 	}
 
-	// assign IDs to genes
-	// this is necessary for deterministic behavior, because fusions are hashed by genes
-	unsigned int gene_id = 0;
-	for (gene_annotation_t::iterator gene = gene_annotation.begin(); gene != gene_annotation.end(); ++gene)
-		gene->id = gene_id++;
+	if (!options.checkpoint_output_file.empty()) {
+		cout << get_time_string() << " Writing checkpoint '" << options.checkpoint_output_file << "'" << endl << flush;
+		start_stage(metrics, "save_checkpoint");
+		save_checkpoint(options.checkpoint_output_file, chimeric_alignments, mapped_reads, coverage, strandedness, contigs, gene_annotation);
+		end_stage(metrics);
+	}
 
 	if (options.filters.at("duplicates")) {
 		cout << get_time_string() << " Filtering duplicates" << flush;
-		cout << " (remaining=" << filter_duplicates(chimeric_alignments) << ")" << endl;
+		start_stage(metrics, "duplicates");
+		cout << " (remaining=" << end_stage(metrics, filter_duplicates(chimeric_alignments)) << ")" << endl;
 	}
 
 	if (options.filters.at("uninteresting_contigs") && !interesting_contigs.empty()) {
 		cout << get_time_string() << " Filtering mates which do not map to interesting contigs (" << options.interesting_contigs << ")" << flush;
-		cout << " (remaining=" << filter_uninteresting_contigs(chimeric_alignments, contigs, interesting_contigs) << ")" << endl;
+		start_stage(metrics, "uninteresting_contigs");
+		cout << " (remaining=" << end_stage(metrics, filter_uninteresting_contigs(chimeric_alignments, contigs, interesting_contigs)) << ")" << endl;
 	}
 
 	cout << get_time_string() << " Estimating mate gap distribution" << flush;
+	start_stage(metrics, "mate_gap_distribution");
 	float mate_gap_mean, mate_gap_stddev;
 	int max_mate_gap;
 	if (estimate_mate_gap_distribution(chimeric_alignments, mate_gap_mean, mate_gap_stddev, gene_annotation_index, exon_annotation_index)) {
@@ -310,82 +404,95 @@ int main(int argc, char **argv) {
 		max_mate_gap = max(0, (int) (mate_gap_mean + 3*mate_gap_stddev));
 	} else
 		max_mate_gap = options.fragment_length;
+	end_stage(metrics);
 	
 	if (options.filters.at("read_through")) {
 		cout << get_time_string() << " Filtering read-through fragments with a distance <=" << options.min_read_through_distance << "bp" << flush;
-		cout << " (remaining=" << filter_proximal_read_through(chimeric_alignments, options.min_read_through_distance) << ")" << endl;
-	}
-
-	if (options.filters.at("inconsistently_clipped")) {
-		cout << get_time_string() << " Filtering inconsistently clipped mates" << flush;
-		cout << " (remaining=" << filter_inconsistently_clipped_mates(chimeric_alignments) << ")" << endl;
-	}
-
-	if (options.filters.at("homopolymer")) {
-		cout << get_time_string() << " Filtering breakpoints adjacent to homopolymers >=" << options.homopolymer_length << "nt" << flush;
-		cout << " (remaining=" << filter_homopolymer(chimeric_alignments, options.homopolymer_length, exon_annotation_index) << ")" << endl;
-	}
-
-	if (options.filters.at("small_insert_size")) {
-		cout << get_time_string() << " Filtering fragments with small insert size" << flush;
-		cout << " (remaining=" << filter_small_insert_size(chimeric_alignments, 5) << ")" << endl;
-	}
-
-	if (options.filters.at("long_gap")) {
-		cout << get_time_string() << " Filtering alignments with long gaps" << flush;
-		cout << " (remaining=" << filter_long_gap(chimeric_alignments) << ")" << endl;
-	}
-
-	if (options.filters.at("same_gene")) {
-		cout << get_time_string() << " Filtering fragments with both mates in the same gene" << flush;
-		cout << " (remaining=" << filter_same_gene(chimeric_alignments, exon_annotation_index) << ")" << endl;
-	}
-
-	if (options.filters.at("hairpin")) {
-		cout << get_time_string() << " Filtering fusions arising from hairpin structures" << flush;
-		cout << " (remaining=" << filter_hairpin(chimeric_alignments, exon_annotation_index, max_mate_gap) << ")" << endl;
-	}
-
+		start_stage(metrics, "read_through");
+		cout << " (remaining=" << end_stage(metrics, filter_proximal_read_through(chimeric_alignments, options.min_read_through_distance)) << ")" << endl;
+	}
+
+	// the read-level filters are applied in a single pass over the fragments
+	read_filter_chain_t read_filter_chain;
+	if (options.filters.at("inconsistently_clipped"))
+		add_read_filter(read_filter_chain, get_filter(FILTER_INCONSISTENTLY_CLIPPED), "Filtering inconsistently clipped mates",
+			[&](const mates_t& mates) { return is_inconsistently_clipped(mates); });
+	if (options.filters.at("homopolymer"))
+		add_read_filter(read_filter_chain, get_filter(FILTER_HOMOPOLYMER), "Filtering breakpoints adjacent to homopolymers >=" + to_string(static_cast<long long unsigned int>(options.homopolymer_length)) + "nt",
+			[&](const mates_t& mates) { return is_adjacent_to_homopolymer(mates, options.homopolymer_length, exon_annotation_index); });
+	if (options.filters.at("small_insert_size"))
+		add_read_filter(read_filter_chain, get_filter(FILTER_SMALL_INSERT_SIZE), "Filtering fragments with small insert size",
+			[&](const mates_t& mates) { return has_small_insert_size(mates, 5); });
+	if (options.filters.at("long_gap"))
+		add_read_filter(read_filter_chain, get_filter(FILTER_LONG_GAP), "Filtering alignments with long gaps",
+			[&](const mates_t& mates) { return has_long_gap(mates); });
+	if (options.filters.at("same_gene"))
+		add_read_filter(read_filter_chain, get_filter(FILTER_SAME_GENE), "Filtering fragments with both mates in the same gene",
+			[&](const mates_t& mates) { return is_same_gene(mates); });
+	if (options.filters.at("hairpin"))
+		add_read_filter(read_filter_chain, get_filter(FILTER_HAIRPIN), "Filtering fusions arising from hairpin structures",
+			[&](const mates_t& mates) { return is_hairpin(mates); });
 	if (options.filters.at("mismatches")) {
-		cout << get_time_string() << " Filtering reads with a mismatch p-value <=" << options.mismatch_pvalue_cutoff << flush;
-		cout << " (remaining=" << filter_mismatches(chimeric_alignments, assembly, interesting_contigs, 0.01, options.mismatch_pvalue_cutoff) << ")" << endl;
+		ostringstream description;
+		description << "Filtering reads with a mismatch p-value <=" << options.mismatch_pvalue_cutoff;
+		const long unsigned int genome_size = get_genome_size(assembly, interesting_contigs);
+		add_read_filter(read_filter_chain, get_filter(FILTER_MISMATCHES), description.str(),
+			[&, genome_size](const mates_t& mates) { return has_too_many_mismatches(mates, assembly, 0.01, genome_size, options.mismatch_pvalue_cutoff); }); // <genome_size> goes out of scope before the filter runs
 	}
-
 	if (options.filters.at("low_entropy")) {
-		cout << get_time_string() << " Filtering reads with low entropy (k-mer content >=" << (options.max_kmer_content*100) << "%)" << flush;
-		cout << " (remaining=" << filter_low_entropy(chimeric_alignments, 3, options.max_kmer_content) << ")" << endl;
+		ostringstream description;
+		description << "Filtering reads with low entropy (k-mer content >=" << (options.max_kmer_content*100) << "%)";
+		add_read_filter(read_filter_chain, get_filter(FILTER_LOW_ENTROPY), description.str(),
+			[&](const mates_t& mates) { return has_low_entropy(mates, 3, options.max_kmer_content); });
+	}
+	if (!read_filter_chain.empty()) {
+		start_stage(metrics, "read_filters");
+		end_stage(metrics, run_read_filter_chain(chimeric_alignments, read_filter_chain, options.threads, !options.metrics_file.empty()));
+		metrics.stages.back().input = read_filter_chain.front().input; // the chain counts the fragments which have not been filtered before
+		for (read_filter_chain_t::iterator read_filter = read_filter_chain.begin(); read_filter != read_filter_chain.end(); ++read_filter) {
+			cout << get_time_string() << " " << read_filter->description << " (remaining=" << read_filter->remaining << ")" << endl;
+			add_stage(metrics, "read_filters:" + *read_filter->filter, read_filter->time, read_filter->input, read_filter->remaining);
+		}
 	}
 
 	cout << get_time_string() << " Finding fusions and counting supporting reads" << flush;
 	fusions_t fusions;
-	cout << " (total=" << find_fusions(chimeric_alignments, fusions, exon_annotation_index, max_mate_gap, options.subsampling_threshold) << ")" << endl;
+	start_stage(metrics, "find_fusions");
+	cout << " (total=" << end_stage(metrics, find_fusions(chimeric_alignments, fusions, exon_annotation_index, max_mate_gap, options.subsampling_threshold)) << ")" << endl;
 
 	if (!options.genomic_breakpoints_file.empty()) {
 		cout << get_time_string() << " Marking fusions with support from whole-genome sequencing in '" << options.genomic_breakpoints_file << "'" << flush;
+		start_stage(metrics, "mark_genomic_support");
 		cout << " (marked=" << mark_genomic_support(fusions, options.genomic_breakpoints_file, contigs, options.max_genomic_breakpoint_distance) << ")" << endl;
+		end_stage(metrics);
 	}
 
 	if (options.filters.at("merge_adjacent")) {
 		cout << get_time_string() << " Merging adjacent fusion breakpoints" << flush;
-		cout << " (remaining=" << merge_adjacent_fusions(fusions, 5) << ")" << endl;
+		start_stage(metrics, "merge_adjacent");
+		cout << " (remaining=" << end_stage(metrics, merge_adjacent_fusions(fusions, 5)) << ")" << endl;
 	}
 
 	// this step must come after the 'merge_adjacent' filter,
 	// because STAR clips reads supporting the same breakpoints at different position
 	// and that spreads the supporting reads over multiple breakpoints
 	cout << get_time_string() << " Estimating expected number of fusions by random chance (e-value)" << endl << flush;
+	start_stage(metrics, "evalue");
 	estimate_expected_fusions(fusions, mapped_reads, exon_annotation_index);
+	end_stage(metrics);
 
 	// this step must come before all filters that are potentially undone by the 'genomic_support' filter
 	if (options.filters.at("non_coding_neighbors")) {
 		cout << get_time_string() << " Filtering fusions with both breakpoints in adjacent non-coding/intergenic regions" << flush;
-		cout << " (remaining=" << filter_non_coding_neighbors(fusions) << ")" << endl;
+		start_stage(metrics, "non_coding_neighbors");
+		cout << " (remaining=" << end_stage(metrics, filter_non_coding_neighbors(fusions)) << ")" << endl;
 	}
 
 	// this step must come before all filters that are potentially undone by the 'genomic_support' filter
 	if (options.filters.at("intragenic_exonic")) {
 		cout << get_time_string() << " Filtering intragenic fusions with both breakpoints in exonic regions" << flush;
-		cout << " (remaining=" << filter_intragenic_both_exonic(fusions, exon_annotation_index, options.exonic_fraction) << ")" << endl;
+		start_stage(metrics, "intragenic_exonic");
+		cout << " (remaining=" << end_stage(metrics, filter_intragenic_both_exonic(fusions, exon_annotation_index, options.exonic_fraction)) << ")" << endl;
 	}
 
 	// this step must come after e-value calculation,
@@ -393,24 +500,28 @@ int main(int argc, char **argv) {
 	// it must come before all filters that are potentially undone by the 'genomic_support' filter
 	if (options.filters.at("min_support")) {
 		cout << get_time_string() << " Filtering fusions with <" << options.min_support << " supporting reads" << flush;
-		cout << " (remaining=" << filter_min_support(fusions, options.min_support) << ")" << endl;
+		start_stage(metrics, "min_support");
+		cout << " (remaining=" << end_stage(metrics, filter_min_support(fusions, options.min_support)) << ")" << endl;
 	}
 
 	if (options.filters.at("relative_support")) {
 		cout << get_time_string() << " Filtering fusions with an e-value >=" << options.evalue_cutoff << flush;
-		cout << " (remaining=" << filter_relative_support(fusions, options.evalue_cutoff) << ")" << endl;
+		start_stage(metrics, "relative_support");
+		cout << " (remaining=" << end_stage(metrics, filter_relative_support(fusions, options.evalue_cutoff)) << ")" << endl;
 	}
 
 	// this step must come before all filters that are potentially undone by the 'genomic_support' filter
 	if (options.filters.at("intronic")) {
 		cout << get_time_string() << " Filtering fusions with both breakpoints in intronic/intergenic regions" << flush;
-		cout << " (remaining=" << filter_both_intronic(fusions) << ")" << endl;
+		start_stage(metrics, "intronic");
+		cout << " (remaining=" << end_stage(metrics, filter_both_intronic(fusions)) << ")" << endl;
 	}
 
 	// this step must come right after the 'relative_support' and 'min_support' filters
 	if (!options.known_fusions_file.empty() && options.filters.at("known_fusions")) {
 		cout << get_time_string() << " Searching for known fusions in '" << options.known_fusions_file << "'" << flush;
-		cout << " (remaining=" << recover_known_fusions(fusions, options.known_fusions_file, gene_names, coverage) << ")" << endl;
+		start_stage(metrics, "known_fusions");
+		cout << " (remaining=" << end_stage(metrics, recover_known_fusions(fusions, options.known_fusions_file, gene_names, coverage)) << ")" << endl;
 	}
 
 	// this step must come after the 'merge_adjacent' filter,
@@ -419,20 +530,23 @@ int main(int argc, char **argv) {
 	// which are prone to recovering PCR-mediated fusions
 	if (options.filters.at("pcr_fusions")) {
 		cout << get_time_string() << " Filtering PCR/RT fusions between genes with an expression above the " << (options.high_expression_quantile*100) << "% quantile" << flush;
-		cout << " (remaining=" << filter_pcr_fusions(fusions, chimeric_alignments, options.high_expression_quantile, gene_annotation_index) << ")" << endl;
+		start_stage(metrics, "pcr_fusions");
+		cout << " (remaining=" << end_stage(metrics, filter_pcr_fusions(fusions, chimeric_alignments, options.high_expression_quantile, gene_annotation_index)) << ")" << endl;
 	}
 
 	// this step must come closely after the 'relative_support' and 'min_support' filters
 	if (options.filters.at("spliced")) {
 		cout << get_time_string() << " Searching for fusions with spliced split reads" << flush;
-		cout << " (remaining=" << recover_both_spliced(fusions, 200) << ")" << endl;
+		start_stage(metrics, "spliced");
+		cout << " (remaining=" << end_stage(metrics, recover_both_spliced(fusions, 200)) << ")" << endl;
 	}
 
 	// this step must come after the 'merge_adjacent' filter,
 	// because merging might yield a different best breakpoint
 	if (options.filters.at("select_best")) {
 		cout << get_time_string() << " Selecting best breakpoints from genes with multiple breakpoints" << flush;
-		cout << " (remaining=" << select_most_supported_breakpoints(fusions) << ")" << endl;
+		start_stage(metrics, "select_best");
+		cout << " (remaining=" << end_stage(metrics, select_most_supported_breakpoints(fusions)) << ")" << endl;
 	}
 
 	// this step must come after the 'select_best' filter, because it increases the chances of
@@ -440,38 +554,44 @@ int main(int argc, char **argv) {
 	// moreover, this step must come after all the filters the 'relative_support' and 'min_support' filters
 	if (options.filters.at("many_spliced")) {
 		cout << get_time_string() << " Searching for fusions with >=" << options.min_spliced_events << " spliced events" << flush;
-		cout << " (remaining=" << recover_many_spliced(fusions, options.min_spliced_events) << ")" << endl;
+		start_stage(metrics, "many_spliced");
+		cout << " (remaining=" << end_stage(metrics, recover_many_spliced(fusions, options.min_spliced_events)) << ")" << endl;
 	}
 
 	if (!options.genomic_breakpoints_file.empty() && options.filters.at("no_genomic_support")) {
 		cout << get_time_string() << " Assigning confidence scores to events" << endl << flush;
+		start_stage(metrics, "no_genomic_support");
 		assign_confidence(fusions, coverage);
 
 		// this step must come after assigning confidence scores
 		cout << get_time_string() << " Filtering low-confidence events with no support from WGS" << flush;
-		cout << " (remaining=" << filter_no_genomic_support(fusions) << ")" << endl;
+		cout << " (remaining=" << end_stage(metrics, filter_no_genomic_support(fusions)) << ")" << endl;
 	}
 
 	// this step must come after the 'select_best' filter, because the 'select_best' filter prefers
 	// soft-clipped breakpoints, which are easier to remove by blacklisting, because they are more recurrent
 	if (options.filters.at("blacklist") && !options.blacklist_file.empty()) {
 		cout << get_time_string() << " Filtering blacklisted fusions in '" << options.blacklist_file << "'" << flush;
-		cout << " (remaining=" << filter_blacklisted_ranges(fusions, options.blacklist_file, contigs, gene_names, options.evalue_cutoff, max_mate_gap) << ")" << endl;
+		start_stage(metrics, "blacklist");
+		cout << " (remaining=" << end_stage(metrics, filter_blacklisted_ranges(fusions, options.blacklist_file, contigs, gene_names, options.evalue_cutoff, max_mate_gap)) << ")" << endl;
 	}
 
 	if (options.filters.at("short_anchor")) {
 		cout << get_time_string() << " Filtering fusions with anchors <=" << options.min_anchor_length << "nt" << flush;
-		cout << " (remaining=" << filter_short_anchor(fusions, options.min_anchor_length) << ")" << endl;
+		start_stage(metrics, "short_anchor");
+		cout << " (remaining=" << end_stage(metrics, filter_short_anchor(fusions, options.min_anchor_length)) << ")" << endl;
 	}
 
 	if (options.filters.at("end_to_end")) {
 		cout << get_time_string() << " Filtering end-to-end fusions with low support" << flush;
-		cout << " (remaining=" << filter_end_to_end_fusions(fusions) << ")" << endl;
+		start_stage(metrics, "end_to_end");
+		cout << " (remaining=" << end_stage(metrics, filter_end_to_end_fusions(fusions)) << ")" << endl;
 	}
 
 	if (options.filters.at("no_coverage")) {
 		cout << get_time_string() << " Filtering fusions with no coverage around the breakpoints" << flush;
-		cout << " (remaining=" << filter_no_coverage(fusions, coverage, exon_annotation_index, max_mate_gap) << ")" << endl;
+		start_stage(metrics, "no_coverage");
+		cout << " (remaining=" << end_stage(metrics, filter_no_coverage(fusions, coverage, exon_annotation_index, max_mate_gap)) << ")" << endl;
 	}
 
 	// make kmer indices from gene sequences
@@ -479,51 +599,79 @@ int main(int argc, char **argv) {
 	const char kmer_length = 8; // must not be longer than 16 or else conversion to int will fail
 	if (options.filters.at("homologs") || options.filters.at("mismappers")) {
 		cout << get_time_string() << " Indexing gene sequences" << endl << flush;
+		start_stage(metrics, "kmer_index");
 		make_kmer_index(fusions, assembly, kmer_length, kmer_indices);
+		end_stage(metrics);
 	}
 
 	// this step must come near the end, because it is expensive in terms of memory consumption
 	if (options.filters.at("homologs")) {
+		start_stage(metrics, "homologs");
+		homology_cache_t homology_cache;
+		if (!options.homology_cache_file.empty() &&
+		    load_homology_cache(options.homology_cache_file, options.assembly_file, contigs, assembly, kmer_length, options.max_homolog_identity, options.screen_homologs, homology_cache))
+			cout << get_time_string() << " Loaded " << homology_cache.is_homolog.size() << " pairs of genes from homology cache '" << options.homology_cache_file << "'" << endl << flush;
 		cout << get_time_string() << " Filtering genes with >=" << (options.max_homolog_identity*100) << "% identity" << flush;
-		cout << " (remaining=" << filter_homologs(fusions, kmer_indices, kmer_length, assembly, options.max_homolog_identity) << ")" << endl;
+		const long long int remaining = filter_homologs(fusions, kmer_indices, kmer_length, assembly, options.max_homolog_identity, options.screen_homologs, homology_cache);
+		cout << " (remaining=" << remaining << ")" << endl;
+		if (!options.homology_cache_file.empty() && homology_cache.new_entries > 0) {
+			cout << get_time_string() << " Writing homology cache '" << options.homology_cache_file << "'" << endl << flush;
+			save_homology_cache(options.homology_cache_file, homology_cache);
+		}
+		end_stage(metrics, remaining);
 	}
 
 	// this step must come near the end, because it is expensive in terms of memory and CPU consumption
 	if (options.filters.at("mismappers")) {
 		cout << get_time_string() << " Re-aligning chimeric reads to filter fusions with >=" << (options.max_mismapper_fraction*100) << "% mis-mappers" << flush;
-		cout << " (remaining=" << filter_mismappers(fusions, kmer_indices, kmer_length, assembly, exon_annotation_index, options.max_mismapper_fraction, max_mate_gap) << ")" << endl;
+		start_stage(metrics, "mismappers");
+		cout << " (remaining=" << end_stage(metrics, filter_mismappers(fusions, kmer_indices, kmer_length, assembly, exon_annotation_index, options.max_mismapper_fraction, max_mate_gap, options.banded_alignment, options.threads)) << ")" << endl;
 	}
 
 	// this step must come after all heuristic filters, to undo them
 	if (!options.genomic_breakpoints_file.empty() && options.filters.at("genomic_support")) {
 		cout << get_time_string() << " Searching for fusions with support from WGS" << flush;
-		cout << " (remaining=" << recover_genomic_support(fusions) << ")" << endl;
+		start_stage(metrics, "genomic_support");
+		cout << " (remaining=" << end_stage(metrics, recover_genomic_support(fusions)) << ")" << endl;
 	}
 
 	if (!options.genomic_breakpoints_file.empty() && options.filters.at("genomic_support") || options.filters.at("many_spliced")) {
 		// the 'select_best' filter needs to be run again, to remove redundant events recovered by the 'genomic_support' and 'many_spliced' filters
 		if (options.filters.at("select_best")) {
 			cout << get_time_string() << " Selecting best breakpoints from genes with multiple breakpoints" << flush;
-			cout << " (remaining=" << select_most_supported_breakpoints(fusions) << ")" << endl;
+			start_stage(metrics, "select_best");
+			cout << " (remaining=" << end_stage(metrics, select_most_supported_breakpoints(fusions)) << ")" << endl;
 		}
 	}
 
 	// this filter must come last, because it should only recover isoforms of fusions which pass all other filters
 	if (options.filters.at("isoforms")) {
 		cout << get_time_string() << " Searching for additional isoforms" << flush;
-		cout << " (remaining=" << recover_isoforms(fusions) << ")" << endl;
+		start_stage(metrics, "isoforms");
+		cout << " (remaining=" << end_stage(metrics, recover_isoforms(fusions)) << ")" << endl;
 	}
 
 	// this step must come after the 'isoforms' filter, because recovered isoforms need to be scored anew
 	cout << get_time_string() << " Assigning confidence scores to events" << endl << flush;
+	start_stage(metrics, "confidence");
 	assign_confidence(fusions, coverage);
+	end_stage(metrics);
 
 	cout << get_time_string() << " Writing fusions to file '" << options.output_file << "'" << endl;
+	start_stage(metrics, "output");
 	write_fusions_to_file(fusions, options.output_file, coverage, assembly, gene_annotation_index, exon_annotation_index, contigs_by_id, options.print_supporting_reads, options.print_fusion_sequence, options.print_peptide_sequence, false);
+	end_stage(metrics);
 
 	if (options.discarded_output_file != "") {
 		cout << get_time_string() << " Writing discarded fusions to file '" << options.discarded_output_file << "'" << endl;
+		start_stage(metrics, "discarded_output");
 		write_fusions_to_file(fusions, options.discarded_output_file, coverage, assembly, gene_annotation_index, exon_annotation_index, contigs_by_id, options.print_supporting_reads_for_discarded_fusions, options.print_fusion_sequence_for_discarded_fusions, options.print_peptide_sequence_for_discarded_fusions, true);
+		end_stage(metrics);
+	}
+
+	if (!options.metrics_file.empty()) {
+		cout << get_time_string() << " Writing metrics to file '" << options.metrics_file << "'" << endl;
+		write_metrics(options.metrics_file, metrics);
 	}
 
 	return 0;
@@ -1,10 +1,23 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "bgzf.h"
+#include "faidx.h"
 #include "sam.h"
 #include "common.hpp"
 #include "annotation.hpp"
-#include "read_compressed_file.hpp"
 #include "assembly.hpp"
 
 using namespace std;
@@ -23,36 +36,227 @@ string dna_to_reverse_complement(const string& dna) {
 	return reverse_complement;
 }
 
-void load_assembly(assembly_t& assembly, const string& fasta_file_path, contigs_t& contigs, const contigs_t& interesting_contigs) {
+unsigned int count_matching_bases(const char* sequence1, const char* sequence2, const unsigned int length) {
+	unsigned int matching_bases = 0;
+	unsigned int i = 0;
+#ifdef __SSE2__
+	// compare 16 bases at a time
+	for (; i + 16 <= length; i += 16) {
+		const __m128i bases1 = _mm_loadu_si128((const __m128i*) (sequence1 + i));
+		const __m128i bases2 = _mm_loadu_si128((const __m128i*) (sequence2 + i));
+		matching_bases += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(bases1, bases2)));
+	}
+#endif
+	// compare remaining bases one by one
+	for (; i < length; ++i)
+		if (sequence1[i] == sequence2[i])
+			++matching_bases;
+	return matching_bases;
+}
+
+void count_mismatching_bases(const char* read, const char* reference, const unsigned int length, unsigned int& mismatches, unsigned int& compared_bases) {
+	unsigned int i = 0;
+#ifdef __SSE2__
+	// compare 16 bases at a time
+	const __m128i n = _mm_set1_epi8('N');
+	for (; i + 16 <= length; i += 16) {
+		const __m128i read_bases = _mm_loadu_si128((const __m128i*) (read + i));
+		const __m128i reference_bases = _mm_loadu_si128((const __m128i*) (reference + i));
+		const unsigned int matches_or_n = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(read_bases, reference_bases), _mm_cmpeq_epi8(read_bases, n)));
+		const unsigned int n_bases = __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(read_bases, n)));
+		mismatches += 16 - __builtin_popcount(matches_or_n);
+		compared_bases += 16 - n_bases;
+	}
+#endif
+	// compare remaining bases one by one
+	for (; i < length; ++i) {
+		if (read[i] != 'N') {
+			if (read[i] != reference[i])
+				mismatches++;
+			compared_bases++;
+		}
+	}
+}
 
-	// open FastA file
-	stringstream fasta_file;
-	autodecompress_file(fasta_file_path, fasta_file);
+// load the sequences of the interesting contigs from an uncompressed FastA file with a .fai index
+// the file is memory-mapped and the sequences of uninteresting contigs are never read
+void load_assembly_from_mapped_file(assembly_t& assembly, const string& fasta_file_path, const vector<fasta_index_record_t>& fasta_index, const vector<contig_t>& contigs_to_load) {
 
-	// read line by line
-	string line;
-	contig_t current_contig = -1;
-	while (getline(fasta_file, line)) {
-		if (!line.empty()) {
+	int file_descriptor = open(fasta_file_path.c_str(), O_RDONLY);
+	struct stat file_status;
+	if (file_descriptor == -1 || fstat(file_descriptor, &file_status) != 0) {
+		cerr << "ERROR: failed to open file '" << fasta_file_path << "'." << endl;
+		exit(1);
+	}
+	const char* mapped_file = (file_status.st_size == 0) ? NULL : (const char*) mmap(NULL, file_status.st_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+	close(file_descriptor);
+	if (mapped_file == MAP_FAILED) {
+		cerr << "ERROR: failed to map file '" << fasta_file_path << "' into memory." << endl;
+		exit(1);
+	}
+
+	for (unsigned int i = 0; i < fasta_index.size(); ++i) {
+		if (contigs_to_load[i] == -1)
+			continue; // skip uninteresting contigs
+
+		// copy the sequence line by line, skipping the line breaks
+		const fasta_index_record_t& record = fasta_index[i];
+		if (record.line_bases == 0 || record.offset + (record.length + record.line_bases - 1) / record.line_bases * record.line_width > (long unsigned int) file_status.st_size + record.line_width) {
+			cerr << "ERROR: index of file '" << fasta_file_path << "' is malformed or outdated." << endl;
+			exit(1);
+		}
+		string& sequence = assembly[contigs_to_load[i]];
+		sequence.resize(record.length);
+		for (long unsigned int copied_bases = 0; copied_bases < record.length; copied_bases += record.line_bases) {
+			const char* line = mapped_file + record.offset + copied_bases / record.line_bases * record.line_width;
+			const long unsigned int bases_in_line = min(record.line_bases, record.length - copied_bases);
+			if (line + bases_in_line > mapped_file + file_status.st_size) {
+				cerr << "ERROR: index of file '" << fasta_file_path << "' is malformed or outdated." << endl;
+				exit(1);
+			}
+			for (long unsigned int base = 0; base < bases_in_line; ++base)
+				sequence[copied_bases + base] = toupper(line[base]); // convert sequence to uppercase
+		}
+	}
+
+	if (mapped_file != NULL)
+		munmap((void*) mapped_file, file_status.st_size);
+}
+
+// load the sequences of the interesting contigs from a bgzip-compressed FastA file with a .fai and a .gzi index
+void load_assembly_from_compressed_file(assembly_t& assembly, const string& fasta_file_path, const vector<fasta_index_record_t>& fasta_index, const vector<contig_t>& contigs_to_load) {
+
+	faidx_t* fasta_file = fai_load(fasta_file_path.c_str());
+	if (fasta_file == NULL) {
+		cerr << "ERROR: failed to load index of file '" << fasta_file_path << "'." << endl;
+		exit(1);
+	}
+
+	for (unsigned int i = 0; i < fasta_index.size(); ++i) {
+		if (contigs_to_load[i] == -1)
+			continue; // skip uninteresting contigs
+
+		int length;
+		char* sequence = faidx_fetch_seq(fasta_file, fasta_index[i].name.c_str(), 0, fasta_index[i].length - 1, &length);
+		if (sequence == NULL || length < 0 || (long unsigned int) length != fasta_index[i].length) {
+			cerr << "ERROR: failed to read sequence of contig '" << fasta_index[i].name << "' from file '" << fasta_file_path << "'." << endl;
+			exit(1);
+		}
+		string& contig_sequence = assembly[contigs_to_load[i]];
+		contig_sequence.resize(length);
+		for (int base = 0; base < length; ++base)
+			contig_sequence[base] = toupper(sequence[base]); // convert sequence to uppercase
+		free(sequence);
+	}
+
+	fai_destroy(fasta_file);
+}
+
+// read the FastA file sequentially, if there is no index
+void load_assembly_sequentially(assembly_t& assembly, const string& fasta_file_path, contigs_t& contigs, const contigs_t& interesting_contigs) {
+
+	// open FastA file (BGZF transparently reads uncompressed files, too)
+	BGZF* fasta_file = bgzf_open(fasta_file_path.c_str(), "r");
+	if (fasta_file == NULL) {
+		cerr << "ERROR: failed to open file '" << fasta_file_path << "'." << endl;
+		exit(1);
+	}
+
+	// read line by line and append the lines to the sequence of the current contig directly
+	kstring_t line = {0, 0, NULL};
+	string* current_contig_sequence = NULL;
+	int line_length;
+	while ((line_length = bgzf_getline(fasta_file, '\n', &line)) >= 0) {
+		if (line_length > 0) {
 
 			// get contig name
-			if (line[0] == '>') {
-				istringstream iss(line.substr(1));
+			if (line.s[0] == '>') {
+				istringstream iss(line.s + 1);
 				string contig_name;
 				iss >> contig_name;
 				contig_name = removeChr(contig_name);
 				pair<contigs_t::iterator,bool> new_contig = contigs.insert(pair<string,contig_t>(contig_name, contigs.size()));
-				current_contig = new_contig.first->second;
 				if (!interesting_contigs.empty() && interesting_contigs.find(contig_name) == interesting_contigs.end())
-					current_contig = -1; // skip uninteresting contigs
+					current_contig_sequence = NULL; // skip uninteresting contigs
+				else
+					current_contig_sequence = &assembly[new_contig.first->second];
 
 			// get sequence
-			} else if (current_contig != -1) { // skip line if contig is undefined or not interesting
-				std::transform(line.begin(), line.end(), line.begin(), (int (*)(int))std::toupper); // convert sequence to uppercase
-				assembly[current_contig] += line;
+			} else if (current_contig_sequence != NULL) { // skip line if contig is undefined or not interesting
+				const string::size_type old_length = current_contig_sequence->size();
+				current_contig_sequence->resize(old_length + line_length);
+				for (int base = 0; base < line_length; ++base)
+					(*current_contig_sequence)[old_length + base] = toupper(line.s[base]); // convert sequence to uppercase
 			}
 		}
 	}
+	if (line_length < -1) {
+		cerr << "ERROR: failed to read file '" << fasta_file_path << "'." << endl;
+		exit(1);
+	}
+
+	free(line.s);
+	bgzf_close(fasta_file);
+}
+
+bool read_fasta_index(const string& fasta_index_file_path, vector<fasta_index_record_t>& fasta_index) {
+	ifstream fasta_index_file(fasta_index_file_path.c_str());
+	if (!fasta_index_file.is_open())
+		return false;
+	string line;
+	while (getline(fasta_index_file, line)) {
+		if (line.empty())
+			continue;
+		istringstream iss(line);
+		fasta_index_record_t record;
+		if (!(iss >> record.name >> record.length >> record.offset >> record.line_bases >> record.line_width)) {
+			cerr << "WARNING: malformed line in FastA index '" << fasta_index_file_path << "', ignoring index: " << line << endl;
+			fasta_index.clear();
+			return false;
+		}
+		fasta_index.push_back(record);
+	}
+	return !fasta_index.empty();
+}
+
+// determine the compression of the FastA file from its content, since the file name may have any extension
+int get_compression(const string& fasta_file_path) {
+	BGZF* fasta_file = bgzf_open(fasta_file_path.c_str(), "r");
+	if (fasta_file == NULL) {
+		cerr << "ERROR: failed to open file '" << fasta_file_path << "'." << endl;
+		exit(1);
+	}
+	const int compression = bgzf_compression(fasta_file);
+	bgzf_close(fasta_file);
+	return compression;
+}
+
+void load_assembly(assembly_t& assembly, const string& fasta_file_path, contigs_t& contigs, const contigs_t& interesting_contigs) {
+
+	// if the FastA file is indexed, only the interesting contigs need to be read
+	// this requires that the file is uncompressed or compressed with bgzip and that it has a .gzi index in the latter case,
+	// files compressed with regular gzip can only be read sequentially
+	vector<fasta_index_record_t> fasta_index;
+	const int compression = get_compression(fasta_file_path);
+	if ((compression == no_compression || compression == bgzf && access((fasta_file_path + ".gzi").c_str(), R_OK) == 0) &&
+	    read_fasta_index(fasta_file_path + ".fai", fasta_index)) {
+
+		// assign IDs to contigs in the order of the FastA file
+		vector<contig_t> contigs_to_load(fasta_index.size());
+		for (unsigned int i = 0; i < fasta_index.size(); ++i) {
+			string contig_name = removeChr(fasta_index[i].name);
+			contig_t contig = contigs.insert(pair<string,contig_t>(contig_name, contigs.size())).first->second;
+			contigs_to_load[i] = (!interesting_contigs.empty() && interesting_contigs.find(contig_name) == interesting_contigs.end()) ? -1 : contig;
+		}
+
+		if (compression == bgzf)
+			load_assembly_from_compressed_file(assembly, fasta_file_path, fasta_index, contigs_to_load);
+		else
+			load_assembly_from_mapped_file(assembly, fasta_file_path, fasta_index, contigs_to_load);
+
+	} else {
+		load_assembly_sequentially(assembly, fasta_file_path, contigs, interesting_contigs);
+	}
 
 	// check if we found the sequence for all interesting contigs
 	for (contigs_t::const_iterator contig = interesting_contigs.begin(); contig != interesting_contigs.end(); ++contig)
@@ -2,6 +2,7 @@
 #define _ASSEMBLY_H 1
 
 #include <string>
+#include <vector>
 #include "common.hpp"
 
 using namespace std;
@@ -24,6 +25,24 @@ void dna_to_reverse_complement(const string& dna, string& reverse_complement);
 
 string dna_to_reverse_complement(const string& dna);
 
+// count the number of positions at which two sequences of the given length have the same base
+unsigned int count_matching_bases(const char* sequence1, const char* sequence2, const unsigned int length);
+
+// count the number of positions at which a read differs from the reference
+// positions with an N in the read are neither counted as mismatch nor as compared base
+void count_mismatching_bases(const char* read, const char* reference, const unsigned int length, unsigned int& mismatches, unsigned int& compared_bases);
+
+// record of a FastA index (.fai)
+struct fasta_index_record_t {
+	string name;
+	long unsigned int length; // number of bases in the contig
+	long unsigned int offset; // offset of the first base in the file
+	long unsigned int line_bases; // number of bases per line
+	long unsigned int line_width; // number of bytes per line including the line break
+};
+
+bool read_fasta_index(const string& fasta_index_file_path, vector<fasta_index_record_t>& fasta_index);
+
 void load_assembly(assembly_t& assembly, const string& fasta_file_path, contigs_t& contigs, const contigs_t& interesting_contigs);
 
 #endif /* _ASSEMBLY_H */
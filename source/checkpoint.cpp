@@ -0,0 +1,275 @@
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include <zlib.h>
+#include "bgzf.h"
+#include "common.hpp"
+#include "coverage_file.hpp"
+#include "read_stats.hpp"
+#include "checkpoint.hpp"
+
+using namespace std;
+
+// the checkpoint file holds the state after the alignments have been read and annotated:
+// - magic bytes and version
+// - checksum of the genes of the annotation, because alignments refer to genes by ID
+// - names of all contigs in the order of their IDs
+// - coverage and number of mapped reads (see coverage_file.cpp)
+// - strandedness
+// - dummy genes made for alignments which do not overlap any annotated gene
+// - chimeric alignments including the filter which discarded them
+// it is a BGZF-compressed binary file, values are stored in the native byte order
+const char CHECKPOINT_MAGIC[8] = { 'A', 'R', 'R', 'I', 'B', 'A', 'C', 'P' };
+const uint8_t NO_FILTER = UINT8_MAX;
+
+// the gene IDs are only meaningful for the same annotation
+// dummy genes are excluded, since they are stored in the checkpoint
+uint32_t get_annotation_checksum(const gene_annotation_t& gene_annotation, const vector<string>& contigs_by_id) {
+	uLong checksum = crc32(0L, Z_NULL, 0);
+	for (gene_annotation_t::const_iterator gene = gene_annotation.begin(); gene != gene_annotation.end(); ++gene) {
+		if (gene->is_dummy)
+			continue;
+		const string& contig = contigs_by_id.at(gene->contig);
+		const uint8_t strand = gene->strand;
+		checksum = crc32(checksum, (const Bytef*) contig.data(), contig.size());
+		checksum = crc32(checksum, (const Bytef*) &gene->start, sizeof(gene->start));
+		checksum = crc32(checksum, (const Bytef*) &gene->end, sizeof(gene->end));
+		checksum = crc32(checksum, (const Bytef*) &strand, sizeof(strand));
+		checksum = crc32(checksum, (const Bytef*) gene->name.data(), gene->name.size());
+	}
+	return checksum;
+}
+
+vector<string> get_contigs_by_id(const contigs_t& contigs) {
+	vector<string> contigs_by_id(contigs.size());
+	for (contigs_t::const_iterator contig = contigs.begin(); contig != contigs.end(); ++contig)
+		contigs_by_id[contig->second] = contig->first;
+	return contigs_by_id;
+}
+
+void write_string(BGZF* file, const string& value, bool& failed) {
+	write_value<uint32_t>(file, value.size(), failed);
+	if (bgzf_write(file, value.data(), value.size()) != (ssize_t) value.size())
+		failed = true;
+}
+
+// reads values from the checkpoint file and keeps track of whether the end of the file was reached prematurely
+class checkpoint_reader_t {
+	public:
+		checkpoint_reader_t(BGZF* file): file(file), truncated(false) {};
+		template <class T> T read_value() {
+			T value = T();
+			if (!truncated && !::read_value<T>(file, value))
+				truncated = true;
+			return value;
+		};
+		string read_string() {
+			uint32_t length = read_value<uint32_t>();
+			string value(length, '\0');
+			if (truncated || bgzf_read(file, &value[0], length) != (ssize_t) length) {
+				truncated = true;
+				return "";
+			}
+			return value;
+		};
+		bool is_truncated() const { return truncated; };
+		void mark_truncated() { truncated = true; };
+	private:
+		BGZF* file;
+		bool truncated;
+};
+
+void save_checkpoint(const string& checkpoint_file, const chimeric_alignments_t& chimeric_alignments, const unsigned long int mapped_reads, const coverage_t& coverage, const strandedness_t strandedness, const contigs_t& contigs, const gene_annotation_t& gene_annotation) {
+
+	// write to temporary file first and rename it when done, so that an incomplete checkpoint is never loaded
+	const string temporary_file = checkpoint_file + ".tmp" + to_string(static_cast<long long int>(getpid()));
+	BGZF* file = bgzf_open(temporary_file.c_str(), "w");
+	if (file == NULL) {
+		cerr << "ERROR: failed to open checkpoint '" << checkpoint_file << "' for writing" << endl;
+		exit(1);
+	}
+
+	bool failed = false;
+	if (bgzf_write(file, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != sizeof(CHECKPOINT_MAGIC))
+		failed = true;
+	write_value<uint32_t>(file, CHECKPOINT_VERSION, failed);
+
+	const vector<string> contigs_by_id = get_contigs_by_id(contigs);
+	write_value<uint32_t>(file, get_annotation_checksum(gene_annotation, contigs_by_id), failed);
+	write_value<uint32_t>(file, contigs_by_id.size(), failed);
+	for (auto contig = contigs_by_id.begin(); contig != contigs_by_id.end(); ++contig)
+		write_string(file, *contig, failed);
+
+	write_coverage(file, coverage, contigs, mapped_reads, failed);
+	write_value<uint8_t>(file, strandedness, failed);
+
+	// dummy genes are appended to the annotation, so they come last
+	vector<gene_annotation_t::const_iterator> dummy_genes;
+	for (gene_annotation_t::const_iterator gene = gene_annotation.begin(); gene != gene_annotation.end(); ++gene)
+		if (gene->is_dummy)
+			dummy_genes.push_back(gene);
+	write_value<uint32_t>(file, dummy_genes.size(), failed);
+	for (auto gene = dummy_genes.begin(); gene != dummy_genes.end(); ++gene) {
+		write_value<uint16_t>(file, (**gene).contig, failed);
+		write_value<int32_t>(file, (**gene).start, failed);
+		write_value<int32_t>(file, (**gene).end, failed);
+		write_value<uint8_t>(file, (**gene).strand, failed);
+		write_string(file, (**gene).name, failed);
+		write_value<int32_t>(file, (**gene).exonic_length, failed);
+		write_value<uint8_t>(file, (**gene).is_protein_coding, failed);
+	}
+
+	// fragments are written in reverse order, because with libstdc++ inserting them in reverse order into
+	// a hash map with the same number of buckets restores the order in which they are iterated,
+	// such that the results of a resumed run are the same as those of an uninterrupted run
+	// the C++ standard does not guarantee this, so with other implementations of the standard library
+	// a resumed run may break ties between otherwise equivalent reads or fusions differently
+	vector<chimeric_alignments_t::const_iterator> fragments;
+	fragments.reserve(chimeric_alignments.size());
+	for (chimeric_alignments_t::const_iterator fragment = chimeric_alignments.begin(); fragment != chimeric_alignments.end(); ++fragment)
+		fragments.push_back(fragment);
+	write_value<uint64_t>(file, chimeric_alignments.bucket_count(), failed);
+	write_value<uint64_t>(file, fragments.size(), failed);
+	for (auto fragment = fragments.rbegin(); fragment != fragments.rend(); ++fragment) {
+		const mates_t& mates = (**fragment).second;
+		write_string(file, (**fragment).first, failed);
+		write_value<uint8_t>(file, mates.single_end, failed);
+		write_value<uint8_t>(file, (mates.filter == NULL) ? NO_FILTER : mates.filter - FILTER_NAMES, failed);
+		write_value<uint8_t>(file, mates.size(), failed);
+		for (mates_t::const_iterator mate = mates.begin(); mate != mates.end(); ++mate) {
+			write_value<uint8_t>(file, mate->supplementary | mate->first_in_pair << 1 | mate->exonic << 2 | mate->strand << 3 | mate->predicted_strand << 4 | mate->predicted_strand_ambiguous << 5, failed);
+			write_value<uint16_t>(file, mate->contig, failed);
+			write_value<int32_t>(file, mate->start, failed);
+			write_value<int32_t>(file, mate->end, failed);
+			write_value<uint32_t>(file, mate->cigar.size(), failed);
+			for (unsigned int i = 0; i < mate->cigar.size(); ++i)
+				write_value<uint32_t>(file, mate->cigar[i], failed);
+			write_string(file, mate->sequence.str(), failed);
+			write_value<uint32_t>(file, mate->genes.size(), failed);
+			for (gene_set_t::const_iterator gene = mate->genes.begin(); gene != mate->genes.end(); ++gene)
+				write_value<uint32_t>(file, (**gene).id, failed);
+		}
+	}
+
+	if (bgzf_close(file) != 0 || failed || rename(temporary_file.c_str(), checkpoint_file.c_str()) != 0) {
+		cerr << "ERROR: failed to write checkpoint '" << checkpoint_file << "'" << endl;
+		unlink(temporary_file.c_str());
+		exit(1);
+	}
+}
+
+// restores the state saved by save_checkpoint()
+// <contigs> and <gene_annotation> must have been loaded from the same annotation and assembly as in the run which saved the checkpoint,
+// contigs which were added when reading the alignments and dummy genes are added to them
+// returns the number of fragments which have not been discarded by a filter
+unsigned int load_checkpoint(const string& checkpoint_file, chimeric_alignments_t& chimeric_alignments, unsigned long int& mapped_reads, coverage_t& coverage, strandedness_t& strandedness, contigs_t& contigs, gene_annotation_t& gene_annotation) {
+
+	BGZF* file = bgzf_open(checkpoint_file.c_str(), "r");
+	if (file == NULL) {
+		cerr << "ERROR: failed to open checkpoint '" << checkpoint_file << "'" << endl;
+		exit(1);
+	}
+	checkpoint_reader_t checkpoint(file);
+
+	char magic[sizeof(CHECKPOINT_MAGIC)];
+	if (bgzf_read(file, magic, sizeof(magic)) != sizeof(magic) || memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) != 0 ||
+	    checkpoint.read_value<uint32_t>() != CHECKPOINT_VERSION || checkpoint.is_truncated()) {
+		cerr << "ERROR: '" << checkpoint_file << "' is not a checkpoint of this version of Arriba" << endl;
+		exit(1);
+	}
+
+	const uint32_t annotation_checksum = checkpoint.read_value<uint32_t>();
+	if (annotation_checksum != get_annotation_checksum(gene_annotation, get_contigs_by_id(contigs)) && !checkpoint.is_truncated()) {
+		cerr << "ERROR: checkpoint '" << checkpoint_file << "' was made with a different annotation" << endl;
+		exit(1);
+	}
+
+	// map the contig IDs of the checkpoint to ours, adding contigs which are not known yet
+	vector<contig_t> contig_ids(checkpoint.read_value<uint32_t>());
+	for (unsigned int i = 0; i < contig_ids.size() && !checkpoint.is_truncated(); ++i)
+		contig_ids[i] = contigs.insert(pair<string,contig_t>(checkpoint.read_string(), contigs.size())).first->second;
+	auto read_contig = [&]() -> contig_t {
+		const uint16_t contig = checkpoint.read_value<uint16_t>();
+		if (contig >= contig_ids.size()) {
+			checkpoint.mark_truncated();
+			return 0;
+		}
+		return contig_ids[contig];
+	};
+
+	if (!checkpoint.is_truncated() && !read_coverage(file, checkpoint_file, coverage, contigs, mapped_reads))
+		checkpoint.mark_truncated();
+	strandedness = checkpoint.read_value<uint8_t>();
+
+	// restore dummy genes and assign IDs to genes like at the end of the annotation step
+	unsigned int dummy_gene_count = checkpoint.read_value<uint32_t>();
+	for (unsigned int i = 0; i < dummy_gene_count && !checkpoint.is_truncated(); ++i) {
+		gene_annotation_record_t gene;
+		gene.contig = read_contig();
+		gene.start = checkpoint.read_value<int32_t>();
+		gene.end = checkpoint.read_value<int32_t>();
+		gene.strand = checkpoint.read_value<uint8_t>();
+		gene.name = checkpoint.read_string();
+		gene.exonic_length = checkpoint.read_value<int32_t>();
+		gene.is_dummy = true;
+		gene.is_protein_coding = checkpoint.read_value<uint8_t>();
+		gene_annotation.push_back(gene);
+	}
+	vector<gene_t> genes_by_id;
+	for (gene_annotation_t::iterator gene = gene_annotation.begin(); gene != gene_annotation.end(); ++gene) {
+		gene->id = genes_by_id.size();
+		genes_by_id.push_back(&(*gene));
+	}
+
+	// restore chimeric alignments
+	chimeric_alignments.rehash(checkpoint.read_value<uint64_t>());
+	uint64_t fragment_count = checkpoint.read_value<uint64_t>();
+	unsigned int remaining = 0;
+	for (uint64_t i = 0; i < fragment_count && !checkpoint.is_truncated(); ++i) {
+		mates_t& mates = chimeric_alignments[checkpoint.read_string()];
+		mates.single_end = checkpoint.read_value<uint8_t>();
+		const uint8_t filter = checkpoint.read_value<uint8_t>();
+		if (filter != NO_FILTER && filter >= FILTER_COUNT)
+			checkpoint.mark_truncated();
+		mates.filter = (filter == NO_FILTER || filter >= FILTER_COUNT) ? NULL : get_filter((filter_id_t) filter);
+		if (mates.filter == NULL)
+			remaining++;
+		mates.resize(checkpoint.read_value<uint8_t>());
+		for (mates_t::iterator mate = mates.begin(); mate != mates.end() && !checkpoint.is_truncated(); ++mate) {
+			const uint8_t flags = checkpoint.read_value<uint8_t>();
+			mate->supplementary = flags & 1;
+			mate->first_in_pair = flags & 2;
+			mate->exonic = flags & 4;
+			mate->strand = flags & 8;
+			mate->predicted_strand = flags & 16;
+			mate->predicted_strand_ambiguous = flags & 32;
+			mate->contig = read_contig();
+			mate->start = checkpoint.read_value<int32_t>();
+			mate->end = checkpoint.read_value<int32_t>();
+			mate->cigar.resize(checkpoint.read_value<uint32_t>());
+			for (unsigned int j = 0; j < mate->cigar.size(); ++j)
+				mate->cigar[j] = checkpoint.read_value<uint32_t>();
+			mate->sequence = checkpoint.read_string();
+			unsigned int gene_count = checkpoint.read_value<uint32_t>();
+			for (unsigned int j = 0; j < gene_count && !checkpoint.is_truncated(); ++j) {
+				const uint32_t gene_id = checkpoint.read_value<uint32_t>();
+				if (gene_id < genes_by_id.size())
+					mate->genes.push_back(genes_by_id[gene_id]);
+				else
+					checkpoint.mark_truncated();
+			}
+			sort(mate->genes.begin(), mate->genes.end()); // gene sets are sorted by address, which differs from the run which saved the checkpoint
+		}
+	}
+
+	bgzf_close(file);
+	if (checkpoint.is_truncated()) {
+		cerr << "ERROR: checkpoint '" << checkpoint_file << "' is truncated or corrupt" << endl;
+		exit(1);
+	}
+
+	return remaining;
+}
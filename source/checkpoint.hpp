@@ -0,0 +1,17 @@
+#ifndef _CHECKPOINT_H
+#define _CHECKPOINT_H 1
+
+#include <string>
+#include "common.hpp"
+#include "read_stats.hpp"
+
+using namespace std;
+
+// increment whenever the layout of the checkpoint file changes
+const unsigned int CHECKPOINT_VERSION = 1;
+
+void save_checkpoint(const string& checkpoint_file, const chimeric_alignments_t& chimeric_alignments, const unsigned long int mapped_reads, const coverage_t& coverage, const strandedness_t strandedness, const contigs_t& contigs, const gene_annotation_t& gene_annotation);
+
+unsigned int load_checkpoint(const string& checkpoint_file, chimeric_alignments_t& chimeric_alignments, unsigned long int& mapped_reads, coverage_t& coverage, strandedness_t& strandedness, contigs_t& contigs, gene_annotation_t& gene_annotation);
+
+#endif /* _CHECKPOINT_H */
@@ -1,10 +1,14 @@
 #ifndef _COMMON_H
 #define _COMMON_H 1
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <list>
 #include <map>
 #include <string>
 #include <set>
+#include <stdexcept>
 #include <tuple>
 #include <type_traits>
 #include <unordered_map>
@@ -17,8 +21,46 @@ typedef bool strand_t;
 const strand_t FORWARD = true;
 const strand_t REVERSE = false;
 
+// filters are represented by pointers to the name of the filter (this saves memory compared to storing strings)
 typedef const string* filter_t;
-extern unordered_map<string,filter_t> FILTERS;
+// in the code, filters are referred to by ID, the names are only needed for option parsing and output
+enum filter_id_t {
+	FILTER_INCONSISTENTLY_CLIPPED,
+	FILTER_HOMOPOLYMER,
+	FILTER_DUPLICATES,
+	FILTER_READ_THROUGH,
+	FILTER_SAME_GENE,
+	FILTER_SMALL_INSERT_SIZE,
+	FILTER_LONG_GAP,
+	FILTER_HAIRPIN,
+	FILTER_MISMATCHES,
+	FILTER_MISMAPPERS,
+	FILTER_RELATIVE_SUPPORT,
+	FILTER_INTRONIC,
+	FILTER_NON_CODING_NEIGHBORS,
+	FILTER_INTRAGENIC_EXONIC,
+	FILTER_MIN_SUPPORT,
+	FILTER_KNOWN_FUSIONS,
+	FILTER_SPLICED,
+	FILTER_BLACKLIST,
+	FILTER_END_TO_END,
+	FILTER_PCR_FUSIONS,
+	FILTER_MERGE_ADJACENT,
+	FILTER_SELECT_BEST,
+	FILTER_SHORT_ANCHOR,
+	FILTER_NO_COVERAGE,
+	FILTER_MANY_SPLICED,
+	FILTER_NO_GENOMIC_SUPPORT,
+	FILTER_UNINTERESTING_CONTIGS,
+	FILTER_GENOMIC_SUPPORT,
+	FILTER_ISOFORMS,
+	FILTER_LOW_ENTROPY,
+	FILTER_HOMOLOGS,
+	FILTER_COUNT
+};
+extern const string FILTER_NAMES[FILTER_COUNT];
+extern unordered_map<string,filter_t> FILTERS; // look up filters by name
+inline filter_t get_filter(const filter_id_t filter_id) { return &FILTER_NAMES[filter_id]; }
 
 typedef short int contig_t;
 typedef unordered_map<string,contig_t> contigs_t;
@@ -57,7 +99,70 @@ template <class T> class annotation_set_t: public vector<T> {
 		using vector<T>::insert;
 };
 template <class T> class annotation_t: public list<T> {};
-template <class T> class contig_annotation_index_t: public map< position_t, annotation_set_t<T> > {};
+
+// features overlapping a region of an annotation index
+// the features are not copied, the view merely points to a range in the feature array of the index
+template <class T> class annotation_view_t {
+	public:
+		typedef typename vector<T>::const_iterator const_iterator;
+		typedef const_iterator iterator;
+		annotation_view_t(const const_iterator first, const const_iterator last): first_feature(first), last_feature(last) {};
+		const_iterator begin() const { return first_feature; };
+		const_iterator end() const { return last_feature; };
+		bool empty() const { return first_feature == last_feature; };
+		unsigned int size() const { return last_feature - first_feature; };
+	private:
+		const_iterator first_feature, last_feature;
+};
+
+// sorted array of disjunct regions of a contig, each region is identified by its last position (just like the keys of a map)
+// the features overlapping the regions are stored consecutively in a single array, which the regions point to
+template <class T> class contig_annotation_index_t {
+	public:
+		typedef pair< position_t, annotation_view_t<T> > value_type;
+		typedef typename vector<value_type>::const_iterator const_iterator;
+		typedef const_iterator iterator;
+		typedef typename vector<value_type>::const_reverse_iterator const_reverse_iterator;
+		typedef const_reverse_iterator reverse_iterator;
+		contig_annotation_index_t() {};
+		contig_annotation_index_t(const contig_annotation_index_t& x): features(x.features), region_ends(x.region_ends), regions(x.regions) { rebase_views(); };
+		contig_annotation_index_t(contig_annotation_index_t&& x) noexcept = default; // moving keeps the buffer of <features>, so the views remain valid
+		contig_annotation_index_t& operator = (const contig_annotation_index_t& x) { features = x.features; region_ends = x.region_ends; regions = x.regions; rebase_views(); return *this; };
+		contig_annotation_index_t& operator = (contig_annotation_index_t&& x) noexcept = default;
+		// regions must be appended in ascending order of their last position
+		// the index can only be queried after all regions have been appended and make_views() has been called
+		template <class I> void append_region(const position_t last_position, I first_feature, I last_feature) {
+			features.insert(features.end(), first_feature, last_feature);
+			region_ends.push_back(features.size());
+			region_positions.push_back(last_position);
+		};
+		void make_views() {
+			regions.clear();
+			regions.reserve(region_positions.size());
+			for (unsigned int region = 0; region < region_positions.size(); ++region)
+				regions.push_back(value_type(region_positions[region], annotation_view_t<T>(features.begin() + ((region == 0) ? 0 : region_ends[region-1]), features.begin() + region_ends[region])));
+			vector<position_t>().swap(region_positions); // free memory
+		};
+		const_iterator begin() const { return regions.begin(); };
+		const_iterator end() const { return regions.end(); };
+		const_reverse_iterator rbegin() const { return regions.rbegin(); };
+		const_reverse_iterator rend() const { return regions.rend(); };
+		bool empty() const { return regions.empty(); };
+		unsigned int size() const { return regions.size(); };
+		// find the region containing the given position
+		const_iterator lower_bound(const position_t position) const {
+			return std::lower_bound(regions.begin(), regions.end(), position, [](const value_type& region, const position_t position) { return region.first < position; });
+		};
+	private:
+		vector<T> features; // features overlapping the regions, concatenated in the order of the regions
+		vector<unsigned int> region_ends; // offset into <features> after the last feature of each region
+		vector<position_t> region_positions; // only needed while the index is built
+		vector<value_type> regions;
+		void rebase_views() { // make views point to our own copy of the features
+			for (unsigned int region = 0; region < regions.size(); ++region)
+				regions[region].second = annotation_view_t<T>(features.begin() + ((region == 0) ? 0 : region_ends[region-1]), features.begin() + region_ends[region]);
+		};
+};
 template <class T> class annotation_index_t: public vector< contig_annotation_index_t<T> > {};
 
 struct gene_annotation_record_t: public annotation_record_t {
@@ -69,6 +174,7 @@ struct gene_annotation_record_t: public annotation_record_t {
 };
 typedef gene_annotation_record_t* gene_t;
 typedef annotation_set_t<gene_t> gene_set_t;
+typedef annotation_view_t<gene_t> gene_view_t;
 typedef annotation_t<gene_annotation_record_t> gene_annotation_t;
 typedef contig_annotation_index_t<gene_t> gene_contig_annotation_index_t;
 typedef annotation_index_t<gene_t> gene_annotation_index_t;
@@ -89,14 +195,109 @@ struct exon_annotation_record_t: public annotation_record_t {
 };
 typedef exon_annotation_record_t* exon_t;
 typedef annotation_set_t<exon_t> exon_set_t;
+typedef annotation_view_t<exon_t> exon_view_t;
 typedef annotation_t<exon_annotation_record_t> exon_annotation_t;
 typedef contig_annotation_index_t<exon_t> exon_contig_annotation_index_t;
 typedef annotation_index_t<exon_t> exon_annotation_index_t;
 
-class cigar_t: public vector<uint32_t> {
+// CIGAR strings of RNA-Seq reads rarely have more than a handful of elements,
+// so they are stored inline and only long CIGAR strings are put on the heap
+class cigar_t {
+	private:
+		static const unsigned int INLINE_CAPACITY = 7;
+		uint32_t count;
+		union {
+			uint32_t inline_elements[INLINE_CAPACITY];
+			uint32_t* heap_elements;
+		};
+		uint32_t* elements() { return (count <= INLINE_CAPACITY) ? inline_elements : heap_elements; };
+		const uint32_t* elements() const { return (count <= INLINE_CAPACITY) ? inline_elements : heap_elements; };
+		void release() { if (count > INLINE_CAPACITY) delete[] heap_elements; count = 0; };
+		void copy(const cigar_t& x) {
+			count = x.count;
+			if (count > INLINE_CAPACITY)
+				heap_elements = new uint32_t[count];
+			memcpy(elements(), x.elements(), count * sizeof(uint32_t));
+		};
+	public:
+		cigar_t(): count(0) {};
+		cigar_t(const cigar_t& x) { copy(x); };
+		cigar_t(cigar_t&& x) noexcept: count(x.count) { memcpy(inline_elements, x.inline_elements, sizeof(inline_elements)); x.count = 0; };
+		~cigar_t() { release(); };
+		cigar_t& operator = (const cigar_t& x) { if (this != &x) { release(); copy(x); } return *this; };
+		cigar_t& operator = (cigar_t&& x) noexcept { if (this != &x) { release(); count = x.count; memcpy(inline_elements, x.inline_elements, sizeof(inline_elements)); x.count = 0; } return *this; };
+		unsigned int size() const { return count; };
+		void resize(const unsigned int new_size) { // like vector::resize(), existing elements are preserved and new elements are zero
+			uint32_t* old_elements = elements();
+			const unsigned int old_size = count;
+			if (new_size <= INLINE_CAPACITY) {
+				if (old_size > INLINE_CAPACITY) { // move elements from the heap back inline (this overwrites <heap_elements>)
+					memcpy(inline_elements, old_elements, new_size * sizeof(uint32_t));
+					delete[] old_elements;
+				}
+			} else if (new_size > old_size) { // allocate a bigger array on the heap
+				uint32_t* new_elements = new uint32_t[new_size];
+				memcpy(new_elements, old_elements, old_size * sizeof(uint32_t));
+				if (old_size > INLINE_CAPACITY)
+					delete[] old_elements;
+				heap_elements = new_elements;
+			} // else the array on the heap is big enough
+			count = new_size;
+			if (new_size > old_size)
+				memset(elements() + old_size, 0, (new_size - old_size) * sizeof(uint32_t));
+		};
+		uint32_t& operator [] (const unsigned int index) { return elements()[index]; };
+		uint32_t operator [] (const unsigned int index) const { return elements()[index]; };
+		uint32_t at(const unsigned int index) const {
+			if (index >= count)
+				throw out_of_range("cigar_t::at");
+			return elements()[index];
+		};
+		uint32_t operation(unsigned int index) const { return at(index) & 15; }; // select lower 4 bits to get the operation of the CIGAR element
+		uint32_t op_length(unsigned int index) const { return at(index) >> 4; }; // remove lower 4 bits to get the length of the CIGAR element
+};
+
+// read sequences are packed into 4 bits per base like in BAM files (the encoding of htslib is used),
+// which halves the memory consumed by the sequences and represents N and all other IUPAC codes
+// the sequence is unpacked into a string via str() or substr() where string functions are needed,
+// hot paths should use unpack() with a buffer that is reused, since str() and substr() allocate memory on every call
+class sequence_t {
+	private:
+		string packed; // two bases per byte, the first base in the upper 4 bits
+		uint32_t bases;
+		unsigned int code(const size_t position) const { return ((unsigned char) packed[position>>1] >> ((~position&1)<<2)) & 15; };
 	public:
-		uint32_t operation(unsigned int index) const { return this->at(index) & 15; }; // select lower 4 bits to get the operation of the CIGAR element
-		uint32_t op_length(unsigned int index) const { return this->at(index) >> 4; }; // remove lower 4 bits to get the length of the CIGAR element
+		sequence_t(): bases(0) {};
+		sequence_t& operator = (const string& sequence) {
+			bases = sequence.size();
+			packed.assign((bases + 1) / 2, '\0');
+			for (size_t position = 0; position < bases; ++position)
+				packed[position>>1] |= seq_nt16_table[(unsigned char) sequence[position]] << ((~position&1)<<2);
+			return *this;
+		};
+		void assign_packed(const uint8_t* packed_sequence, const uint32_t length) { // copies a sequence as it is stored in a BAM record
+			bases = length;
+			packed.assign((const char*) packed_sequence, (bases + 1) / 2);
+		};
+		size_t size() const { return bases; };
+		size_t length() const { return bases; };
+		bool empty() const { return bases == 0; };
+		void clear() { bases = 0; packed.clear(); };
+		char operator [] (const size_t position) const { return seq_nt16_str[code(position)]; };
+		const string& unpack(string& sequence, const size_t position = 0, const size_t length = string::npos) const { // overwrites <sequence> and returns it
+			if (position > bases)
+				throw out_of_range("sequence_t::unpack");
+			sequence.resize(min(length, bases - position));
+			for (size_t i = 0; i < sequence.size(); ++i)
+				sequence[i] = (*this)[position + i];
+			return sequence;
+		};
+		string substr(const size_t position = 0, const size_t length = string::npos) const {
+			string sequence;
+			unpack(sequence, position, length);
+			return sequence;
+		};
+		string str() const { return substr(); };
 };
 
 struct alignment_t {
@@ -110,7 +311,7 @@ struct alignment_t {
 	position_t start;
 	position_t end;
 	cigar_t cigar;
-	string sequence;
+	sequence_t sequence;
 	gene_set_t genes;
 	alignment_t(): supplementary(false), first_in_pair(false), exonic(false), predicted_strand_ambiguous(true) {};
 	unsigned int preclipping() const { return (cigar.operation(0) == BAM_CSOFT_CLIP || cigar.operation(0) == BAM_CHARD_CLIP) ? cigar.op_length(0) : 0; };
@@ -187,6 +388,8 @@ const strandedness_t STRANDEDNESS_REVERSE = 2;
 const strandedness_t STRANDEDNESS_AUTO = 3;
 
 // implement hash() function for tuples so they can be used as keys in unordered_maps
+// the hash of each element is merged into the hash of the preceding elements and the result is scrambled with the finalizer of MurmurHash3,
+// because keys often differ only in a few low bits (e.g., nearby breakpoints), which would otherwise end up in the same buckets
 namespace std {
 
 #define TUPLE_TYPES std::tuple<TT...>
@@ -194,12 +397,28 @@ namespace std {
 
         template <typename ... TT> struct hash< TUPLE_TYPES > {
 
-		size_t operator()(const TUPLE_TYPES& tuple, std::integral_constant<int, std::tuple_size< TUPLE_TYPES >::value>) const {
-			return 0;
+		size_t operator()(const TUPLE_TYPES& tuple) const {
+			return combine(0, tuple, std::integral_constant<int,0>());
+		}
+
+	private:
+
+		static size_t mix(uint64_t value) {
+			value ^= value >> 33;
+			value *= 0xff51afd7ed558ccdULL;
+			value ^= value >> 33;
+			value *= 0xc4ceb9fe1a85ec53ULL;
+			value ^= value >> 33;
+			return value;
 		}
-    
-		template<int element = 0> size_t operator()(const TUPLE_TYPES& tuple, std::integral_constant<int,element> = std::integral_constant<int,0>()) const {
-			return std::hash< typename TUPLE_ELEMENT_TYPE >()(std::get<element>(tuple)) ^ operator()(tuple, std::integral_constant<int,element+1>()) <<4;
+
+		size_t combine(const uint64_t seed, const TUPLE_TYPES& tuple, std::integral_constant<int, std::tuple_size< TUPLE_TYPES >::value>) const {
+			return seed;
+		}
+
+		template<int element> size_t combine(const uint64_t seed, const TUPLE_TYPES& tuple, std::integral_constant<int,element>) const {
+			const uint64_t element_hash = std::hash< typename TUPLE_ELEMENT_TYPE >()(std::get<element>(tuple));
+			return combine(mix(seed ^ (element_hash + 0x9e3779b97f4a7c15ULL)), tuple, std::integral_constant<int,element+1>());
 		}
 	};
 
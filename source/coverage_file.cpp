@@ -0,0 +1,204 @@
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "bgzf.h"
+#include "common.hpp"
+#include "read_stats.hpp"
+#include "coverage_file.hpp"
+
+using namespace std;
+
+// the coverage file is a BGZF-compressed binary file with the following layout:
+// - magic bytes and version
+// followed by the section written by write_coverage(), which is also embedded in checkpoint files:
+// - number of mapped reads
+// - number of contigs, and for each contig its name, its number of windows and its number of allocated pages
+// - for each allocated page its index, whether it has 16-bit counters, the counters and the bitsets of fragment starts/ends
+const char COVERAGE_FILE_MAGIC[8] = { 'A', 'R', 'R', 'I', 'B', 'A', 'C', 'V' };
+
+template <size_t N> void write_bitset(BGZF* file, const bitset<N>& bits, bool& failed) {
+	for (size_t byte = 0; byte < N / 8; ++byte) {
+		uint8_t value = 0;
+		for (unsigned int bit = 0; bit < 8; ++bit)
+			if (bits[byte * 8 + bit])
+				value |= 1 << bit;
+		write_value<uint8_t>(file, value, failed);
+	}
+}
+
+template <size_t N> bool read_bitset(BGZF* file, bitset<N>& bits) {
+	for (size_t byte = 0; byte < N / 8; ++byte) {
+		uint8_t value;
+		if (!read_value<uint8_t>(file, value))
+			return false;
+		for (unsigned int bit = 0; bit < 8; ++bit)
+			bits[byte * 8 + bit] = value & (1 << bit);
+	}
+	return true;
+}
+
+void write_coverage(BGZF* file, const coverage_t& coverage, const contigs_t& contigs, const unsigned long int mapped_reads, bool& failed) {
+
+	write_value<uint64_t>(file, mapped_reads, failed);
+
+	// contigs are stored by name, because contig IDs depend on the order of the input files
+	vector<contigs_t::const_iterator> covered_contigs;
+	for (contigs_t::const_iterator contig = contigs.begin(); contig != contigs.end(); ++contig)
+		if ((unsigned int) contig->second < coverage.windows.size() && coverage.windows[contig->second] > 0)
+			covered_contigs.push_back(contig);
+	write_value<uint32_t>(file, covered_contigs.size(), failed);
+	for (auto contig = covered_contigs.begin(); contig != covered_contigs.end(); ++contig) {
+		const vector<coverage_t::page_t*>& pages = coverage.pages[(**contig).second];
+		write_value<uint32_t>(file, (**contig).first.size(), failed);
+		if (bgzf_write(file, (**contig).first.data(), (**contig).first.size()) != (ssize_t) (**contig).first.size())
+			failed = true;
+		write_value<uint32_t>(file, coverage.windows[(**contig).second], failed);
+
+		uint32_t allocated_pages = 0;
+		for (auto page = pages.begin(); page != pages.end(); ++page)
+			if (*page != NULL)
+				allocated_pages++;
+		write_value<uint32_t>(file, allocated_pages, failed);
+
+		for (unsigned int page_index = 0; page_index < pages.size(); ++page_index) {
+			const coverage_t::page_t* page = pages[page_index];
+			if (page == NULL)
+				continue;
+			write_value<uint32_t>(file, page_index, failed);
+			write_value<uint8_t>(file, !page->wide_coverage.empty(), failed);
+			if (page->wide_coverage.empty()) {
+				if (bgzf_write(file, page->coverage, sizeof(page->coverage)) != sizeof(page->coverage))
+					failed = true;
+			} else {
+				for (auto window = page->wide_coverage.begin(); window != page->wide_coverage.end(); ++window)
+					write_value<uint16_t>(file, *window, failed);
+			}
+			write_bitset(file, page->fragment_starts, failed);
+			write_bitset(file, page->fragment_ends, failed);
+		}
+	}
+}
+
+void save_coverage(const string& coverage_file, const coverage_t& coverage, const contigs_t& contigs, const unsigned long int mapped_reads) {
+
+	// write to temporary file first and rename it when done, so that an incomplete file is never loaded
+	const string temporary_file = coverage_file + ".tmp" + to_string(static_cast<long long int>(getpid()));
+	BGZF* file = bgzf_open(temporary_file.c_str(), "w");
+	if (file == NULL) {
+		cerr << "ERROR: failed to open coverage file '" << coverage_file << "' for writing" << endl;
+		exit(1);
+	}
+
+	bool failed = false;
+	if (bgzf_write(file, COVERAGE_FILE_MAGIC, sizeof(COVERAGE_FILE_MAGIC)) != sizeof(COVERAGE_FILE_MAGIC))
+		failed = true;
+	write_value<uint32_t>(file, COVERAGE_FILE_VERSION, failed);
+	write_coverage(file, coverage, contigs, mapped_reads, failed);
+
+	if (bgzf_close(file) != 0 || failed || rename(temporary_file.c_str(), coverage_file.c_str()) != 0) {
+		cerr << "ERROR: failed to write coverage file '" << coverage_file << "'" << endl;
+		unlink(temporary_file.c_str());
+		exit(1);
+	}
+}
+
+// <coverage> must have been constructed from the same assembly and interesting contigs as the coverage file
+// returns false, if the file is truncated
+bool read_coverage(BGZF* file, const string& coverage_file, coverage_t& coverage, const contigs_t& contigs, unsigned long int& mapped_reads) {
+
+	bool truncated = false;
+	uint64_t stored_mapped_reads;
+	uint32_t contig_count;
+	truncated = !read_value<uint64_t>(file, stored_mapped_reads) || !read_value<uint32_t>(file, contig_count);
+	mapped_reads = stored_mapped_reads;
+
+	unsigned int loaded_contigs = 0;
+	for (uint32_t i = 0; i < contig_count && !truncated; ++i) {
+
+		uint32_t name_length;
+		if (!read_value<uint32_t>(file, name_length)) {
+			truncated = true;
+			break;
+		}
+		string name(name_length, '\0');
+		uint32_t windows, allocated_pages;
+		if (bgzf_read(file, &name[0], name_length) != (ssize_t) name_length || !read_value<uint32_t>(file, windows) || !read_value<uint32_t>(file, allocated_pages)) {
+			truncated = true;
+			break;
+		}
+
+		// the windows of every contig must match those of the given assembly
+		contigs_t::const_iterator contig = contigs.find(name);
+		if (contig == contigs.end() || (unsigned int) contig->second >= coverage.windows.size() || coverage.windows[contig->second] != windows) {
+			cerr << "ERROR: coverage file '" << coverage_file << "' was made from a different assembly or with different interesting contigs (contig '" << name << "' does not match)" << endl;
+			exit(1);
+		}
+		loaded_contigs++;
+
+		vector<coverage_t::page_t*>& pages = coverage.pages[contig->second];
+		for (uint32_t j = 0; j < allocated_pages && !truncated; ++j) {
+			uint32_t page_index;
+			uint8_t is_wide;
+			if (!read_value<uint32_t>(file, page_index) || !read_value<uint8_t>(file, is_wide) || page_index >= pages.size()) {
+				truncated = true;
+				break;
+			}
+			if (pages[page_index] == NULL)
+				pages[page_index] = new coverage_t::page_t();
+			coverage_t::page_t* page = pages[page_index];
+			if (!is_wide) {
+				truncated = bgzf_read(file, page->coverage, sizeof(page->coverage)) != sizeof(page->coverage);
+			} else {
+				page->wide_coverage.resize(COVERAGE_PAGE_SIZE);
+				for (auto window = page->wide_coverage.begin(); window != page->wide_coverage.end() && !truncated; ++window) {
+					uint16_t value;
+					truncated = !read_value<uint16_t>(file, value);
+					*window = value;
+				}
+			}
+			truncated = truncated || !read_bitset(file, page->fragment_starts) || !read_bitset(file, page->fragment_ends);
+		}
+	}
+
+	if (truncated)
+		return false;
+
+	// all contigs of the assembly must be in the coverage file
+	unsigned int covered_contigs = 0;
+	for (auto windows = coverage.windows.begin(); windows != coverage.windows.end(); ++windows)
+		if (*windows > 0)
+			covered_contigs++;
+	if (loaded_contigs != covered_contigs) {
+		cerr << "ERROR: coverage file '" << coverage_file << "' was made from a different assembly or with different interesting contigs" << endl;
+		exit(1);
+	}
+
+	return true;
+}
+
+void load_coverage(const string& coverage_file, coverage_t& coverage, const contigs_t& contigs, unsigned long int& mapped_reads) {
+
+	BGZF* file = bgzf_open(coverage_file.c_str(), "r");
+	if (file == NULL) {
+		cerr << "ERROR: failed to open coverage file '" << coverage_file << "'" << endl;
+		exit(1);
+	}
+
+	char magic[sizeof(COVERAGE_FILE_MAGIC)];
+	uint32_t version;
+	if (bgzf_read(file, magic, sizeof(magic)) != sizeof(magic) || memcmp(magic, COVERAGE_FILE_MAGIC, sizeof(magic)) != 0 ||
+	    !read_value<uint32_t>(file, version) || version != COVERAGE_FILE_VERSION) {
+		cerr << "ERROR: '" << coverage_file << "' is not a coverage file of this version of Arriba" << endl;
+		exit(1);
+	}
+
+	const bool complete = read_coverage(file, coverage_file, coverage, contigs, mapped_reads);
+	bgzf_close(file);
+	if (!complete) {
+		cerr << "ERROR: coverage file '" << coverage_file << "' is truncated or corrupt" << endl;
+		exit(1);
+	}
+}
@@ -0,0 +1,32 @@
+#ifndef _COVERAGE_FILE_H
+#define _COVERAGE_FILE_H 1
+
+#include <string>
+#include "bgzf.h"
+#include "common.hpp"
+#include "read_stats.hpp"
+
+using namespace std;
+
+// increment whenever the layout of the coverage file changes
+const unsigned int COVERAGE_FILE_VERSION = 1;
+
+template <class T> void write_value(BGZF* file, const T value, bool& failed) {
+	if (bgzf_write(file, &value, sizeof(T)) != sizeof(T))
+		failed = true;
+}
+
+template <class T> bool read_value(BGZF* file, T& value) {
+	return bgzf_read(file, &value, sizeof(T)) == sizeof(T);
+}
+
+// read/write the coverage from/to an open file, such that it can be embedded in other files
+void write_coverage(BGZF* file, const coverage_t& coverage, const contigs_t& contigs, const unsigned long int mapped_reads, bool& failed);
+
+bool read_coverage(BGZF* file, const string& coverage_file, coverage_t& coverage, const contigs_t& contigs, unsigned long int& mapped_reads);
+
+void save_coverage(const string& coverage_file, const coverage_t& coverage, const contigs_t& contigs, const unsigned long int mapped_reads);
+
+void load_coverage(const string& coverage_file, coverage_t& coverage, const contigs_t& contigs, unsigned long int& mapped_reads);
+
+#endif /* _COVERAGE_FILE_H */
@@ -21,7 +21,7 @@ unsigned int filter_both_intronic(fusions_t& fusions) {
 		if (!list_contains_exonic_reads(fusion->second.split_read1_list) &&
 		    !list_contains_exonic_reads(fusion->second.split_read2_list) &&
 		    !list_contains_exonic_reads(fusion->second.discordant_mate_list)) {
-			fusion->second.filter = FILTERS.at("intronic");
+			fusion->second.filter = get_filter(FILTER_INTRONIC);
 		} else {
 			++remaining;
 		}
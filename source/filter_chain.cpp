@@ -0,0 +1,77 @@
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "common.hpp"
+#include "parallel.hpp"
+#include "filter_chain.hpp"
+
+using namespace std;
+
+void add_read_filter(read_filter_chain_t& read_filter_chain, const filter_t filter, const string& description, const function<bool(const mates_t&)>& discard) {
+	read_filter_t read_filter;
+	read_filter.filter = filter;
+	read_filter.description = description;
+	read_filter.discard = discard;
+	read_filter.input = 0;
+	read_filter.remaining = 0;
+	read_filter.time = 0;
+	read_filter_chain.push_back(read_filter);
+}
+
+// apply all filters of the chain to each fragment in a single pass over <chimeric_alignments>
+// the filters are applied in the order in which they were added to the chain and
+// a fragment is marked with the first filter which discards it, just as if the filters were run one after another
+// if <measure_time> is set, the time spent in each filter is recorded, too
+// returns the number of fragments which pass all filters
+unsigned int run_read_filter_chain(chimeric_alignments_t& chimeric_alignments, read_filter_chain_t& read_filter_chain, const unsigned int threads, const bool measure_time) {
+
+	// count the fragments discarded by each filter separately for each partition of the hash buckets
+	// index 0 holds the number of fragments which have not been filtered before the chain is run
+	const unsigned int buckets = chimeric_alignments.bucket_count();
+	const unsigned int partitions = (threads > 1) ? min(buckets, threads * 64) : 1;
+	vector< vector<unsigned int> > discarded(partitions, vector<unsigned int>(read_filter_chain.size() + 1));
+	vector< vector<double> > time(partitions, vector<double>((measure_time) ? read_filter_chain.size() : 0));
+	run_in_parallel(threads, partitions, [&](const unsigned int partition, const unsigned int thread_id) {
+		vector<unsigned int>& discarded_in_partition = discarded[partition];
+		vector<double>& time_in_partition = time[partition];
+		for (unsigned int bucket = (long unsigned int) partition * buckets / partitions; bucket < (long unsigned int) (partition+1) * buckets / partitions; ++bucket) {
+			for (auto chimeric_alignment = chimeric_alignments.begin(bucket); chimeric_alignment != chimeric_alignments.end(bucket); ++chimeric_alignment) {
+				if (chimeric_alignment->second.filter != NULL)
+					continue; // read has already been filtered
+				++discarded_in_partition[0];
+				for (unsigned int i = 0; i < read_filter_chain.size(); ++i) {
+					bool discard;
+					if (measure_time) {
+						const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+						discard = read_filter_chain[i].discard(chimeric_alignment->second);
+						time_in_partition[i] += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+					} else {
+						discard = read_filter_chain[i].discard(chimeric_alignment->second);
+					}
+					if (discard) {
+						chimeric_alignment->second.filter = read_filter_chain[i].filter;
+						++discarded_in_partition[i+1];
+						break; // the remaining filters need not be checked
+					}
+				}
+			}
+		}
+	});
+
+	// sum up the counts of the partitions in a fixed order and
+	// compute the number of fragments remaining after each filter
+	unsigned int remaining = 0;
+	for (unsigned int partition = 0; partition < partitions; ++partition)
+		remaining += discarded[partition][0];
+	for (unsigned int i = 0; i < read_filter_chain.size(); ++i) {
+		read_filter_chain[i].input = remaining;
+		for (unsigned int partition = 0; partition < partitions; ++partition)
+			remaining -= discarded[partition][i+1];
+		read_filter_chain[i].remaining = remaining;
+		if (measure_time)
+			for (unsigned int partition = 0; partition < partitions; ++partition)
+				read_filter_chain[i].time += time[partition][i];
+	}
+	return remaining;
+}
+
@@ -0,0 +1,26 @@
+#ifndef _FILTER_CHAIN_H
+#define _FILTER_CHAIN_H 1
+
+#include <functional>
+#include <string>
+#include <vector>
+#include "common.hpp"
+
+using namespace std;
+
+// a read-level filter which decides for each fragment individually, whether it should be discarded
+struct read_filter_t {
+	filter_t filter; // name which discarded fragments are marked with
+	string description; // what the filter does, used for logging
+	function<bool(const mates_t&)> discard; // predicate which returns true, if the fragment should be discarded
+	unsigned int input; // number of fragments which the filter was applied to
+	unsigned int remaining; // number of fragments remaining after the filter was applied
+	double time; // seconds spent in the predicate summed over all threads, only measured on demand
+};
+typedef vector<read_filter_t> read_filter_chain_t;
+
+void add_read_filter(read_filter_chain_t& read_filter_chain, const filter_t filter, const string& description, const function<bool(const mates_t&)>& discard);
+
+unsigned int run_read_filter_chain(chimeric_alignments_t& chimeric_alignments, read_filter_chain_t& read_filter_chain, const unsigned int threads, const bool measure_time = false);
+
+#endif /* _FILTER_CHAIN_H */
@@ -36,7 +36,7 @@ unsigned int filter_duplicates(chimeric_alignments_t& chimeric_alignments) {
 		}
 
 		if (duplicate_count[make_tuple(contig1, contig2, position1, position2)]++ > 0)
-			chimeric_alignment->second.filter = FILTERS.at("duplicates");
+			chimeric_alignment->second.filter = get_filter(FILTER_DUPLICATES);
 		else
 			++remaining;
 	}
@@ -24,7 +24,7 @@ unsigned int filter_end_to_end_fusions(fusions_t& fusions) {
 		    fusion->second.breakpoint_overlaps_both_genes() && (fusion->second.split_reads1 == 0 || fusion->second.split_reads2 == 0)) {
 			if ((fusion->second.gene1->is_dummy || (fusion->second.gene1->strand == FORWARD && fusion->second.direction1 == UPSTREAM) || (fusion->second.gene1->strand == REVERSE && fusion->second.direction1 == DOWNSTREAM)) &&
 			    (fusion->second.gene2->is_dummy || (fusion->second.gene2->strand == FORWARD && fusion->second.direction2 == UPSTREAM) || (fusion->second.gene2->strand == REVERSE && fusion->second.direction2 == DOWNSTREAM))) {
-				fusion->second.filter = FILTERS.at("end_to_end");
+				fusion->second.filter = get_filter(FILTER_END_TO_END);
 				continue;
 			}
 		}
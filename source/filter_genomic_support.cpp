@@ -333,7 +333,7 @@ unsigned int filter_no_genomic_support(fusions_t& fusions) {
 		if (fusion->second.filter == NULL) {
 			if (fusion->second.closest_genomic_breakpoint1 < 0 && // no genomic support
 			     fusion->second.confidence == CONFIDENCE_LOW)
-				fusion->second.filter = FILTERS.at("no_genomic_support");
+				fusion->second.filter = get_filter(FILTER_NO_GENOMIC_SUPPORT);
 			else
 				remaining++;
 		}
@@ -353,12 +353,12 @@ unsigned int recover_genomic_support(fusions_t& fusions) {
 		}
 
 		if (fusion->second.closest_genomic_breakpoint1 >= 0 && // fusion has genomic support
-		    (fusion->second.filter == FILTERS.at("end_to_end") ||
-		     fusion->second.filter == FILTERS.at("intronic") ||
-		     fusion->second.filter == FILTERS.at("mismappers") ||
-		     fusion->second.filter == FILTERS.at("no_coverage") ||
-		     fusion->second.filter == FILTERS.at("pcr_fusions") ||
-		     fusion->second.filter == FILTERS.at("relative_support"))) {
+		    (fusion->second.filter == get_filter(FILTER_END_TO_END) ||
+		     fusion->second.filter == get_filter(FILTER_INTRONIC) ||
+		     fusion->second.filter == get_filter(FILTER_MISMAPPERS) ||
+		     fusion->second.filter == get_filter(FILTER_NO_COVERAGE) ||
+		     fusion->second.filter == get_filter(FILTER_PCR_FUSIONS) ||
+		     fusion->second.filter == get_filter(FILTER_RELATIVE_SUPPORT))) {
 			fusion->second.filter = NULL;
 			remaining++;
 		}
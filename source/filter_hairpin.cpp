@@ -26,56 +26,35 @@ bool is_breakpoint_within_aligned_segment(const position_t breakpoint, const ali
 	return false;
 }
 
-unsigned int filter_hairpin(chimeric_alignments_t& chimeric_alignments, exon_annotation_index_t& exon_annotation_index, const int max_mate_gap) {
-
-	unsigned int remaining = 0;
-	for (chimeric_alignments_t::iterator chimeric_alignment = chimeric_alignments.begin(); chimeric_alignment != chimeric_alignments.end(); ++chimeric_alignment) {
-
-		if (chimeric_alignment->second.filter != NULL)
-			continue; // the read has already been filtered
-
-		// check if mate1 and mate2 map to the same gene or close to one another
-		gene_set_t common_genes;
-		if (chimeric_alignment->second.size() == 2) { // discordant mate
-			combine_annotations(chimeric_alignment->second[MATE1].genes, chimeric_alignment->second[MATE2].genes, common_genes, false);
-			if (common_genes.empty() && chimeric_alignment->second[MATE1].contig != chimeric_alignment->second[MATE2].contig) {
-				remaining++;
-				continue; // we are only interested in intragenic events
-			}
-		} else {// split read
-			combine_annotations(chimeric_alignment->second[SPLIT_READ].genes, chimeric_alignment->second[SUPPLEMENTARY].genes, common_genes, false);
-			if (common_genes.empty() && chimeric_alignment->second[SPLIT_READ].contig != chimeric_alignment->second[SUPPLEMENTARY].contig) {
-				remaining++;
-				continue; // we are only interested in intragenic events
-			}
-		}
-
-		if (chimeric_alignment->second.size() == 2) { // discordant mates
+bool is_hairpin(const mates_t& mates) {
+
+	// check if mate1 and mate2 map to the same gene or close to one another
+	gene_set_t common_genes;
+	if (mates.size() == 2) { // discordant mate
+		combine_annotations(mates[MATE1].genes, mates[MATE2].genes, common_genes, false);
+		if (common_genes.empty() && mates[MATE1].contig != mates[MATE2].contig)
+			return false; // we are only interested in intragenic events
+	} else {// split read
+		combine_annotations(mates[SPLIT_READ].genes, mates[SUPPLEMENTARY].genes, common_genes, false);
+		if (common_genes.empty() && mates[SPLIT_READ].contig != mates[SUPPLEMENTARY].contig)
+			return false; // we are only interested in intragenic events
+	}
 
-			position_t breakpoint1 = (chimeric_alignment->second[MATE1].strand == FORWARD) ? chimeric_alignment->second[MATE1].end : chimeric_alignment->second[MATE1].start;
-			position_t breakpoint2 = (chimeric_alignment->second[MATE2].strand == FORWARD) ? chimeric_alignment->second[MATE2].end : chimeric_alignment->second[MATE2].start;
+	if (mates.size() == 2) { // discordant mates
 
-			if (is_breakpoint_within_aligned_segment(breakpoint1, chimeric_alignment->second[MATE2]) ||
-			    is_breakpoint_within_aligned_segment(breakpoint2, chimeric_alignment->second[MATE1])) {
-				chimeric_alignment->second.filter = FILTERS.at("hairpin");
-				continue;
-			}
+		position_t breakpoint1 = (mates[MATE1].strand == FORWARD) ? mates[MATE1].end : mates[MATE1].start;
+		position_t breakpoint2 = (mates[MATE2].strand == FORWARD) ? mates[MATE2].end : mates[MATE2].start;
 
-		} else { // split read
+		return is_breakpoint_within_aligned_segment(breakpoint1, mates[MATE2]) ||
+		       is_breakpoint_within_aligned_segment(breakpoint2, mates[MATE1]);
 
-			position_t breakpoint_split_read = (chimeric_alignment->second[SPLIT_READ].strand == FORWARD) ? chimeric_alignment->second[SPLIT_READ].start : chimeric_alignment->second[SPLIT_READ].end;
-			position_t breakpoint_supplementary = (chimeric_alignment->second[SUPPLEMENTARY].strand == FORWARD) ? chimeric_alignment->second[SUPPLEMENTARY].end : chimeric_alignment->second[SUPPLEMENTARY].start;
-			if (is_breakpoint_within_aligned_segment(breakpoint_split_read, chimeric_alignment->second[SUPPLEMENTARY]) ||
-			    is_breakpoint_within_aligned_segment(breakpoint_supplementary, chimeric_alignment->second[SPLIT_READ]) ||
-			    is_breakpoint_within_aligned_segment(breakpoint_supplementary, chimeric_alignment->second[MATE1])) {
-				chimeric_alignment->second.filter = FILTERS.at("hairpin");
-				continue;
-			}
+	} else { // split read
 
-		}
+		position_t breakpoint_split_read = (mates[SPLIT_READ].strand == FORWARD) ? mates[SPLIT_READ].start : mates[SPLIT_READ].end;
+		position_t breakpoint_supplementary = (mates[SUPPLEMENTARY].strand == FORWARD) ? mates[SUPPLEMENTARY].end : mates[SUPPLEMENTARY].start;
+		return is_breakpoint_within_aligned_segment(breakpoint_split_read, mates[SUPPLEMENTARY]) ||
+		       is_breakpoint_within_aligned_segment(breakpoint_supplementary, mates[SPLIT_READ]) ||
+		       is_breakpoint_within_aligned_segment(breakpoint_supplementary, mates[MATE1]);
 
-		remaining++;
 	}
-	return remaining;
 }
-
@@ -5,6 +5,6 @@
 
 using namespace std;
 
-unsigned int filter_hairpin(chimeric_alignments_t& chimeric_alignments, exon_annotation_index_t& exon_annotation_index, const int max_mate_gap);
+bool is_hairpin(const mates_t& mates);
 
 #endif /* _FILTER_HAIRPIN_H */
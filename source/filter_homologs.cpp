@@ -1,16 +1,133 @@
+#include <algorithm>
+#include <climits>
 #include <cmath>
+#include <cstdint>
 #include <cstring>
 #include <list>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include "common.hpp"
 #include "annotation.hpp"
 #include "assembly.hpp"
 #include "filter_mismappers.hpp"
+#include "homology_cache.hpp"
 #include "filter_homologs.hpp"
 
 using namespace std;
 
-bool is_homolog(const gene_t gene1, const gene_t gene2, const kmer_indices_t& kmer_indices, const char kmer_length, const assembly_t& assembly, const float max_identity_fraction) {
+// k-mers of this length are compared by is_homolog(): the indexed k-mer plus its extension
+const char SKETCHED_KMER_LENGTH = 16;
+// only every SKETCH_SCALE-th k-mer (by hash value) is kept in a sketch
+const uint32_t SKETCH_SCALE = 16;
+// with fewer sampled k-mers, the estimated identity is not reliable enough to reject a pair of genes
+const unsigned int MIN_SAMPLED_TILES = 20;
+
+// 2-bit encoding of bases as in kmer_to_int()
+inline uint32_t base_to_int(const char base) {
+	switch (base) {
+		case 'T': return 0;
+		case 'G': return 1;
+		case 'C': return 2;
+		default:  return 3;
+	}
+}
+
+inline uint32_t complementary_base_to_int(const char base) {
+	switch (base) {
+		case 'A': return 0;
+		case 'C': return 1;
+		case 'G': return 2;
+		case 'T': return 3;
+		default:  return 3; // dna_to_complement() leaves other characters unchanged
+	}
+}
+
+// finalizer of MurmurHash3 to spread k-mers evenly over the range of hash values
+inline uint32_t hash_kmer(uint32_t kmer) {
+	kmer ^= kmer >> 16;
+	kmer *= 0x85ebca6b;
+	kmer ^= kmer >> 13;
+	kmer *= 0xc2b2ae35;
+	kmer ^= kmer >> 16;
+	return kmer;
+}
+
+// make a FracMinHash sketch of the 16-mers of the given gene
+// k-mers are canonicalized (the smaller of the k-mer and its reverse complement),
+// such that a sketch can be compared to the sketch of genes on either strand
+void make_gene_sketch(const gene_t gene, const assembly_t& assembly, const char kmer_length, gene_sketch_t& gene_sketch) {
+
+	const string& contig_sequence = assembly.at(gene->contig);
+	const int length = gene->length();
+
+	// calculate the hashes of all k-mers starting within the gene (including its last base), -1 marks k-mers which are not sampled
+	vector<int64_t> hashes(max(0, min(length + 1, (int) contig_sequence.size() - gene->start - SKETCHED_KMER_LENGTH + 1)), -1);
+	uint32_t forward_kmer = 0, reverse_kmer = 0;
+	for (int pos = 0; pos < (int) hashes.size() + SKETCHED_KMER_LENGTH - 1; ++pos) {
+		const char base = contig_sequence[gene->start + pos];
+		forward_kmer = (forward_kmer << 2) | base_to_int(base);
+		reverse_kmer = (reverse_kmer >> 2) | (complementary_base_to_int(base) << (2 * SKETCHED_KMER_LENGTH - 2));
+		if (pos >= SKETCHED_KMER_LENGTH - 1) {
+			const uint32_t hash = hash_kmer(min(forward_kmer, reverse_kmer));
+			if (hash <= UINT32_MAX / SKETCH_SCALE)
+				hashes[pos - SKETCHED_KMER_LENGTH + 1] = hash;
+		}
+	}
+
+	// k-mers which is_homolog() may find when the gene is the bigger of the two
+	// (those at the very end are only indexed, if an overlapping gene was indexed, too, but we cannot know that here)
+	for (int pos = 0; pos < (int) hashes.size(); ++pos)
+		if (hashes[pos] >= 0)
+			gene_sketch.kmers.push_back(hashes[pos]);
+	sort(gene_sketch.kmers.begin(), gene_sketch.kmers.end());
+	gene_sketch.kmers.erase(unique(gene_sketch.kmers.begin(), gene_sketch.kmers.end()), gene_sketch.kmers.end());
+
+	// k-mers which is_homolog() looks up when the gene is the smaller of the two,
+	// depending on whether its sequence is reverse-complemented or not
+	for (unsigned int orientation = 0; orientation < 2; ++orientation) {
+		gene_sketch.tile_count[orientation] = 0;
+		for (int pos = 0; pos + 2*kmer_length < length; pos += kmer_length) {
+			gene_sketch.tile_count[orientation]++;
+			const int kmer_start = (orientation == 0) ? pos : length - pos - SKETCHED_KMER_LENGTH;
+			if (kmer_start >= 0 && kmer_start < (int) hashes.size() && hashes[kmer_start] >= 0)
+				gene_sketch.tiles[orientation].push_back(hashes[kmer_start]);
+		}
+	}
+}
+
+const gene_sketch_t& get_gene_sketch(const gene_t gene, const assembly_t& assembly, const char kmer_length, gene_sketches_t& gene_sketches) {
+	gene_sketches_t::iterator gene_sketch = gene_sketches.find(gene);
+	if (gene_sketch == gene_sketches.end()) {
+		gene_sketch = gene_sketches.insert(make_pair(gene, gene_sketch_t())).first;
+		make_gene_sketch(gene, assembly, kmer_length, gene_sketch->second);
+	}
+	return gene_sketch->second;
+}
+
+// estimate from the sketches which fraction of the k-mers of the small gene is found in the big gene
+// and return false, if the fraction is very likely too small for the genes to be considered homologs
+// the estimate can only be too high, never too low (apart from sampling error),
+// because it ignores the orientation of k-mers and which k-mers is_homolog() excludes as overlapping
+bool may_be_homolog(const gene_sketch_t& small_gene_sketch, const unsigned int orientation, const gene_sketch_t& big_gene_sketch, const unsigned int required_tiles) {
+
+	const vector<uint32_t>& tiles = small_gene_sketch.tiles[orientation];
+	if (tiles.size() < MIN_SAMPLED_TILES)
+		return true; // too few samples to reject
+	const double required_fraction = min(1.0, ((double) required_tiles) / small_gene_sketch.tile_count[orientation]);
+
+	unsigned int matching_tiles = 0;
+	for (auto tile = tiles.begin(); tile != tiles.end(); ++tile)
+		if (binary_search(big_gene_sketch.kmers.begin(), big_gene_sketch.kmers.end(), *tile))
+			matching_tiles++;
+
+	// only reject when the number of matches is more than 4 standard deviations below what would be needed
+	const double expected_matches = required_fraction * tiles.size();
+	return matching_tiles + 1 >= expected_matches - 4 * sqrt(expected_matches * (1 - required_fraction));
+}
+
+bool is_homolog(const gene_t gene1, const gene_t gene2, const kmer_indices_t& kmer_indices, const char kmer_length, const assembly_t& assembly, const float max_identity_fraction, gene_sketches_t* gene_sketches) {
 
 	// we look for kmers of length <kmer_length> + <extended_kmer_length> that are present in both genes
 	const char extended_kmer_length = 8;
@@ -31,6 +148,13 @@ bool is_homolog(const gene_t gene1, const gene_t gene2, const kmer_indices_t& km
 	     small_gene->end   >= big_gene->start && small_gene->end   <= big_gene->end))
 		return false;
 
+	// quickly rule out most pairs of genes by comparing their sketches
+	if (gene_sketches != NULL &&
+	    !may_be_homolog(get_gene_sketch(small_gene, assembly, kmer_length, *gene_sketches), (small_gene->strand != big_gene->strand) ? 1 : 0,
+	                    get_gene_sketch(big_gene, assembly, kmer_length, *gene_sketches),
+	                    ceil(small_gene->length() * max_identity_fraction / kmer_length)))
+		return false;
+
 	// retrieve sequence of smaller gene
 	string small_gene_sequence = assembly.at(small_gene->contig).substr(small_gene->start, small_gene->length());
 	if (small_gene->strand != big_gene->strand)
@@ -43,16 +167,15 @@ bool is_homolog(const gene_t gene1, const gene_t gene2, const kmer_indices_t& km
 		if (matching_kmers * kmer_length + (small_gene_sequence.size() - pos) < small_gene->length() * max_identity_fraction)
 			return false; // abort early, if there is no way we can possibly reach max_identity_fraction
 
-		kmer_index_t::const_iterator kmer_hits = kmer_indices[big_gene->contig].find(kmer_to_int(small_gene_sequence, pos, kmer_length));
-		if (kmer_hits != kmer_indices[big_gene->contig].end()) {
-			for (auto kmer_hit = lower_bound(kmer_hits->second.begin(), kmer_hits->second.end(), big_gene->start); kmer_hit != kmer_hits->second.end() && *kmer_hit <= big_gene->end; ++kmer_hit) {
-				if (small_gene->contig != big_gene->contig || *kmer_hit < small_gene->start || *kmer_hit > small_gene->end) {
-					if (strncmp(assembly.at(big_gene->contig).c_str()+*kmer_hit+kmer_length, small_gene_sequence.c_str()+pos+kmer_length, extended_kmer_length) == 0) {
-						matching_kmers++;
-						if (matching_kmers * kmer_length >= small_gene->length() * max_identity_fraction)
-							return true;
-						break;
-					}
+		const kmer_as_int_t kmer = kmer_to_int(small_gene_sequence, pos, kmer_length);
+		const kmer_index_t::const_iterator kmer_hits_end = kmer_indices[big_gene->contig].end(kmer);
+		for (auto kmer_hit = lower_bound(kmer_indices[big_gene->contig].begin(kmer), kmer_hits_end, big_gene->start); kmer_hit != kmer_hits_end && *kmer_hit <= big_gene->end; ++kmer_hit) {
+			if (small_gene->contig != big_gene->contig || *kmer_hit < small_gene->start || *kmer_hit > small_gene->end) {
+				if (strncmp(assembly.at(big_gene->contig).c_str()+*kmer_hit+kmer_length, small_gene_sequence.c_str()+pos+kmer_length, extended_kmer_length) == 0) {
+					matching_kmers++;
+					if (matching_kmers * kmer_length >= small_gene->length() * max_identity_fraction)
+						return true;
+					break;
 				}
 			}
 		}
@@ -62,7 +185,40 @@ bool is_homolog(const gene_t gene1, const gene_t gene2, const kmer_indices_t& km
 	return false;
 }
 
-unsigned int filter_homologs(fusions_t& fusions, const kmer_indices_t& kmer_indices, const char kmer_length, const assembly_t& assembly, const float max_identity_fraction) {
+// make_kmer_index() does not index the k-mers at the very end of a gene, but they are indexed, when they belong to an overlapping gene
+// is_homolog() finds hits there, so its result then depends on which other genes are indexed
+bool has_indexed_kmers_at_end(const gene_t gene, const kmer_indices_t& kmer_indices, const char kmer_length, const assembly_t& assembly) {
+	if (gene->contig >= (int) kmer_indices.size())
+		return false;
+	const string& contig_sequence = assembly.at(gene->contig);
+	for (position_t pos = max(gene->start, gene->end - kmer_length); pos <= gene->end && pos + kmer_length <= (int) contig_sequence.size(); ++pos) {
+		const kmer_as_int_t kmer = kmer_to_int(contig_sequence, pos, kmer_length);
+		if (binary_search(kmer_indices[gene->contig].begin(kmer), kmer_indices[gene->contig].end(kmer), pos))
+			return true;
+	}
+	return false;
+}
+
+// look up the result of the homology check in the cache and only run the check, if the given pair of genes has not been checked before
+// the result is only cached, if it depends on nothing but the two genes, i.e., if both genes are indexed
+// and if the k-mers at the end of the bigger gene are not indexed for another gene
+bool is_homolog_cached(const gene_t gene1, const gene_t gene2, const kmer_indices_t& kmer_indices, const char kmer_length, const assembly_t& assembly, const float max_identity_fraction, const unordered_set<gene_t>& indexed_genes, gene_sketches_t* gene_sketches, homology_cache_t& homology_cache) {
+	if (gene1 == gene2)
+		return false;
+	if (indexed_genes.find(gene1) == indexed_genes.end() || indexed_genes.find(gene2) == indexed_genes.end() ||
+	    has_indexed_kmers_at_end((gene1->length() > gene2->length()) ? gene1 : gene2, kmer_indices, kmer_length, assembly))
+		return is_homolog(gene1, gene2, kmer_indices, kmer_length, assembly, max_identity_fraction, gene_sketches);
+	const gene_pair_coordinates_t gene_pair = get_gene_pair_coordinates(gene1, gene2);
+	auto cached_result = homology_cache.is_homolog.find(gene_pair);
+	if (cached_result != homology_cache.is_homolog.end())
+		return cached_result->second;
+	const bool result = is_homolog(gene1, gene2, kmer_indices, kmer_length, assembly, max_identity_fraction, gene_sketches);
+	homology_cache.is_homolog[gene_pair] = result;
+	homology_cache.new_entries++;
+	return result;
+}
+
+unsigned int filter_homologs(fusions_t& fusions, const kmer_indices_t& kmer_indices, const char kmer_length, const assembly_t& assembly, const float max_identity_fraction, const bool screen_homologs, homology_cache_t& homology_cache) {
 
 	// select non-discarded fusions for better speed,
 	// we need to iterate over them many times
@@ -71,15 +227,27 @@ unsigned int filter_homologs(fusions_t& fusions, const kmer_indices_t& kmer_indi
 		if (fusion->second.filter == NULL)
 			remaining_fusions.push_front(&fusion->second);
 
+	// sketches of genes are made on demand and reused for all pairs of genes, if pairs of genes are screened
+	gene_sketches_t gene_sketches;
+
+	// find genes which have been indexed by make_kmer_index()
+	unordered_set<gene_t> indexed_genes;
+	for (auto fusion = remaining_fusions.begin(); fusion != remaining_fusions.end(); ++fusion) {
+		if ((**fusion).gene1 != (**fusion).gene2) {
+			indexed_genes.insert((**fusion).gene1);
+			indexed_genes.insert((**fusion).gene2);
+		}
+	}
+
 	// discard fusion, if gene1 and gene2 are homologs
 	for (auto fusion = remaining_fusions.begin(); fusion != remaining_fusions.end(); ++fusion) {
 
 		if ((**fusion).filter != NULL)
 			continue;
 
-		if (is_homolog((**fusion).gene1, (**fusion).gene2, kmer_indices, kmer_length, assembly, max_identity_fraction)) {
+		if (is_homolog_cached((**fusion).gene1, (**fusion).gene2, kmer_indices, kmer_length, assembly, max_identity_fraction, indexed_genes, screen_homologs ? &gene_sketches : NULL, homology_cache)) {
 
-			(**fusion).filter = FILTERS.at("homologs");
+			(**fusion).filter = get_filter(FILTER_HOMOLOGS);
 
 		} else {
 
@@ -115,15 +283,15 @@ unsigned int filter_homologs(fusions_t& fusions, const kmer_indices_t& kmer_indi
 				unsigned int anchor2 = ((**other_fusion).split_reads1 > 0) + ((**other_fusion).split_reads2 > 0) + ((**other_fusion).discordant_mates > 0);
 
 				// check if the fusion partners geneB and geneC are homologs
-				if (is_homolog(homolog1, homolog2, kmer_indices, kmer_length, assembly, max_identity_fraction)) {
+				if (is_homolog_cached(homolog1, homolog2, kmer_indices, kmer_length, assembly, max_identity_fraction, indexed_genes, screen_homologs ? &gene_sketches : NULL, homology_cache)) {
 
 					// other event must have poorer alignments or fewer reads or a worse e-value for us to consider its supporting reads to be mismappers
 					if (anchor1 > anchor2 ||
 					    anchor1 == anchor2 && (**fusion).supporting_reads() > (**other_fusion).supporting_reads() ||
 					    anchor1 == anchor2 && (**fusion).supporting_reads() == (**other_fusion).supporting_reads() && (**fusion).evalue <= (**other_fusion).evalue) {
-						(**other_fusion).filter = FILTERS.at("homologs");
+						(**other_fusion).filter = get_filter(FILTER_HOMOLOGS);
 					} else {
-						(**fusion).filter = FILTERS.at("homologs");
+						(**fusion).filter = get_filter(FILTER_HOMOLOGS);
 						break;
 					}
 				}
@@ -1,12 +1,29 @@
 #ifndef _FILTER_HOMOLOGS_H
 #define _FILTER_HOMOLOGS_H 1
 
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
 #include "common.hpp"
 #include "assembly.hpp"
 #include "filter_mismappers.hpp"
+#include "homology_cache.hpp"
 
 using namespace std;
 
-unsigned int filter_homologs(fusions_t& fusions, const kmer_indices_t& kmer_indices, const char kmer_length, const assembly_t& assembly, const float max_identity_fraction);
+// sampled k-mers of a gene to estimate the sequence similarity between genes
+struct gene_sketch_t {
+	vector<uint32_t> kmers; // hashes of the sampled k-mers of the gene (sorted, unique)
+	vector<uint32_t> tiles[2]; // hashes of the sampled k-mers checked by is_homolog() in forward/reverse orientation
+	unsigned int tile_count[2]; // number of k-mers checked by is_homolog() in forward/reverse orientation (sampled or not)
+};
+typedef unordered_map<gene_t,gene_sketch_t> gene_sketches_t;
+
+// checks if the sequences of two genes are similar
+// the sketches of the genes are used to rule out most pairs quickly, pass NULL to skip this screen
+// the screen rejects pairs based on an estimate, so it may miss homologs in rare cases
+bool is_homolog(const gene_t gene1, const gene_t gene2, const kmer_indices_t& kmer_indices, const char kmer_length, const assembly_t& assembly, const float max_identity_fraction, gene_sketches_t* gene_sketches);
+
+unsigned int filter_homologs(fusions_t& fusions, const kmer_indices_t& kmer_indices, const char kmer_length, const assembly_t& assembly, const float max_identity_fraction, const bool screen_homologs, homology_cache_t& homology_cache);
 
 #endif /* _FILTER_HOMOLOGS_H */
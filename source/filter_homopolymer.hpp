@@ -5,6 +5,6 @@
 
 using namespace std;
 
-unsigned int filter_homopolymer(chimeric_alignments_t& chimeric_alignments, const unsigned int homopolymer_length, const exon_annotation_index_t& exon_annotation_index);
+bool is_adjacent_to_homopolymer(const mates_t& mates, const unsigned int homopolymer_length, const exon_annotation_index_t& exon_annotation_index);
 
 #endif /* _FILTER_HOMOPOLYMER_H */
@@ -5,6 +5,6 @@
 
 using namespace std;
 
-unsigned int filter_inconsistently_clipped_mates(chimeric_alignments_t& chimeric_alignments);
+bool is_inconsistently_clipped(const mates_t& mates);
 
 #endif /* _FILTER_INCONSISTENTLY_CLIPPED_MATES */
@@ -23,7 +23,7 @@ unsigned int filter_intragenic_both_exonic(fusions_t& fusions, const exon_annota
 			int spliced_distance = get_spliced_distance(fusion->second.contig1, fusion->second.breakpoint1, fusion->second.breakpoint2, fusion->second.direction1, fusion->second.direction2, fusion->second.gene1, exon_annotation_index);
 			int distance = fusion->second.breakpoint2 - fusion->second.breakpoint1;
 			if (spliced_distance == distance || spliced_distance / distance < exonic_fraction) {
-				fusion->second.filter = FILTERS.at("intragenic_exonic");
+				fusion->second.filter = get_filter(FILTER_INTRAGENIC_EXONIC);
 				continue;
 			}
 		}
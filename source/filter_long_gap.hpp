@@ -5,6 +5,6 @@
 
 using namespace std;
 
-unsigned int filter_long_gap(chimeric_alignments_t& chimeric_alignments);
+bool has_long_gap(const mates_t& mates);
 
 #endif /* _FILTER_LONG_GAP_H */
@@ -5,6 +5,6 @@
 
 using namespace std;
 
-unsigned int filter_low_entropy(chimeric_alignments_t& chimeric_alignments, const unsigned int kmer_length, const float kmer_content);
+bool has_low_entropy(const mates_t& mates, const unsigned int kmer_length, const float kmer_content);
 
 #endif /* _FILTER_LOW_ENTROPY_H */
@@ -13,7 +13,7 @@ unsigned int filter_min_support(fusions_t& fusions, const int min_support) {
 
 		if (chimeric_alignment->second.split_reads1 + chimeric_alignment->second.split_reads2 + chimeric_alignment->second.discordant_mates < min_support ||
 		    chimeric_alignment->second.breakpoint_overlaps_both_genes() && chimeric_alignment->second.split_reads1 + chimeric_alignment->second.split_reads2 < min_support)
-			chimeric_alignment->second.filter = FILTERS.at("min_support");
+			chimeric_alignment->second.filter = get_filter(FILTER_MIN_SUPPORT);
 		else
 			remaining++;
 	}
@@ -1,16 +1,21 @@
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <set>
 #include <string>
 #include <unordered_map>
 #include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "common.hpp"
 #include "annotation.hpp"
 #include "assembly.hpp"
+#include "parallel.hpp"
 #include "filter_mismappers.hpp"
 
 using namespace std;
 
-typedef set<position_t> splice_sites_t;
 typedef unordered_map<gene_t,splice_sites_t> splice_sites_by_gene_t;
 
 void get_downstream_splice_sites(const gene_t gene, const exon_annotation_index_t& exon_annotation_index, splice_sites_t& splice_sites) {
@@ -57,24 +62,61 @@ void make_kmer_index(const fusions_t& fusions, const assembly_t& assembly, const
 		genes_to_filter.insert(fusion->second.gene2);
 	}
 
-	// store positions of kmers in hash
+	// collect the regions to index for each contig
+	// overlapping genes are merged, so that every position is indexed only once
+	vector< vector< pair<position_t,position_t> > > regions_by_contig;
 	for (gene_set_t::iterator gene = genes_to_filter.begin(); gene != genes_to_filter.end(); ++gene) {
-		const string& contig_sequence = assembly.at((**gene).contig);
-		if ((int) kmer_indices.size() <= (**gene).contig)
-			kmer_indices.resize((**gene).contig+1);
-		for (position_t pos = (**gene).start; pos + kmer_length < (**gene).end; pos++)
-			if (contig_sequence[pos] != 'N') // don't index masked regions, as long stretches of N's inflate the number of hits
-				kmer_indices[(**gene).contig][kmer_to_int(contig_sequence, pos, kmer_length)].push_back(pos);
+		if ((int) regions_by_contig.size() <= (**gene).contig)
+			regions_by_contig.resize((**gene).contig+1);
+		if ((**gene).end - kmer_length > (**gene).start)
+			regions_by_contig[(**gene).contig].push_back(make_pair((**gene).start, (**gene).end - kmer_length)); // kmers must end before the end of the gene
 	}
+	kmer_indices.resize(regions_by_contig.size());
+
+	const kmer_as_int_t kmer_count = ((kmer_as_int_t) 1) << (2 * kmer_length);
+	for (contig_t contig = 0; contig < (int) regions_by_contig.size(); ++contig) {
+		vector< pair<position_t,position_t> >& regions = regions_by_contig[contig];
+		if (regions.empty())
+			continue;
+		sort(regions.begin(), regions.end());
+		vector< pair<position_t,position_t> > merged_regions(1, regions[0]);
+		for (auto region = regions.begin() + 1; region != regions.end(); ++region) {
+			if (region->first <= merged_regions.back().second)
+				merged_regions.back().second = max(merged_regions.back().second, region->second);
+			else
+				merged_regions.push_back(*region);
+		}
 
-	// sort kmer hits by increasing position, so that we can go through the list sequentially
-	for (kmer_indices_t::iterator kmer_index = kmer_indices.begin(); kmer_index != kmer_indices.end(); ++kmer_index)
-		for (kmer_index_t::iterator kmer_hits = kmer_index->begin(); kmer_hits != kmer_index->end(); ++kmer_hits) {
-			sort(kmer_hits->second.begin(), kmer_hits->second.end());
-			// when genes overlap the same kmer hit might be added multiple times => only keep unique entries
-			auto last = unique(kmer_hits->second.begin(), kmer_hits->second.end());
-			kmer_hits->second.erase(last, kmer_hits->second.end());
+		// count the occurrences of each kmer, then store their positions in the slots computed from the counts;
+		// since the regions are traversed in ascending order, the positions of each kmer end up sorted
+		const string& contig_sequence = assembly.at(contig);
+		kmer_index_t& kmer_index = kmer_indices[contig];
+		kmer_index.offsets.assign(kmer_count + 1, 0);
+		for (unsigned int pass = 0; pass < 2; ++pass) {
+			for (auto region = merged_regions.begin(); region != merged_regions.end(); ++region) {
+				for (position_t pos = region->first; pos < region->second; pos++) {
+					if (contig_sequence[pos] != 'N') { // don't index masked regions, as long stretches of N's inflate the number of hits
+						const kmer_as_int_t kmer = kmer_to_int(contig_sequence, pos, kmer_length);
+						if (pass == 0)
+							kmer_index.offsets[kmer+1]++;
+						else
+							kmer_index.positions[kmer_index.offsets[kmer]++] = pos;
+					}
+				}
+			}
+			if (pass == 0) {
+				// turn counts into offsets
+				for (kmer_as_int_t kmer = 0; kmer < kmer_count; ++kmer)
+					kmer_index.offsets[kmer+1] += kmer_index.offsets[kmer];
+				kmer_index.positions.resize(kmer_index.offsets[kmer_count]);
+			} else {
+				// filling has advanced each offset to the start of the next kmer => shift back
+				for (kmer_as_int_t kmer = kmer_count; kmer > 0; --kmer)
+					kmer_index.offsets[kmer] = kmer_index.offsets[kmer-1];
+				kmer_index.offsets[0] = 0;
+			}
 		}
+	}
 }
 
 bool align(int score, const string& read_sequence, int read_pos, const string& contig_sequence, const int gene_pos, const position_t gene_start, const position_t gene_end, const kmer_index_t& kmer_index, const char kmer_length, const splice_sites_t& splice_sites, const int min_score, int max_deletions) {
@@ -87,11 +129,9 @@ bool align(int score, const string& read_sequence, int read_pos, const string& c
 	                                                                             // 2*kmer_length takes into account that the score can improve, if we can extend to the left (up to kmer_length)
 	     read_pos++, score--, skipped_bases++) { // if a base cannot be aligned, go to the next, but give -1 penalty and increase the number of skipped bases
 
-		auto kmer_hits = kmer_index.find(kmer_to_int(read_sequence, read_pos, kmer_length));
-		if (kmer_hits == kmer_index.end())
-			continue; // kmer not found on given contig
-
-		for (auto kmer_hit = lower_bound(kmer_hits->second.begin(), kmer_hits->second.end(), gene_pos); kmer_hit != kmer_hits->second.end() && *kmer_hit < gene_end; ++kmer_hit) {
+		const kmer_as_int_t kmer = kmer_to_int(read_sequence, read_pos, kmer_length);
+		const kmer_index_t::const_iterator kmer_hits_end = kmer_index.end(kmer);
+		for (auto kmer_hit = lower_bound(kmer_index.begin(kmer), kmer_hits_end, gene_pos); kmer_hit != kmer_hits_end && *kmer_hit < gene_end; ++kmer_hit) {
 
 			int extended_score = score + kmer_length;
 			if (read_pos == skipped_bases) // so far, all bases at the beginning of the read have been skipped
@@ -180,13 +220,153 @@ bool align(int score, const string& read_sequence, int read_pos, const string& c
 	return false;
 }
 
-bool align_both_strands(const string& read_sequence, const int read_length, const int max_mate_gap, const bool breakpoints_on_same_contig, const position_t alignment_start, const position_t alignment_end, const kmer_indices_t& kmer_indices, const assembly_t& assembly, const exon_annotation_index_t& exon_annotation_index, splice_sites_by_gene_t& splice_sites_by_gene, gene_set_t& genes, const char kmer_length, const float min_align_percent, int min_score) {
-	min_score = min(min_score, (int) (min_align_percent * read_sequence.size() + 0.5));
-	for (gene_set_t::iterator gene = genes.begin(); gene != genes.end(); ++gene) {
+// parameters of the banded alignment
+const int BAND_WIDTH = 16; // number of diagonals covered by a band (= number of 8-bit lanes in an SSE2 register)
+const unsigned int MAX_BANDS = 16; // maximum number of bands to align per read, bounds the runtime per read
+const unsigned int MAX_KMER_HITS = 32; // k-mers with more hits in the gene are considered repetitive and only every n-th hit is used as seed
+const unsigned char BANDED_MISMATCH_PENALTY = 1;
+const unsigned char BANDED_GAP_PENALTY = 2;
+
+struct band_t {
+	int diagonal; // reference position minus read position in the middle of the band
+	unsigned int seeds; // number of k-mer hits on the diagonals of the band
+};
+
+// local alignment of a read against the window <gene_start>..<gene_end> of a contig
+// the cells of the dynamic programming matrix are only computed in bands around the diagonals with the most k-mer hits,
+// such that the runtime per read is bounded by <MAX_BANDS> times the length of the read
+// an alignment may jump from a splice site to a band further downstream to account for introns
+bool align_banded(const string& read_sequence, const string& contig_sequence, const position_t gene_start, const position_t gene_end, const kmer_index_t& kmer_index, const char kmer_length, const splice_sites_t& splice_sites, const int min_score) {
+
+	const int read_length = read_sequence.length();
+	if (read_length < kmer_length)
+		return false;
+
+	// collect diagonals of k-mer hits
+	vector<int> diagonals;
+	for (int read_pos = 0; read_pos + kmer_length <= read_length; ++read_pos) {
+		const kmer_as_int_t kmer = kmer_to_int(read_sequence, read_pos, kmer_length);
+		const kmer_index_t::const_iterator kmer_hits_begin = lower_bound(kmer_index.begin(kmer), kmer_index.end(kmer), gene_start);
+		const kmer_index_t::const_iterator kmer_hits_end = lower_bound(kmer_hits_begin, kmer_index.end(kmer), gene_end);
+		// subsample the hits of repetitive k-mers rather than ignoring them, since reads from repeats would otherwise have no seeds
+		const int kmer_hits = kmer_hits_end - kmer_hits_begin;
+		const int stride = (kmer_hits + MAX_KMER_HITS - 1) / MAX_KMER_HITS;
+		for (int kmer_hit = 0; kmer_hit < kmer_hits; kmer_hit += stride)
+			diagonals.push_back(kmer_hits_begin[kmer_hit] - read_pos);
+	}
+	if (diagonals.empty())
+		return false;
+
+	// group neighboring diagonals into bands
+	sort(diagonals.begin(), diagonals.end());
+	vector<band_t> bands;
+	for (auto diagonal = diagonals.begin(); diagonal != diagonals.end();) {
+		auto last_diagonal_of_band = diagonal;
+		while (last_diagonal_of_band + 1 != diagonals.end() && *(last_diagonal_of_band + 1) - *diagonal < BAND_WIDTH/2)
+			++last_diagonal_of_band;
+		band_t band = { (*diagonal + *last_diagonal_of_band) / 2, (unsigned int) (last_diagonal_of_band - diagonal + 1) };
+		bands.push_back(band);
+		diagonal = last_diagonal_of_band + 1;
+	}
 
-		// find all splice sites in the genes
-		if (splice_sites_by_gene.find(*gene) == splice_sites_by_gene.end())
-			get_downstream_splice_sites(*gene, exon_annotation_index, splice_sites_by_gene[*gene]);
+	// only align the bands with the most seeds
+	if (bands.size() > MAX_BANDS) {
+		nth_element(bands.begin(), bands.begin() + MAX_BANDS - 1, bands.end(), [](const band_t& x, const band_t& y) { return x.seeds > y.seeds || x.seeds == y.seeds && x.diagonal < y.diagonal; });
+		bands.resize(MAX_BANDS);
+	}
+	// align bands from upstream to downstream, so that alignments ending at a splice site can be continued in downstream bands
+	sort(bands.begin(), bands.end(), [](const band_t& x, const band_t& y) { return x.diagonal < y.diagonal; });
+
+	// best score of an alignment which ends at a splice site with the given read position
+	vector<unsigned char> splice_score(read_length, 0);
+	vector<position_t> splice_site(read_length, 0);
+
+	for (auto band = bands.begin(); band != bands.end(); ++band) {
+
+		splice_sites_t::const_iterator first_splice_site_in_band = splice_sites.lower_bound(band->diagonal - BAND_WIDTH/2);
+		unsigned char previous_row[BAND_WIDTH] = {0};
+		unsigned char row[BAND_WIDTH];
+		unsigned char reference[BAND_WIDTH];
+
+		for (int read_pos = 0; read_pos < read_length; ++read_pos) {
+
+			// lane i of the band refers to this position in the reference
+			const position_t band_start = read_pos + band->diagonal - BAND_WIDTH/2;
+
+			// get the reference sequence of the band, positions outside the window never match
+			if (band_start >= gene_start && band_start + BAND_WIDTH - 1 <= gene_end) {
+				memcpy(reference, contig_sequence.c_str() + band_start, BAND_WIDTH);
+			} else {
+				for (int lane = 0; lane < BAND_WIDTH; ++lane)
+					reference[lane] = (band_start + lane >= gene_start && band_start + lane <= gene_end) ? contig_sequence[band_start + lane] : 0;
+			}
+
+			// continue alignments which end at a splice site upstream of the lane
+			unsigned char splice_continuation = 0;
+			int first_continued_lane = BAND_WIDTH;
+			if (read_pos > 0 && splice_score[read_pos-1] > 0) {
+				splice_continuation = splice_score[read_pos-1];
+				first_continued_lane = max(0, min(BAND_WIDTH, splice_site[read_pos-1] - band_start + 1));
+			}
+
+#ifdef __SSE2__
+			const __m128i lane_index = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+			const __m128i previous = _mm_loadu_si128((const __m128i*) previous_row);
+			const __m128i matches = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) reference), _mm_set1_epi8(read_sequence[read_pos]));
+			const __m128i continued_lanes = _mm_cmpgt_epi8(lane_index, _mm_set1_epi8(first_continued_lane - 1));
+
+			// diagonal move: match or mismatch
+			__m128i cells = _mm_max_epu8(previous, _mm_and_si128(continued_lanes, _mm_set1_epi8(splice_continuation)));
+			cells = _mm_subs_epu8(_mm_adds_epu8(cells, _mm_and_si128(matches, _mm_set1_epi8(1))), _mm_andnot_si128(matches, _mm_set1_epi8(BANDED_MISMATCH_PENALTY)));
+			// vertical move: gap in the reference
+			cells = _mm_max_epu8(cells, _mm_subs_epu8(_mm_srli_si128(previous, 1), _mm_set1_epi8(BANDED_GAP_PENALTY)));
+			// horizontal moves: gap in the read, computed as prefix maximum
+			cells = _mm_max_epu8(cells, _mm_subs_epu8(_mm_slli_si128(cells, 1), _mm_set1_epi8(BANDED_GAP_PENALTY)));
+			cells = _mm_max_epu8(cells, _mm_subs_epu8(_mm_slli_si128(cells, 2), _mm_set1_epi8(2 * BANDED_GAP_PENALTY)));
+			cells = _mm_max_epu8(cells, _mm_subs_epu8(_mm_slli_si128(cells, 4), _mm_set1_epi8(4 * BANDED_GAP_PENALTY)));
+			cells = _mm_max_epu8(cells, _mm_subs_epu8(_mm_slli_si128(cells, 8), _mm_set1_epi8(8 * BANDED_GAP_PENALTY)));
+			_mm_storeu_si128((__m128i*) row, cells);
+
+			if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(cells, _mm_set1_epi8(min_score)), cells)) != 0)
+				return true;
+#else
+			for (int lane = 0; lane < BAND_WIDTH; ++lane) {
+				int cell = previous_row[lane];
+				if (lane >= first_continued_lane)
+					cell = max(cell, (int) splice_continuation);
+				cell = min(255, cell + ((reference[lane] == read_sequence[read_pos]) ? 1 : -BANDED_MISMATCH_PENALTY));
+				if (lane + 1 < BAND_WIDTH)
+					cell = max(cell, previous_row[lane+1] - BANDED_GAP_PENALTY);
+				if (lane > 0)
+					cell = max(cell, row[lane-1] - BANDED_GAP_PENALTY);
+				row[lane] = max(0, cell);
+				if (row[lane] >= min_score)
+					return true;
+			}
+#endif
+
+			// remember the best alignment which ends at a splice site
+			while (first_splice_site_in_band != splice_sites.end() && *first_splice_site_in_band < band_start)
+				++first_splice_site_in_band;
+			for (splice_sites_t::const_iterator site = first_splice_site_in_band; site != splice_sites.end() && *site < band_start + BAND_WIDTH; ++site) {
+				const unsigned char score = row[*site - band_start];
+				if (score > splice_score[read_pos] || score == splice_score[read_pos] && score > 0 && *site < splice_site[read_pos]) {
+					splice_score[read_pos] = score;
+					splice_site[read_pos] = *site;
+				}
+			}
+
+			memcpy(previous_row, row, BAND_WIDTH);
+		}
+	}
+
+	// we only get here, if the read could not be aligned
+	return false;
+}
+
+bool align_both_strands(const string& read_sequence, const int read_length, const int max_mate_gap, const bool breakpoints_on_same_contig, const position_t alignment_start, const position_t alignment_end, const kmer_indices_t& kmer_indices, const assembly_t& assembly, const splice_sites_by_gene_t& splice_sites_by_gene, const gene_set_t& genes, const char kmer_length, const float min_align_percent, int min_score, const bool banded_alignment) {
+	min_score = min(min_score, (int) (min_align_percent * read_sequence.size() + 0.5));
+	for (gene_set_t::const_iterator gene = genes.begin(); gene != genes.end(); ++gene) {
 
 		// align against gene and some buffer before and after the gene (but not beyond contig boundaries)
 		position_t gene_start = max((**gene).start - max_mate_gap - read_length, 0);
@@ -200,13 +380,23 @@ bool align_both_strands(const string& read_sequence, const int read_length, cons
 		     alignment_end   >= gene_start && alignment_end   <= gene_end))
 			continue;
 
-		if (align(0, read_sequence, 0, assembly.at((**gene).contig), gene_start, gene_start, gene_end, kmer_indices[(**gene).contig], kmer_length, splice_sites_by_gene.at(*gene), min_score, 1)) { // align on forward strand
+		const string& contig_sequence = assembly.at((**gene).contig);
+		const kmer_index_t& kmer_index = kmer_indices[(**gene).contig];
+		const splice_sites_t& splice_sites = splice_sites_by_gene.at(*gene);
+		if (banded_alignment) {
+			if (align_banded(read_sequence, contig_sequence, gene_start, gene_end, kmer_index, kmer_length, splice_sites, min_score)) // align on forward strand
+				return true;
+			string reverse_complement;
+			dna_to_reverse_complement(read_sequence, reverse_complement);
+			if (align_banded(reverse_complement, contig_sequence, gene_start, gene_end, kmer_index, kmer_length, splice_sites, min_score)) // align on reverse strand
+				return true;
+		} else if (align(0, read_sequence, 0, contig_sequence, gene_start, gene_start, gene_end, kmer_index, kmer_length, splice_sites, min_score, 1)) { // align on forward strand
 			return true;
 		} else { // align on reverse strand
 			string reverse_complement;
 			string original = read_sequence;
 			dna_to_reverse_complement(original, reverse_complement);
-			if (align(0, reverse_complement, 0, assembly.at((**gene).contig), gene_start, gene_start, gene_end, kmer_indices[(**gene).contig], kmer_length, splice_sites_by_gene.at(*gene), min_score, 1))
+			if (align(0, reverse_complement, 0, contig_sequence, gene_start, gene_start, gene_end, kmer_index, kmer_length, splice_sites, min_score, 1))
 				return true;
 		}
 	}
@@ -217,7 +407,7 @@ void count_mismappers(vector<chimeric_alignments_t::iterator>& chimeric_alignmen
 	for (auto chimeric_alignment = chimeric_alignments_list.begin(); chimeric_alignment != chimeric_alignments_list.end(); ++chimeric_alignment) {
 		if ((**chimeric_alignment).second.filter == NULL) {
 			total_reads++;
-		} else if ((**chimeric_alignment).second.filter == FILTERS.at("mismappers")) {
+		} else if ((**chimeric_alignment).second.filter == get_filter(FILTER_MISMAPPERS)) {
 			total_reads++;
 			mismappers++;
 			if (supporting_reads > 0)
@@ -230,36 +420,119 @@ void count_mismappers(vector<chimeric_alignments_t::iterator>& chimeric_alignmen
 bool extend_split_read(const alignment_t& split_read, const assembly_t& assembly, const float min_align_percent) {
 
 	// get clipped segment and the reference sequence at the position of the clipped segment
-	string clipped_sequence;
-	string reference_sequence;
+	const string& contig_sequence = assembly.at(split_read.contig);
+	static thread_local string unpacked_sequence; // reused by all reads of a thread to avoid allocating memory per read
+	const string& read_sequence = split_read.sequence.unpack(unpacked_sequence);
+	const char* clipped_sequence;
+	const char* reference_sequence;
 	int clipped_count;
 	if (split_read.strand == FORWARD) {
 		clipped_count = min((int) split_read.preclipping(), split_read.start); // don't run over contig boundary
-		clipped_sequence = split_read.sequence.substr(split_read.preclipping() - clipped_count, clipped_count);
-		reference_sequence = assembly.at(split_read.contig).substr(split_read.start - clipped_count, clipped_count);
+		clipped_sequence = read_sequence.c_str() + split_read.preclipping() - clipped_count;
+		reference_sequence = contig_sequence.c_str() + split_read.start - clipped_count;
 	} else {
-		clipped_count = min((int) split_read.postclipping(), (int) assembly.at(split_read.contig).size() - split_read.end); // don't run over contig boundary
-		clipped_sequence = split_read.sequence.substr(split_read.sequence.size() - split_read.postclipping(), clipped_count);
-		reference_sequence = assembly.at(split_read.contig).substr(split_read.end, clipped_count);
+		clipped_count = min((int) split_read.postclipping(), (int) contig_sequence.size() - split_read.end); // don't run over contig boundary
+		clipped_sequence = read_sequence.c_str() + read_sequence.size() - split_read.postclipping();
+		reference_sequence = contig_sequence.c_str() + split_read.end;
 	}
+	if (clipped_count < 0)
+		clipped_count = 0;
 
 	// count number of matching bases between clipped segment and reference
-	unsigned int matching_bases = 0;
-	for (unsigned int i = 0; i < clipped_sequence.size(); ++i)
-		if (clipped_sequence[i] == reference_sequence[i])
-			++matching_bases;
+	unsigned int matching_bases = count_matching_bases(clipped_sequence, reference_sequence, clipped_count);
+
+	return matching_bases >= floor(clipped_count * min_align_percent);
+}
+
+// find all splice sites of the genes against which reads are re-aligned, so that they are known before the re-alignment starts
+void get_splice_sites_of_genes(const gene_set_t& genes, const exon_annotation_index_t& exon_annotation_index, splice_sites_by_gene_t& splice_sites_by_gene) {
+	for (gene_set_t::const_iterator gene = genes.begin(); gene != genes.end(); ++gene)
+		if (splice_sites_by_gene.find(*gene) == splice_sites_by_gene.end())
+			get_downstream_splice_sites(*gene, exon_annotation_index, splice_sites_by_gene[*gene]);
+}
 
-	return matching_bases >= floor(clipped_sequence.size() * min_align_percent);
+void get_splice_sites_of_fusion(const fusion_t& fusion, const exon_annotation_index_t& exon_annotation_index, splice_sites_by_gene_t& splice_sites_by_gene) {
+	const vector<chimeric_alignments_t::iterator>* split_read_lists[] = { &fusion.split_read1_list, &fusion.split_read2_list };
+	for (unsigned int i = 0; i < 2; ++i) {
+		for (auto chimeric_alignment = split_read_lists[i]->begin(); chimeric_alignment != split_read_lists[i]->end(); ++chimeric_alignment) {
+			if ((**chimeric_alignment).second.filter == NULL) {
+				get_splice_sites_of_genes((**chimeric_alignment).second[SPLIT_READ].genes, exon_annotation_index, splice_sites_by_gene);
+				get_splice_sites_of_genes((**chimeric_alignment).second[SUPPLEMENTARY].genes, exon_annotation_index, splice_sites_by_gene);
+			}
+		}
+	}
+	for (auto chimeric_alignment = fusion.discordant_mate_list.begin(); chimeric_alignment != fusion.discordant_mate_list.end(); ++chimeric_alignment) {
+		if ((**chimeric_alignment).second.filter == NULL && (**chimeric_alignment).second.size() == 2) {
+			get_splice_sites_of_genes((**chimeric_alignment).second[MATE1].genes, exon_annotation_index, splice_sites_by_gene);
+			get_splice_sites_of_genes((**chimeric_alignment).second[MATE2].genes, exon_annotation_index, splice_sites_by_gene);
+		}
+	}
 }
 
-unsigned int filter_mismappers(fusions_t& fusions, const kmer_indices_t& kmer_indices, const char kmer_length, const assembly_t& assembly, const exon_annotation_index_t& exon_annotation_index, const float max_mismapper_fraction, const int max_mate_gap) {
+// align discordant mate / clipped segment in gene of origin and collect the reads which align there
+// the reads are only collected and not marked as filtered, so that the fusions can be processed independently
+void find_mismappers(const fusion_t& fusion, const kmer_indices_t& kmer_indices, const char kmer_length, const assembly_t& assembly, const splice_sites_by_gene_t& splice_sites_by_gene, const int max_mate_gap, const float min_align_percent, const int min_score, const bool banded_alignment, vector<chimeric_alignments_t::iterator>& mismappers) {
+
+	// the packed sequences are unpacked into a buffer which each thread reuses, so that no memory is allocated per read
+	static thread_local string sequence;
+
+	// re-align split reads
+	vector<chimeric_alignments_t::iterator> all_split_reads;
+	all_split_reads.insert(all_split_reads.end(), fusion.split_read1_list.begin(), fusion.split_read1_list.end());
+	all_split_reads.insert(all_split_reads.end(), fusion.split_read2_list.begin(), fusion.split_read2_list.end());
+	for (auto chimeric_alignment = all_split_reads.begin(); chimeric_alignment != all_split_reads.end(); ++chimeric_alignment) {
+
+		if ((**chimeric_alignment).second.filter != NULL)
+			continue; // read has already been filtered
+
+		// introduce aliases for cleaner code
+		const alignment_t& split_read = (**chimeric_alignment).second[SPLIT_READ];
+		const alignment_t& supplementary = (**chimeric_alignment).second[SUPPLEMENTARY];
+		const alignment_t& mate1 = (**chimeric_alignment).second[MATE1];
+
+		if (split_read.strand == FORWARD) {
+			if (extend_split_read(split_read, assembly, min_align_percent) ||
+			    align_both_strands(split_read.sequence.unpack(sequence, 0, split_read.preclipping()), split_read.sequence.size(), max_mate_gap, fusion.contig1 == fusion.contig2, supplementary.start, supplementary.end, kmer_indices, assembly, splice_sites_by_gene, split_read.genes, kmer_length, min_align_percent, min_score, banded_alignment) || // clipped segment aligns to donor
+			    align_both_strands(mate1.sequence.unpack(sequence, mate1.preclipping()), mate1.sequence.size(), max_mate_gap, fusion.contig1 == fusion.contig2, mate1.start, mate1.end, kmer_indices, assembly, splice_sites_by_gene, supplementary.genes, kmer_length, min_align_percent, min_score, banded_alignment)) { // non-spliced mate aligns to acceptor
+				mismappers.push_back(*chimeric_alignment);
+			}
+		} else { // split_read.strand == REVERSE
+			if (extend_split_read(split_read, assembly, min_align_percent) ||
+			    align_both_strands(split_read.sequence.unpack(sequence, split_read.sequence.length() - split_read.postclipping()), split_read.sequence.size(), max_mate_gap, fusion.contig1 == fusion.contig2, supplementary.start, supplementary.end, kmer_indices, assembly, splice_sites_by_gene, split_read.genes, kmer_length, min_align_percent, min_score, banded_alignment) || // clipped segment aligns to donor
+			    align_both_strands(mate1.sequence.unpack(sequence, 0, mate1.sequence.length() - mate1.postclipping()), mate1.sequence.size(), max_mate_gap, fusion.contig1 == fusion.contig2, mate1.start, mate1.end, kmer_indices, assembly, splice_sites_by_gene, supplementary.genes, kmer_length, min_align_percent, min_score, banded_alignment)) { // non-spliced mate aligns to acceptor
+				mismappers.push_back(*chimeric_alignment);
+			}
+		}
+	}
+
+	// re-align discordant mates
+	for (auto chimeric_alignment = fusion.discordant_mate_list.begin(); chimeric_alignment != fusion.discordant_mate_list.end(); ++chimeric_alignment) {
+		if ((**chimeric_alignment).second.filter != NULL)
+			continue; // read has already been filtered
+
+		if ((**chimeric_alignment).second.size() == 2) { // discordant mates
+
+			// introduce aliases for cleaner code
+			const alignment_t& mate1 = (**chimeric_alignment).second[MATE1];
+			const alignment_t& mate2 = (**chimeric_alignment).second[MATE2];
+
+			if (align_both_strands(mate1.sequence.unpack(sequence), mate1.sequence.size(), max_mate_gap, fusion.contig1 == fusion.contig2, mate1.start, mate1.end, kmer_indices, assembly, splice_sites_by_gene, mate2.genes, kmer_length, min_align_percent, min_score, banded_alignment) ||
+			    align_both_strands(mate2.sequence.unpack(sequence), mate2.sequence.size(), max_mate_gap, fusion.contig1 == fusion.contig2, mate2.start, mate2.end, kmer_indices, assembly, splice_sites_by_gene, mate1.genes, kmer_length, min_align_percent, min_score, banded_alignment)) {
+				mismappers.push_back(*chimeric_alignment);
+			}
+		}
+	}
+}
+
+unsigned int filter_mismappers(fusions_t& fusions, const kmer_indices_t& kmer_indices, const char kmer_length, const assembly_t& assembly, const exon_annotation_index_t& exon_annotation_index, const float max_mismapper_fraction, const int max_mate_gap, const bool banded_alignment, const unsigned int threads) {
 
 	const float min_align_percent = 0.8; // allow ~1 mismatch for every 10 matches
 	const int min_score = 40; // consider this score or higher a match (even if less than min_align_percent match)
 
+	// find fusions whose reads need to be re-aligned
+	// and look up the splice sites of all genes in advance, such that the re-alignment only needs read access to shared data
+	vector<fusion_t*> fusions_to_realign;
 	splice_sites_by_gene_t splice_sites_by_gene;
-
-	// align discordnat mate / clipped segment in gene of origin
 	for (fusions_t::iterator fusion = fusions.begin(); fusion != fusions.end(); ++fusion) {
 
 		if (fusion->second.gene1 == fusion->second.gene2)
@@ -272,54 +545,21 @@ unsigned int filter_mismappers(fusions_t& fusions, const kmer_indices_t& kmer_in
 		if (fusion->second.gene1->name == "MTAP" && fusion->second.gene2->name == "CDKN2B-AS1")
 			continue;
 
-		// re-align split reads
-		vector<chimeric_alignments_t::iterator> all_split_reads;
-		all_split_reads.insert(all_split_reads.end(), fusion->second.split_read1_list.begin(), fusion->second.split_read1_list.end());
-		all_split_reads.insert(all_split_reads.end(), fusion->second.split_read2_list.begin(), fusion->second.split_read2_list.end());
-		for (auto chimeric_alignment = all_split_reads.begin(); chimeric_alignment != all_split_reads.end(); ++chimeric_alignment) {
-
-			if ((**chimeric_alignment).second.filter != NULL)
-				continue; // read has already been filtered
-
-			// introduce aliases for cleaner code
-			alignment_t& split_read = (**chimeric_alignment).second[SPLIT_READ];
-			alignment_t& supplementary = (**chimeric_alignment).second[SUPPLEMENTARY];
-			alignment_t& mate1 = (**chimeric_alignment).second[MATE1];
-
-			if (split_read.strand == FORWARD) {
-				if (extend_split_read(split_read, assembly, min_align_percent) ||
-				    align_both_strands(split_read.sequence.substr(0, split_read.preclipping()), split_read.sequence.size(), max_mate_gap, fusion->second.contig1 == fusion->second.contig2, supplementary.start, supplementary.end, kmer_indices, assembly, exon_annotation_index, splice_sites_by_gene, split_read.genes, kmer_length, min_align_percent, min_score) || // clipped segment aligns to donor
-				    align_both_strands(mate1.sequence.substr(mate1.preclipping()), mate1.sequence.size(), max_mate_gap, fusion->second.contig1 == fusion->second.contig2, mate1.start, mate1.end, kmer_indices, assembly, exon_annotation_index, splice_sites_by_gene, supplementary.genes, kmer_length, min_align_percent, min_score)) { // non-spliced mate aligns to acceptor
-					(**chimeric_alignment).second.filter = FILTERS.at("mismappers");
-				}
-			} else { // split_read.strand == REVERSE
-				if (extend_split_read(split_read, assembly, min_align_percent) ||
-				    align_both_strands(split_read.sequence.substr(split_read.sequence.length() - split_read.postclipping()), split_read.sequence.size(), max_mate_gap, fusion->second.contig1 == fusion->second.contig2, supplementary.start, supplementary.end, kmer_indices, assembly, exon_annotation_index, splice_sites_by_gene, split_read.genes, kmer_length, min_align_percent, min_score) || // clipped segment aligns to donor
-				    align_both_strands(mate1.sequence.substr(0, mate1.sequence.length() - mate1.postclipping()), mate1.sequence.size(), max_mate_gap, fusion->second.contig1 == fusion->second.contig2, mate1.start, mate1.end, kmer_indices, assembly, exon_annotation_index, splice_sites_by_gene, supplementary.genes, kmer_length, min_align_percent, min_score)) { // non-spliced mate aligns to acceptor
-					(**chimeric_alignment).second.filter = FILTERS.at("mismappers");
-				}
-			}
-		}
-
-		// re-align discordant mates
-		for (auto chimeric_alignment = fusion->second.discordant_mate_list.begin(); chimeric_alignment != fusion->second.discordant_mate_list.end(); ++chimeric_alignment) {
-			if ((**chimeric_alignment).second.filter != NULL)
-				continue; // read has already been filtered
-
-			if ((**chimeric_alignment).second.size() == 2) { // discordant mates
-
-				// introduce aliases for cleaner code
-				alignment_t& mate1 = (**chimeric_alignment).second[MATE1];
-				alignment_t& mate2 = (**chimeric_alignment).second[MATE2];
+		fusions_to_realign.push_back(&fusion->second);
+		get_splice_sites_of_fusion(fusion->second, exon_annotation_index, splice_sites_by_gene);
+	}
 
-				if (align_both_strands(mate1.sequence, mate1.sequence.size(), max_mate_gap, fusion->second.contig1 == fusion->second.contig2, mate1.start, mate1.end, kmer_indices, assembly, exon_annotation_index, splice_sites_by_gene, mate2.genes, kmer_length, min_align_percent, min_score) ||
-				    align_both_strands(mate2.sequence, mate2.sequence.size(), max_mate_gap, fusion->second.contig1 == fusion->second.contig2, mate2.start, mate2.end, kmer_indices, assembly, exon_annotation_index, splice_sites_by_gene, mate1.genes, kmer_length, min_align_percent, min_score)) {
-					(**chimeric_alignment).second.filter = FILTERS.at("mismappers");
-				}
-			}
-		}
+	// re-align the reads of the fusions in parallel
+	vector< vector<chimeric_alignments_t::iterator> > mismappers(fusions_to_realign.size());
+	run_in_parallel(threads, fusions_to_realign.size(), [&](const unsigned int fusion, const unsigned int thread_id) {
+		find_mismappers(*fusions_to_realign[fusion], kmer_indices, kmer_length, assembly, splice_sites_by_gene, max_mate_gap, min_align_percent, min_score, banded_alignment, mismappers[fusion]);
+	});
 
-	}
+	// mark mismappers as filtered
+	// a read is discarded if it aligns in the gene of origin for any of the fusions it supports, so the order does not matter
+	for (auto mismappers_of_fusion = mismappers.begin(); mismappers_of_fusion != mismappers.end(); ++mismappers_of_fusion)
+		for (auto chimeric_alignment = mismappers_of_fusion->begin(); chimeric_alignment != mismappers_of_fusion->end(); ++chimeric_alignment)
+			(**chimeric_alignment).second.filter = get_filter(FILTER_MISMAPPERS);
 
 	// discard all fusions with more than XX% mismappers
 	unsigned int remaining = 0;
@@ -336,7 +576,7 @@ unsigned int filter_mismappers(fusions_t& fusions, const kmer_indices_t& kmer_in
 
 		// remove fusions with mostly mismappers
 		if (mismappers > 0 && mismappers >= floor(max_mismapper_fraction * total_reads))
-			fusion->second.filter = FILTERS.at("mismappers");
+			fusion->second.filter = get_filter(FILTER_MISMAPPERS);
 		else
 			remaining++;
 
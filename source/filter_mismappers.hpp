@@ -1,8 +1,8 @@
 #ifndef _FILTER_MISMAPPER_H
 #define _FILTER_MISMAPPER_H 1
 
+#include <set>
 #include <string>
-#include <unordered_map>
 #include <vector>
 #include "common.hpp"
 #include "annotation.hpp"
@@ -11,12 +11,26 @@
 using namespace std;
 
 typedef unsigned int kmer_as_int_t; // represent kmer as integer
-typedef unordered_map< kmer_as_int_t, vector<int> > kmer_index_t; // store coordinates of kmers
+// store coordinates of kmers in compressed sparse row format:
+// the positions of a kmer are found in positions[offsets[kmer]] to positions[offsets[kmer+1]-1] in ascending order
+struct kmer_index_t {
+	vector<unsigned int> offsets; // one entry per possible kmer plus one, empty if no gene on the contig was indexed
+	vector<int> positions;
+	typedef vector<int>::const_iterator const_iterator;
+	const_iterator begin(const kmer_as_int_t kmer) const { return offsets.empty() ? positions.end() : positions.begin() + offsets[kmer]; }
+	const_iterator end(const kmer_as_int_t kmer) const { return offsets.empty() ? positions.end() : positions.begin() + offsets[kmer+1]; }
+};
 typedef vector<kmer_index_t> kmer_indices_t; // one index per contig
 
 kmer_as_int_t kmer_to_int(const string& kmer, const string::size_type position, const char kmer_length);
 void make_kmer_index(const fusions_t& fusions, const assembly_t& assembly, const char kmer_length, kmer_indices_t& kmer_indices);
 
-unsigned int filter_mismappers(fusions_t& fusions, const kmer_indices_t& kmer_indices, const char kmer_length, const assembly_t& assembly, const exon_annotation_index_t& exon_annotation_index, const float max_mismapper_fraction, const int max_mate_gap);
+typedef set<position_t> splice_sites_t;
+
+// the two engines to re-align reads: seed-and-extend (default) and banded local alignment (-W)
+bool align(int score, const string& read_sequence, int read_pos, const string& contig_sequence, const int gene_pos, const position_t gene_start, const position_t gene_end, const kmer_index_t& kmer_index, const char kmer_length, const splice_sites_t& splice_sites, const int min_score, int max_deletions);
+bool align_banded(const string& read_sequence, const string& contig_sequence, const position_t gene_start, const position_t gene_end, const kmer_index_t& kmer_index, const char kmer_length, const splice_sites_t& splice_sites, const int min_score);
+
+unsigned int filter_mismappers(fusions_t& fusions, const kmer_indices_t& kmer_indices, const char kmer_length, const assembly_t& assembly, const exon_annotation_index_t& exon_annotation_index, const float max_mismapper_fraction, const int max_mate_gap, const bool banded_alignment, const unsigned int threads);
 
 #endif /* _FILTER_MISMAPPERS_H */
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cmath>
 #include <string>
 #include "sam.h"
@@ -15,6 +16,7 @@ void count_mismatches(const alignment_t& alignment, const string& sequence, cons
 	alignment_length = 0;
 	position_t reference_position = alignment.start;
 	position_t read_position = 0;
+	const string& contig_sequence = assembly.at(alignment.contig);
 	for (unsigned int i = 0; i < alignment.cigar.size(); ++i) {
 		switch (alignment.cigar.operation(i)) {
 			case BAM_CSOFT_CLIP:
@@ -36,17 +38,21 @@ void count_mismatches(const alignment_t& alignment, const string& sequence, cons
 				break;
 			case BAM_CMATCH:
 			case BAM_CEQUAL:
-			case BAM_CDIFF:
-				for (unsigned int operation_i = 1; operation_i <= alignment.cigar.op_length(i); ++operation_i) {
-					if (sequence[read_position] != 'N') {
-						if (sequence[read_position] != assembly.at(alignment.contig)[reference_position])
-							mismatches++;
+			case BAM_CDIFF: {
+				// compare the whole block at once; bases beyond the end of the contig count as mismatches
+				const unsigned int block_length = alignment.cigar.op_length(i);
+				const unsigned int comparable_length = (reference_position >= (position_t) contig_sequence.size()) ? 0 : min(block_length, (unsigned int) (contig_sequence.size() - reference_position));
+				count_mismatching_bases(sequence.c_str() + read_position, contig_sequence.c_str() + reference_position, comparable_length, mismatches, alignment_length);
+				for (unsigned int operation_i = comparable_length; operation_i < block_length; ++operation_i) {
+					if (sequence[read_position + operation_i] != 'N') {
+						mismatches++;
 						alignment_length++;
 					}
-					reference_position++;
-					read_position++;
 				}
+				reference_position += block_length;
+				read_position += block_length;
 				break;
+			}
 		}
 	}
 }
@@ -93,38 +99,30 @@ bool test_mismatch_probability(const alignment_t& alignment, const string& seque
 		return false;
 }
 
-unsigned int filter_mismatches(chimeric_alignments_t& chimeric_alignments, const assembly_t& assembly, const contigs_t& interesting_contigs, const float mismatch_probability, const float pvalue_cutoff) {
+bool has_too_many_mismatches(const mates_t& mates, const assembly_t& assembly, const float mismatch_probability, long unsigned int genome_size, const float pvalue_cutoff) {
+	// the packed sequences are unpacked into buffers which each thread reuses, so that no memory is allocated per fragment
+	static thread_local string sequence, reverse_complement;
+	// discard chimeric alignments which have too many mismatches
+	if (mates.size() == 2) { // discordant mates
+		return test_mismatch_probability(mates[MATE1], mates[MATE1].sequence.unpack(sequence), assembly, mismatch_probability, genome_size, pvalue_cutoff) ||
+		       test_mismatch_probability(mates[MATE2], mates[MATE2].sequence.unpack(sequence), assembly, mismatch_probability, genome_size, pvalue_cutoff);
+	} else { // split read
+		if (test_mismatch_probability(mates[MATE1], mates[MATE1].sequence.unpack(sequence), assembly, mismatch_probability, genome_size, pvalue_cutoff))
+			return true;
+		mates[SPLIT_READ].sequence.unpack(sequence);
+		if (mates[SUPPLEMENTARY].strand != mates[SPLIT_READ].strand) {
+			dna_to_reverse_complement(sequence, reverse_complement);
+			return test_mismatch_probability(mates[SUPPLEMENTARY], reverse_complement, assembly, mismatch_probability, genome_size, pvalue_cutoff);
+		}
+		return test_mismatch_probability(mates[SUPPLEMENTARY], sequence, assembly, mismatch_probability, genome_size, pvalue_cutoff);
+	}
+}
 
-	// calculate size of genome
-	// we'll need this to calculate the probability of finding a match in the genome given a random sequence of bases
+// calculate size of genome
+// we'll need this to calculate the probability of finding a match in the genome given a random sequence of bases
+long unsigned int get_genome_size(const assembly_t& assembly, const contigs_t& interesting_contigs) {
 	long unsigned int genome_size = 0;
 	for (contigs_t::const_iterator contig = interesting_contigs.begin(); contig != interesting_contigs.end(); ++contig)
 		genome_size += assembly.at(contig->second).size();
-
-	unsigned int remaining = 0;
-	for (chimeric_alignments_t::iterator chimeric_alignment = chimeric_alignments.begin(); chimeric_alignment != chimeric_alignments.end(); ++chimeric_alignment) {
-
-		if (chimeric_alignment->second.filter != NULL)
-			continue; // read has already been filtered
-
-		// discard chimeric alignments which have too many mismatches
-		if (chimeric_alignment->second.size() == 2) { // discordant mates
-			
-			if (test_mismatch_probability(chimeric_alignment->second[MATE1], chimeric_alignment->second[MATE1].sequence, assembly, mismatch_probability, genome_size, pvalue_cutoff) ||
-			    test_mismatch_probability(chimeric_alignment->second[MATE2], chimeric_alignment->second[MATE2].sequence, assembly, mismatch_probability, genome_size, pvalue_cutoff)) {
-				chimeric_alignment->second.filter = FILTERS.at("mismatches");
-				continue;
-			}
-		} else { // split read
-			if (test_mismatch_probability(chimeric_alignment->second[MATE1], chimeric_alignment->second[MATE1].sequence, assembly, mismatch_probability, genome_size, pvalue_cutoff) ||
-			    test_mismatch_probability(chimeric_alignment->second[SUPPLEMENTARY], (chimeric_alignment->second[SUPPLEMENTARY].strand == chimeric_alignment->second[SPLIT_READ].strand) ? chimeric_alignment->second[SPLIT_READ].sequence : dna_to_reverse_complement(chimeric_alignment->second[SPLIT_READ].sequence), assembly, mismatch_probability, genome_size, pvalue_cutoff)) {
-				chimeric_alignment->second.filter = FILTERS.at("mismatches");
-				continue;
-			}
-		}
-
-		++remaining;
-	}
-	return remaining;
+	return genome_size;
 }
-
@@ -5,6 +5,8 @@
 
 using namespace std;
 
-unsigned int filter_mismatches(chimeric_alignments_t& chimeric_alignments, const assembly_t& assembly, const contigs_t& interesting_contigs, const float mismatch_probability, const float pvalue_cutoff);
+long unsigned int get_genome_size(const assembly_t& assembly, const contigs_t& interesting_contigs);
+
+bool has_too_many_mismatches(const mates_t& mates, const assembly_t& assembly, const float mismatch_probability, long unsigned int genome_size, const float pvalue_cutoff);
 
 #endif /* _FILTER_MISMATCHES_H */
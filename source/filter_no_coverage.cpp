@@ -60,7 +60,7 @@ unsigned int filter_no_coverage(fusions_t& fusions, const coverage_t& coverage,
 			}
 			if (fusion->second.direction1 == UPSTREAM && !coverage.fragment_starts_here(fusion->second.contig1, start, end) ||
 			    fusion->second.direction1 == DOWNSTREAM && !coverage.fragment_ends_here(fusion->second.contig1, start, end)) {
-				fusion->second.filter = FILTERS.at("no_coverage");
+				fusion->second.filter = get_filter(FILTER_NO_COVERAGE);
 				continue;
 			}
 		}
@@ -88,7 +88,7 @@ unsigned int filter_no_coverage(fusions_t& fusions, const coverage_t& coverage,
 			}
 			if (fusion->second.direction2 == UPSTREAM && !coverage.fragment_starts_here(fusion->second.contig2, start, end) ||
 			    fusion->second.direction2 == DOWNSTREAM && !coverage.fragment_ends_here(fusion->second.contig2, start, end)) {
-				fusion->second.filter = FILTERS.at("no_coverage");
+				fusion->second.filter = get_filter(FILTER_NO_COVERAGE);
 				continue;
 			}
 		}
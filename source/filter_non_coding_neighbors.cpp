@@ -11,7 +11,7 @@ unsigned int filter_non_coding_neighbors(fusions_t& fusions) {
 
 		if (!fusion->second.gene1->is_protein_coding && !fusion->second.gene2->is_protein_coding &&
 		    fusion->second.is_read_through())
-			fusion->second.filter = FILTERS.at("non_coding_neighbors");
+			fusion->second.filter = get_filter(FILTER_NON_CODING_NEIGHBORS);
 		else
 			++remaining;
 	}
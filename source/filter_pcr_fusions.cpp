@@ -62,8 +62,8 @@ unsigned int filter_pcr_fusions(fusions_t& fusions, const chimeric_alignments_t&
 		    !fusion->second.spliced1 && !fusion->second.spliced2 && // breakpoints at splice sites are almost exclusively a result of splicing and thus, no PCR/RT-mediated fusions
 		    fusion->second.exonic1 && fusion->second.exonic2 && // PCR/RT fusions only contain spliced transcripts, so we ignore intronic/intergenic breakpoints
 		    fusion->second.split_read1_list.size() + fusion->second.split_read2_list.size() > 0 && // require a split read for exact location of the breakpoint
-		    fusion->second.filter != FILTERS.at("merge_adjacent") && // slightly varying alignments may lead to adjacent breakpoints, we should not count them as separate breakpoints
-		    fusion->second.filter != FILTERS.at("uninteresting_contigs")) { // skip uninteresting contigs to save some runtime/memory
+		    fusion->second.filter != get_filter(FILTER_MERGE_ADJACENT) && // slightly varying alignments may lead to adjacent breakpoints, we should not count them as separate breakpoints
+		    fusion->second.filter != get_filter(FILTER_UNINTERESTING_CONTIGS)) { // skip uninteresting contigs to save some runtime/memory
 			exonic_breakpoints_by_gene_pair[make_tuple(fusion->second.gene1, fusion->second.gene2)]++;
 			exonic_breakpoints_by_gene_pair[make_tuple(fusion->second.gene2, fusion->second.gene1)]++;
 		}
@@ -109,7 +109,7 @@ unsigned int filter_pcr_fusions(fusions_t& fusions, const chimeric_alignments_t&
 
 		if (fusion->second.filter != NULL && // fusion has already been filtered
 		    // also tag filtered events, if they are spliced to prevent the filters 'spliced' and 'many_spliced' from recovering them
-		    !((fusion->second.spliced1 || fusion->second.spliced2) && (fusion->second.filter == FILTERS.at("relative_support") || fusion->second.filter == FILTERS.at("min_support"))))
+		    !((fusion->second.spliced1 || fusion->second.spliced2) && (fusion->second.filter == get_filter(FILTER_RELATIVE_SUPPORT) || fusion->second.filter == get_filter(FILTER_MIN_SUPPORT))))
 			continue;
 
 		// PCR/RT-mediated fusions often have both breakpoints within exons,
@@ -200,7 +200,7 @@ unsigned int filter_pcr_fusions(fusions_t& fusions, const chimeric_alignments_t&
 				fusion->second.supporting_reads() <= 1
 			)
 		   )
-			fusion->second.filter = FILTERS.at("pcr_fusions");
+			fusion->second.filter = get_filter(FILTER_PCR_FUSIONS);
 
 	}
 
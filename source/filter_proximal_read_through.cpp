@@ -34,7 +34,7 @@ unsigned int filter_proximal_read_through(chimeric_alignments_t& chimeric_alignm
 
 			// remove chimeric alignment when mates map too close to end of gene
 			if (forward_mate->end >= reverse_gene_start - min_distance || reverse_mate->start <= forward_gene_end + min_distance) {
-				chimeric_alignment->second.filter = FILTERS.at("read_through");
+				chimeric_alignment->second.filter = get_filter(FILTER_READ_THROUGH);
 				continue;
 			}
 		}
@@ -196,7 +196,7 @@ unsigned int filter_relative_support(fusions_t& fusions, const float evalue_cuto
 		    !(fusion->second.is_intragenic() && fusion->second.split_reads1 + fusion->second.split_reads2 == 0)) { // but ignore intragenic fusions only supported by discordant mates
 			remaining++;
 		} else {
-			fusion->second.filter = FILTERS.at("relative_support");
+			fusion->second.filter = get_filter(FILTER_RELATIVE_SUPPORT);
 		}
 	}
 	return remaining;
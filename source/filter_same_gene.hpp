@@ -5,6 +5,6 @@
 
 using namespace std;
 
-unsigned int filter_same_gene(chimeric_alignments_t& chimeric_alignments, exon_annotation_index_t& exon_annotation_index);
+bool is_same_gene(const mates_t& mates);
 
 #endif /* _FILTER_SAME_GENE_H */
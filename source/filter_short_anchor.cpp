@@ -14,7 +14,7 @@ unsigned int filter_short_anchor(fusions_t& fusions, unsigned int min_length) {
 		if (!(fusion->second.spliced1 && fusion->second.spliced2) &&
 		    (abs(fusion->second.anchor_start1 - fusion->second.breakpoint1) < min_length ||
 		     abs(fusion->second.anchor_start2 - fusion->second.breakpoint2) < min_length)) {
-			fusion->second.filter = FILTERS.at("short_anchor");
+			fusion->second.filter = get_filter(FILTER_SHORT_ANCHOR);
 		} else {
 			remaining++;
 		}
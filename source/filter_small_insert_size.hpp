@@ -5,7 +5,7 @@
 
 using namespace std;
 
-unsigned int filter_small_insert_size(chimeric_alignments_t& chimeric_alignments, const unsigned int max_overhang);
+bool has_small_insert_size(const mates_t& mates, const unsigned int max_overhang);
 
 #endif /* _FILTER_SMALL_INSERT_SIZE_H */
 
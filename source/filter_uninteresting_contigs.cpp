@@ -22,7 +22,7 @@ unsigned int filter_uninteresting_contigs(chimeric_alignments_t& chimeric_alignm
 				++remaining;
 				break;
 			} else if (!interesting_contigs_bool[mate->contig]) {
-				chimeric_alignment->second.filter = FILTERS.at("uninteresting_contigs");
+				chimeric_alignment->second.filter = get_filter(FILTER_UNINTERESTING_CONTIGS);
 				break;
 			}
 		}
@@ -41,7 +41,7 @@ void predict_fusion_strands(fusion_t& fusion) {
 
 	for (auto discordant_mate = fusion.discordant_mate_list.begin(); discordant_mate != fusion.discordant_mate_list.end(); ++discordant_mate) {
 		if (!(**discordant_mate).second[MATE1].predicted_strand_ambiguous &&
-		    (**discordant_mate).second.filter != FILTERS.at("hairpin")) { // skip discordant mates arising from hairpin structures, because they are usually ambiguous
+		    (**discordant_mate).second.filter != get_filter(FILTER_HAIRPIN)) { // skip discordant mates arising from hairpin structures, because they are usually ambiguous
 
 			// find out which mate supports breakpoint1
 			alignment_t* mate1 = &(**discordant_mate).second[MATE1];
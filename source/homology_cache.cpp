@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include <zlib.h>
+#include "common.hpp"
+#include "homology_cache.hpp"
+
+using namespace std;
+
+// the cache is only valid for the assembly it was made from and for the same parameters,
+// so the header stores a checksum of the assembly as well as the parameters of the homology check
+string get_homology_cache_header(const string& assembly_file, const contigs_t& contigs, const assembly_t& assembly, const char kmer_length, const float max_identity_fraction, const bool screen_homologs) {
+
+	// checksumming the sequences of all contigs would take seconds on every run,
+	// so the assembly is identified by the size and modification time of the FASTA file instead
+	struct stat file_status;
+	long long int file_size = 0, modification_time = 0;
+	if (stat(assembly_file.c_str(), &file_status) == 0) {
+		file_size = file_status.st_size;
+		modification_time = file_status.st_mtime;
+	}
+	uLong checksum = crc32(0L, Z_NULL, 0);
+	checksum = crc32(checksum, (const Bytef*) &file_size, sizeof(file_size));
+	checksum = crc32(checksum, (const Bytef*) &modification_time, sizeof(modification_time));
+
+	// as well as by the names and lengths of the loaded contigs in the order of their IDs, such that different IDs yield a different checksum
+	vector< pair<contig_t,string> > loaded_contigs;
+	for (contigs_t::const_iterator contig = contigs.begin(); contig != contigs.end(); ++contig)
+		if (assembly.find(contig->second) != assembly.end())
+			loaded_contigs.push_back(make_pair(contig->second, contig->first));
+	sort(loaded_contigs.begin(), loaded_contigs.end());
+	for (auto contig = loaded_contigs.begin(); contig != loaded_contigs.end(); ++contig) {
+		const long unsigned int length = assembly.at(contig->first).size();
+		checksum = crc32(checksum, (const Bytef*) &contig->first, sizeof(contig->first));
+		checksum = crc32(checksum, (const Bytef*) contig->second.c_str(), contig->second.size() + 1);
+		checksum = crc32(checksum, (const Bytef*) &length, sizeof(length));
+	}
+
+	ostringstream header;
+	header << "#homology_cache\tversion=" << HOMOLOGY_CACHE_VERSION << "\tassembly=" << hex << checksum << dec << "\tkmer_length=" << ((int) kmer_length) << "\tmax_identity=" << max_identity_fraction << "\tscreened=" << screen_homologs;
+	return header.str();
+}
+
+// returns false, if the cache does not exist or if it was made from a different assembly or with different parameters
+bool load_homology_cache(const string& cache_file, const string& assembly_file, const contigs_t& contigs, const assembly_t& assembly, const char kmer_length, const float max_identity_fraction, const bool screen_homologs, homology_cache_t& homology_cache) {
+
+	homology_cache.header = get_homology_cache_header(assembly_file, contigs, assembly, kmer_length, max_identity_fraction, screen_homologs);
+	ifstream cache(cache_file.c_str());
+	if (!cache.is_open())
+		return false;
+
+	// check if the cache is compatible with the given input
+	string line;
+	if (!getline(cache, line) || line != homology_cache.header)
+		return false;
+
+	// load results of previous homology checks
+	while (getline(cache, line)) {
+		if (line.empty())
+			continue;
+		istringstream iss(line);
+		int contig1, contig2;
+		position_t start1, end1, start2, end2;
+		int strand1, strand2;
+		int is_homolog;
+		if (!(iss >> contig1 >> start1 >> end1 >> strand1 >> contig2 >> start2 >> end2 >> strand2 >> is_homolog)) {
+			cerr << "WARNING: malformed line in homology cache '" << cache_file << "': " << line << endl;
+			continue;
+		}
+		homology_cache.is_homolog[gene_pair_coordinates_t(contig1, start1, end1, strand1, contig2, start2, end2, strand2)] = is_homolog;
+	}
+
+	return true;
+}
+
+void save_homology_cache(const string& cache_file, const homology_cache_t& homology_cache) {
+
+	// write to temporary file first and rename it when done, so that concurrent runs never see an incomplete cache
+	const string temporary_file = cache_file + ".tmp" + to_string(static_cast<long long int>(getpid()));
+	ofstream cache(temporary_file.c_str(), ios::trunc);
+	if (!cache.is_open()) {
+		cerr << "WARNING: failed to open homology cache '" << cache_file << "' for writing, results are not cached" << endl;
+		return;
+	}
+
+	cache << homology_cache.header << endl;
+	for (auto entry = homology_cache.is_homolog.begin(); entry != homology_cache.is_homolog.end(); ++entry)
+		cache << get<0>(entry->first) << "\t" << get<1>(entry->first) << "\t" << get<2>(entry->first) << "\t" << get<3>(entry->first) << "\t"
+		      << get<4>(entry->first) << "\t" << get<5>(entry->first) << "\t" << get<6>(entry->first) << "\t" << get<7>(entry->first) << "\t"
+		      << entry->second << endl;
+
+	cache.close();
+	if (cache.fail() || rename(temporary_file.c_str(), cache_file.c_str()) != 0) {
+		cerr << "WARNING: failed to write homology cache '" << cache_file << "', results are not cached" << endl;
+		unlink(temporary_file.c_str());
+	}
+}
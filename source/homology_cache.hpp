@@ -0,0 +1,41 @@
+#ifndef _HOMOLOGY_CACHE_H
+#define _HOMOLOGY_CACHE_H 1
+
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include "common.hpp"
+
+using namespace std;
+
+// increment whenever the format of the cache file or the algorithm to detect homologs changes
+const unsigned int HOMOLOGY_CACHE_VERSION = 3;
+
+// genes are identified by their coordinates rather than by their names or IDs,
+// because the outcome of the homology check only depends on the coordinates and the sequence of the genes
+typedef tuple<contig_t,position_t,position_t,strand_t> gene_coordinates_t;
+typedef tuple<contig_t,position_t,position_t,strand_t,contig_t,position_t,position_t,strand_t> gene_pair_coordinates_t;
+
+struct homology_cache_t {
+	string header; // identifies the assembly and the parameters the results are valid for
+	unordered_map<gene_pair_coordinates_t,bool> is_homolog;
+	unsigned int new_entries; // number of entries not yet stored in the cache file
+	homology_cache_t(): new_entries(0) {};
+};
+
+// the smaller gene comes first, as in is_homolog(), such that a pair of genes has the same key regardless of the order it is checked in
+// (when both genes have the same length, the result of is_homolog() depends on the order, so the order is kept)
+// the strand of each gene moves along with it, since is_homolog() only considers whether the strands differ
+inline gene_pair_coordinates_t get_gene_pair_coordinates(gene_t gene1, gene_t gene2) {
+	if (gene1->length() > gene2->length())
+		swap(gene1, gene2);
+	return tuple_cat(gene_coordinates_t(gene1->contig, gene1->start, gene1->end, gene1->strand), gene_coordinates_t(gene2->contig, gene2->start, gene2->end, gene2->strand));
+}
+
+// load_homology_cache() must be called before save_homology_cache(), even if the cache file does not exist yet
+// the cache is optional, so save_homology_cache() only prints a warning, if the file cannot be written
+bool load_homology_cache(const string& cache_file, const string& assembly_file, const contigs_t& contigs, const assembly_t& assembly, const char kmer_length, const float max_identity_fraction, const bool screen_homologs, homology_cache_t& homology_cache);
+
+void save_homology_cache(const string& cache_file, const homology_cache_t& homology_cache);
+
+#endif /* _HOMOLOGY_CACHE_H */
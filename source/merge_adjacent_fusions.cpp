@@ -78,7 +78,7 @@ unsigned int merge_adjacent_fusions(fusions_t& fusions, const int max_distance)
 			(**fusion).split_reads1 += sum_split_reads1;
 			(**fusion).split_reads2 += sum_split_reads2;
 			for (unsigned int k = 0; k < adjacent_fusions.size(); ++k)
-				adjacent_fusions[k]->filter = FILTERS.at("merge_adjacent");
+				adjacent_fusions[k]->filter = get_filter(FILTER_MERGE_ADJACENT);
 		}
 	}
 
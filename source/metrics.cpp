@@ -0,0 +1,112 @@
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <sys/resource.h>
+#include <unistd.h>
+#include "metrics.hpp"
+
+using namespace std;
+
+// user + system time consumed by all threads of the process so far
+static double get_cpu_time() {
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+	return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+// high-water mark of the resident set size in kB (getrusage reports kB on Linux)
+static long int get_peak_rss() {
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return -1;
+	return usage.ru_maxrss;
+}
+
+// current resident set size in kB or -1, if /proc is not available
+static long int get_current_rss() {
+	ifstream statm("/proc/self/statm");
+	long int total_pages, resident_pages;
+	if (!(statm >> total_pages >> resident_pages))
+		return -1;
+	return resident_pages * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+void start_stage(metrics_t& metrics, const string& name) {
+	stage_metrics_t stage;
+	stage.name = name;
+	stage.wall_time = -1;
+	stage.cpu_time = -1;
+	stage.summed_thread_time = -1;
+	stage.peak_rss = -1;
+	stage.rss_delta = 0;
+	stage.input = metrics.items;
+	stage.output = NO_COUNT;
+	metrics.stages.push_back(stage);
+
+	metrics.start_rss = get_current_rss();
+	metrics.start_cpu_time = get_cpu_time();
+	metrics.start_time = chrono::steady_clock::now();
+}
+
+long long int end_stage(metrics_t& metrics, const long long int output) {
+	stage_metrics_t& stage = metrics.stages.back();
+	stage.wall_time = chrono::duration<double>(chrono::steady_clock::now() - metrics.start_time).count();
+	stage.cpu_time = get_cpu_time() - metrics.start_cpu_time;
+	stage.peak_rss = get_peak_rss();
+	long int current_rss = get_current_rss();
+	if (current_rss >= 0 && metrics.start_rss >= 0)
+		stage.rss_delta = current_rss - metrics.start_rss;
+	stage.output = (output == NO_COUNT) ? stage.input : output;
+	metrics.items = stage.output;
+	return stage.output;
+}
+
+void add_stage(metrics_t& metrics, const string& name, const double summed_thread_time, const long long int input, const long long int output) {
+	stage_metrics_t stage;
+	stage.name = name;
+	stage.wall_time = -1;
+	stage.cpu_time = -1;
+	stage.summed_thread_time = summed_thread_time;
+	stage.peak_rss = -1;
+	stage.rss_delta = 0;
+	stage.input = input;
+	stage.output = output;
+	metrics.stages.push_back(stage);
+}
+
+// write a tab-separated table with one line per stage
+// values which were not measured are written as "."
+void write_metrics(const string& output_file, const metrics_t& metrics) {
+	ofstream out(output_file);
+	if (!out.is_open()) {
+		cerr << "ERROR: Failed to open metrics file '" << output_file << "'." << endl;
+		exit(1);
+	}
+	out << "#stage\twall_time\tcpu_time\tsummed_thread_time\tpeak_rss_kb\trss_delta_kb\tinput\toutput\titems_per_second" << endl;
+	for (auto stage = metrics.stages.begin(); stage != metrics.stages.end(); ++stage) {
+		out << stage->name << "\t";
+		if (stage->wall_time >= 0) out << stage->wall_time; else out << ".";
+		out << "\t";
+		if (stage->cpu_time >= 0) out << stage->cpu_time; else out << ".";
+		out << "\t";
+		if (stage->summed_thread_time >= 0) out << stage->summed_thread_time; else out << ".";
+		out << "\t";
+		if (stage->peak_rss >= 0) out << stage->peak_rss << "\t" << stage->rss_delta; else out << ".\t.";
+		out << "\t";
+		if (stage->input != NO_COUNT) out << stage->input; else out << ".";
+		out << "\t";
+		if (stage->output != NO_COUNT) out << stage->output; else out << ".";
+		out << "\t";
+		// throughput is based on wall time, or on the time spent in the stage summed over all threads, if wall time was not measured
+		const double time = (stage->wall_time >= 0) ? stage->wall_time : stage->summed_thread_time;
+		if (stage->input != NO_COUNT && time > 0) out << (stage->input / time); else out << ".";
+		out << endl;
+	}
+	if (out.bad()) {
+		cerr << "ERROR: Failed to write to metrics file '" << output_file << "'." << endl;
+		exit(1);
+	}
+}
@@ -0,0 +1,47 @@
+#ifndef _METRICS_H
+#define _METRICS_H 1
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+const long long int NO_COUNT = -1; // marks stages which do not process countable items (reads/fusions)
+
+// resource usage of a single step of the workflow
+struct stage_metrics_t {
+	string name;
+	double wall_time; // in seconds, negative if not measured
+	double cpu_time; // user + system time of all threads in seconds, negative if not measured
+	double summed_thread_time; // time spent in the stage summed over all threads that ran it in seconds, negative if not measured
+	long int peak_rss; // high-water mark of the resident set size in kB at the end of the stage, negative if not measured
+	long int rss_delta; // change of the resident set size in kB over the course of the stage
+	long long int input; // number of items (reads or fusions) before the stage
+	long long int output; // number of items after the stage
+};
+
+struct metrics_t {
+	vector<stage_metrics_t> stages;
+	long long int items; // number of items after the last stage, which is taken as input to the next stage
+	// resource usage at the start of the current stage
+	chrono::steady_clock::time_point start_time;
+	double start_cpu_time;
+	long int start_rss;
+	metrics_t(): items(NO_COUNT), start_cpu_time(0), start_rss(-1) {}
+};
+
+// begin measuring the resource usage of a stage
+void start_stage(metrics_t& metrics, const string& name);
+
+// finish measuring the current stage and return the number of items after the stage
+// if <output> is NO_COUNT, the stage is assumed not to change the number of items
+long long int end_stage(metrics_t& metrics, const long long int output = NO_COUNT);
+
+// record a stage which was measured elsewhere, such as the individual filters of the read-filter chain
+// only the time spent in the stage summed over all threads is known for such stages, not the wall time or the CPU time
+void add_stage(metrics_t& metrics, const string& name, const double summed_thread_time, const long long int input, const long long int output);
+
+void write_metrics(const string& output_file, const metrics_t& metrics);
+
+#endif /* _METRICS_H */
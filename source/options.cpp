@@ -79,7 +79,9 @@ options_t get_default_options() {
 	options.evalue_cutoff = 0.3;
 	options.min_support = 2;
 	options.max_mismapper_fraction = 0.8;
+	options.banded_alignment = false;
 	options.max_homolog_identity = 0.3;
+	options.screen_homologs = false;
 	options.min_anchor_length = 23;
 	options.homopolymer_length = 6;
 	options.max_genomic_breakpoint_distance = 100000;
@@ -99,6 +101,7 @@ options_t get_default_options() {
 	options.subsampling_threshold = 300;
 	options.high_expression_quantile = 0.998;
 	options.exonic_fraction = 0.2;
+	options.threads = 1;
 
 	return options;
 }
@@ -136,9 +139,14 @@ void print_usage() {
 	     << wrap_help("-g FILE", "GTF file with gene annotation. The file may be gzip-compressed.")
 	     << wrap_help("-G GTF_FEATURES", "Comma-/space-separated list of names of GTF features.\n"
 	                  "Default: " + default_options.gtf_features)
+	     << wrap_help("-Z FILE", "Binary cache of the annotation given via -g. If the file exists "
+	                  "and was made from the same GTF file with the same GTF features (-G), the "
+	                  "annotation is loaded from the cache instead of parsing the GTF file. "
+	                  "Otherwise, the GTF file is parsed and the cache is (re-)created.")
 	     << wrap_help("-a FILE", "FastA file with genome sequence (assembly). "
 	                  "The file may be gzip-compressed. An index with the file extension .fai "
-	                  "must exist only if CRAM files are processed.")
+	                  "must exist only if CRAM files are processed. If an index exists, only the "
+	                  "sequences of the interesting contigs are read, which speeds up loading.")
 	     << wrap_help("-b FILE", "File containing blacklisted events (recurrent artifacts "
 	                  "and transcripts observed in healthy tissue).")
 	     << wrap_help("-k FILE", "File containing known/recurrent fusions. Some cancer "
@@ -184,6 +192,16 @@ void print_usage() {
 	     << wrap_help("-L MAX_HOMOLOG_IDENTITY", "Genes with more than the given fraction of "
 	                  "sequence identity are considered homologs and removed by the 'homologs' "
 	                  "filter. Default: " + to_string(static_cast<long double>(default_options.max_homolog_identity)))
+	     << wrap_help("-q FILE", "File to store the results of the 'homologs' filter in. "
+	                  "Pairs of genes which have been compared in a previous run with the same "
+	                  "assembly are looked up from the file rather than compared again. The file "
+	                  "is created if it does not exist and extended with new pairs of genes. "
+	                  "Default: no cache")
+	     << wrap_help("-J", "When set, the 'homologs' filter first estimates the sequence "
+	                  "identity of two genes from samples of their k-mers and only compares "
+	                  "their sequences, if the estimate does not clearly rule out homology. "
+	                  "This is much faster, but in rare cases a pair of homologs may be missed. "
+	                  "Default: " + string((default_options.screen_homologs) ? "on" : "off"))
 	     << wrap_help("-H HOMOPOLYMER_LENGTH", "The 'homopolymer' filter removes breakpoints "
 	                  "adjacent to homopolymers of the given length or more. Default: " + to_string(static_cast<long long unsigned int>(default_options.homopolymer_length)))
 	     << wrap_help("-R READ_THROUGH_DISTANCE", "The 'read_through' filter removes read-through fusions "
@@ -222,6 +240,40 @@ void print_usage() {
 	                  "If the fraction of exonic sequence between two breakpoints is smaller than "
 	                  "the given fraction, the 'intragenic_exonic' filter discards the event. "
 	                  "Default: " + to_string(static_cast<long double>(default_options.exonic_fraction)))
+	     << wrap_help("-@ THREADS", "Number of threads to use for decompressing and decoding "
+	                  "the input files in SAM/BAM/CRAM format and for classifying the fragments. When "
+	                  "the file given via -x is sorted by coordinate and indexed, its contigs are "
+	                  "processed in parallel. With more than two threads, a quarter of them "
+	                  "(at least one) decompresses the input, the others classify the fragments. The "
+	                  "read-level filters and the re-alignment of the filter "
+	                  "'mismappers' are run in parallel, too. "
+	                  "Default: " + to_string(static_cast<long long unsigned int>(default_options.threads)))
+	     << wrap_help("-t FILE", "File to write the wall time, CPU time, memory consumption, "
+	                  "and number of reads/fusions before and after each step of the workflow to. "
+	                  "Default: no metrics")
+	     << wrap_help("-C FILE", "File to save the coverage and the number of mapped reads to "
+	                  "after reading the alignments. The file can be passed to later runs on the "
+	                  "same sample via the parameter -N. Default: do not save coverage")
+	     << wrap_help("-N FILE", "File to load the coverage and the number of mapped reads from, "
+	                  "as saved via the parameter -C. Normal reads of the file given via -x are "
+	                  "then not counted. The file must have been made with the same assembly and "
+	                  "interesting contigs. Default: count normal reads")
+	     << wrap_help("-y FILE", "File to save a checkpoint to after the alignments have been "
+	                  "read and annotated. Later runs can resume from the checkpoint via the "
+	                  "parameter -Y. Default: do not save checkpoint")
+	     << wrap_help("-Y FILE", "Checkpoint to resume from, as saved via the parameter -y. "
+	                  "Reading and annotating the alignments is skipped, so the parameters -x, "
+	                  "-c, -N, and -s are ignored. The annotation, the assembly, and the "
+	                  "interesting contigs must be the same. Default: do not resume")
+	     << wrap_help("-X FILE", "Extraction mode: instead of searching for fusions, write the "
+	                  "records of the file given via -x which are needed to search for fusions "
+	                  "(split reads, discordant mates, read-through candidates) to the given "
+	                  "BAM file and the coverage to the file given via -C. Later runs can pass "
+	                  "the BAM file via -x and the coverage via -N. Default: off")
+	     << wrap_help("-W", "When set, the filter 'mismappers' re-aligns reads using a banded "
+	                  "local alignment around the best k-mer hits instead of the default "
+	                  "seed-and-extend algorithm. The banded alignment has a bounded runtime per "
+	                  "read, even in repetitive genes. Default: " + string((default_options.banded_alignment) ? "on" : "off"))
 	     << wrap_help("-T", "When set, the column 'fusion_transcript' is populated with "
 	                  "the sequence of the fused genes as assembled from the supporting reads. "
 	                  "Specify the flag twice to also print the fusion transcripts to the file "
@@ -253,7 +305,7 @@ options_t parse_arguments(int argc, char **argv) {
 	opterr = 0;
 	int c;
 	string junction_suffix(".junction");
-	while ((c = getopt(argc, argv, "c:x:d:g:G:o:O:a:b:k:s:i:f:E:S:m:L:H:D:R:A:M:K:V:F:U:Q:e:TPIh")) != -1) {
+	while ((c = getopt(argc, argv, "c:x:d:g:G:Z:o:O:a:b:k:s:i:f:E:S:m:L:H:D:R:A:M:K:V:F:U:Q:q:e:@:t:C:N:y:Y:X:WJTPIh")) != -1) {
 
 		switch (c) {
 			case 'c':
@@ -300,6 +352,13 @@ options_t parse_arguments(int argc, char **argv) {
 					}
 				}
 				break;
+			case 'Z':
+				options.annotation_cache_file = optarg;
+				if (!output_directory_exists(options.annotation_cache_file)) {
+					cerr << "ERROR: Parent directory of annotation cache '" << options.annotation_cache_file << "' does not exist." << endl;
+					exit(1);
+				}
+				break;
 			case 'o':
 				options.output_file = optarg;
 				if (!output_directory_exists(options.output_file)) {
@@ -401,6 +460,55 @@ options_t parse_arguments(int argc, char **argv) {
 					exit(1);
 				}
 				break;
+			case 'q':
+				options.homology_cache_file = optarg;
+				if (!output_directory_exists(options.homology_cache_file)) {
+					cerr << "ERROR: Parent directory of homology cache '" << options.homology_cache_file << "' does not exist." << endl;
+					exit(1);
+				}
+				break;
+			case 't':
+				options.metrics_file = optarg;
+				if (!output_directory_exists(options.metrics_file)) {
+					cerr << "ERROR: Parent directory of metrics file '" << options.metrics_file << "' does not exist." << endl;
+					exit(1);
+				}
+				break;
+			case 'C':
+				options.coverage_output_file = optarg;
+				if (!output_directory_exists(options.coverage_output_file)) {
+					cerr << "ERROR: Parent directory of coverage file '" << options.coverage_output_file << "' does not exist." << endl;
+					exit(1);
+				}
+				break;
+			case 'N':
+				options.coverage_input_file = optarg;
+				if (access(options.coverage_input_file.c_str(), R_OK) != 0) {
+					cerr << "ERROR: File '" << options.coverage_input_file << "' not found." << endl;
+					exit(1);
+				}
+				break;
+			case 'y':
+				options.checkpoint_output_file = optarg;
+				if (!output_directory_exists(options.checkpoint_output_file)) {
+					cerr << "ERROR: Parent directory of checkpoint '" << options.checkpoint_output_file << "' does not exist." << endl;
+					exit(1);
+				}
+				break;
+			case 'Y':
+				options.checkpoint_input_file = optarg;
+				if (access(options.checkpoint_input_file.c_str(), R_OK) != 0) {
+					cerr << "ERROR: File '" << options.checkpoint_input_file << "' not found." << endl;
+					exit(1);
+				}
+				break;
+			case 'X':
+				options.extraction_output_file = optarg;
+				if (!output_directory_exists(options.extraction_output_file)) {
+					cerr << "ERROR: Parent directory of output file '" << options.extraction_output_file << "' does not exist." << endl;
+					exit(1);
+				}
+				break;
 			case 'H':
 				if (!validate_int(optarg, options.homopolymer_length, 2)) {
 					cerr << "ERROR: " << "Argument to -" << ((char) c) << " must be greater than 1." << endl;
@@ -467,6 +575,18 @@ options_t parse_arguments(int argc, char **argv) {
 					exit(1);
 				}
 				break;
+			case '@':
+				if (!validate_int(optarg, options.threads, 1)) {
+					cerr << "ERROR: " << "Argument to -" << ((char) c) << " must be an integer greater than 0." << endl;
+					exit(1);
+				}
+				break;
+			case 'W':
+				options.banded_alignment = true;
+				break;
+			case 'J':
+				options.screen_homologs = true;
+				break;
 			case 'T':
 				if (!options.print_fusion_sequence)
 					options.print_fusion_sequence = true;
@@ -491,7 +611,7 @@ options_t parse_arguments(int argc, char **argv) {
 				break;
 			default:
 				switch (optopt) {
-					case 'c': case 'x': case 'd': case 'g': case 'G': case 'o': case 'O': case 'a': case 'k': case 'b': case 'i': case 'f': case 'E': case 's': case 'm': case 'H': case 'D': case 'R': case 'A': case 'M': case 'K': case 'V': case 'F': case 'S': case 'U': case 'Q':
+					case 'c': case 'x': case 'd': case 'g': case 'G': case 'Z': case 'o': case 'O': case 'a': case 'k': case 'b': case 'i': case 'f': case 'E': case 's': case 'm': case 'H': case 'D': case 'R': case 'A': case 'M': case 'K': case 'V': case 'F': case 'S': case 'U': case 'Q': case 'q': case '@': case 't': case 'C': case 'N': case 'y': case 'Y': case 'X':
 						cerr << "ERROR: " << "Option -" << ((char) optopt) << " requires an argument." << endl;
 						exit(1);
 						break;
@@ -515,7 +635,7 @@ options_t parse_arguments(int argc, char **argv) {
 		print_usage();
 		exit(1);
 	}
-	if (options.rna_bam_file.empty()) {
+	if (options.rna_bam_file.empty() && options.checkpoint_input_file.empty()) { // when resuming from a checkpoint, the alignments are not read again
 		cerr << "ERROR: Missing mandatory option: -x" << endl;
 		exit(1);
 	}
@@ -523,7 +643,7 @@ options_t parse_arguments(int argc, char **argv) {
 		cerr << "ERROR: Missing mandatory option: -g" << endl;
 		exit(1);
 	}
-	if (options.output_file.empty()) {
+	if (options.output_file.empty() && options.extraction_output_file.empty()) { // no fusions are reported in extraction mode
 		cerr << "ERROR: Missing mandatory option: -o" << endl;
 		exit(1);
 	}
@@ -531,7 +651,17 @@ options_t parse_arguments(int argc, char **argv) {
         	cerr << "ERROR: Missing mandatory option: -a" << endl;
 		exit(1);
 	}
-	if (options.filters["blacklist"] && options.blacklist_file.empty()) {
+	if (!options.extraction_output_file.empty()) {
+		if (options.coverage_output_file.empty()) {
+			cerr << "ERROR: Option -X requires option -C" << endl;
+			exit(1);
+		}
+		if (options.rna_bam_file.empty() || !options.coverage_input_file.empty() || !options.checkpoint_input_file.empty()) {
+			cerr << "ERROR: Option -X requires option -x and cannot be combined with options -N or -Y" << endl;
+			exit(1);
+		}
+	}
+	if (options.filters["blacklist"] && options.blacklist_file.empty() && options.extraction_output_file.empty()) {
 		cerr << "ERROR: Filter 'blacklist' enabled, but missing option: -b" << endl;
 		exit(1);
 	}
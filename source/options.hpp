@@ -26,6 +26,7 @@ struct options_t {
 	string genomic_breakpoints_file;
 	unsigned int max_genomic_breakpoint_distance;
 	string gene_annotation_file;
+	string annotation_cache_file;
 	string exon_annotation_file;
 	string known_fusions_file;
 	string output_file;
@@ -39,7 +40,10 @@ struct options_t {
 	float evalue_cutoff;
 	unsigned int min_support;
 	float max_mismapper_fraction;
+	bool banded_alignment;
 	float max_homolog_identity;
+	string homology_cache_file;
+	bool screen_homologs;
 	unsigned int min_anchor_length;
 	bool print_supporting_reads;
 	bool print_supporting_reads_for_discarded_fusions;
@@ -56,6 +60,13 @@ struct options_t {
 	unsigned int subsampling_threshold;
 	float high_expression_quantile;
 	float exonic_fraction;
+	unsigned int threads;
+	string metrics_file;
+	string coverage_output_file;
+	string coverage_input_file;
+	string checkpoint_output_file;
+	string checkpoint_input_file;
+	string extraction_output_file;
 };
 
 options_t parse_arguments(int argc, char **argv);
@@ -25,7 +25,7 @@ void pileup_chimeric_alignments(vector<chimeric_alignments_t::iterator>& chimeri
 
 	for (auto chimeric_alignment = chimeric_alignments.begin(); chimeric_alignment != chimeric_alignments.end(); ++chimeric_alignment) {
 
-		if ((**chimeric_alignment).second.filter == FILTERS.at("duplicates"))
+		if ((**chimeric_alignment).second.filter == get_filter(FILTER_DUPLICATES))
 			continue; // skip duplicates
 
 		alignment_t& read = (**chimeric_alignment).second[mate]; // introduce alias for cleaner code
@@ -35,7 +35,7 @@ void pileup_chimeric_alignments(vector<chimeric_alignments_t::iterator>& chimeri
 			      direction == UPSTREAM   && read.strand == REVERSE && read.start >= breakpoint-2 && read.start <= breakpoint+200)) // only consider discordant mates close to the breakpoints (we don't care about the ones in other exons)
 				continue;
 
-		string read_sequence = (mate == SUPPLEMENTARY) ? (**chimeric_alignment).second[SPLIT_READ].sequence : read.sequence;
+		string read_sequence = ((mate == SUPPLEMENTARY) ? (**chimeric_alignment).second[SPLIT_READ].sequence : read.sequence).str();
 		if (reverse_complement)
 			read_sequence = dna_to_reverse_complement(read_sequence);
 
@@ -415,7 +415,7 @@ string gene_to_name(const gene_t gene, const contig_t contig, const position_t b
 
 		// append upstream flanking genes with distances to gene name
 		if (index_hit1 != gene_annotation_index[contig].rend()) {
-			for (gene_set_t::iterator gene = index_hit1->second.begin(); gene != index_hit1->second.end(); gene = upper_bound(index_hit1->second.begin(), index_hit1->second.end(), *gene)) {
+			for (gene_view_t::const_iterator gene = index_hit1->second.begin(); gene != index_hit1->second.end(); gene = upper_bound(index_hit1->second.begin(), index_hit1->second.end(), *gene)) {
 				if (!(**gene).is_dummy) {
 					if (!result.empty())
 						result += ",";
@@ -430,7 +430,7 @@ string gene_to_name(const gene_t gene, const contig_t contig, const position_t b
 
 		// append downstream flanking genes with distances to gene name
 		if (index_hit2 != gene_annotation_index[contig].end()) {
-			for (gene_set_t::iterator gene = index_hit2->second.begin(); gene != index_hit2->second.end(); gene = upper_bound(index_hit2->second.begin(), index_hit2->second.end(), *gene)) {
+			for (gene_view_t::const_iterator gene = index_hit2->second.begin(); gene != index_hit2->second.end(); gene = upper_bound(index_hit2->second.begin(), index_hit2->second.end(), *gene)) {
 				if (!(**gene).is_dummy) {
 					if (!result.empty())
 						result += ",";
@@ -660,7 +660,7 @@ int get_reading_frame(const vector<position_t>& transcribed_bases, const int fro
 	position_t right_boundary = max(transcribed_bases[from], transcribed_bases[to]);
 	exon_set_t transcribed_exons;
 	for (auto exon_set = exon_annotation_index[gene->contig].lower_bound(left_boundary); exon_set != exon_annotation_index[gene->contig].end() && (exon_set->second.empty() || (**exon_set->second.begin()).start <= right_boundary); ++exon_set) {
-		for (exon_set_t::const_iterator exon = exon_set->second.begin(); exon != exon_set->second.end(); ++exon) {
+		for (exon_view_t::const_iterator exon = exon_set->second.begin(); exon != exon_set->second.end(); ++exon) {
 			if ((**exon).gene == gene &&
 			    (**exon).coding_region_start != -1 &&
 			    ((**exon).start >= left_boundary && (**exon).start <= right_boundary ||
@@ -0,0 +1,27 @@
+#ifndef _PARALLEL_H
+#define _PARALLEL_H 1
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// execute function(task, thread_id) for every task from 0 to <tasks>-1 using up to <threads> threads
+// idle threads pick the next pending task, such that the load is balanced even when tasks differ in size
+// the calling thread participates as the thread with ID 0
+template <class T> void run_in_parallel(const unsigned int threads, const unsigned int tasks, T function) {
+	atomic<unsigned int> next_task(0);
+	auto worker = [&](const unsigned int thread_id) {
+		for (unsigned int task = next_task++; task < tasks; task = next_task++)
+			function(task, thread_id);
+	};
+	vector<thread> workers;
+	for (unsigned int thread_id = 1; thread_id < threads && thread_id < tasks; ++thread_id)
+		workers.push_back(thread(worker, thread_id));
+	worker(0);
+	for (auto w = workers.begin(); w != workers.end(); ++w)
+		w->join();
+}
+
+#endif /* _PARALLEL_H */
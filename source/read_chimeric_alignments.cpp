@@ -1,18 +1,183 @@
 #include <algorithm>
+#include <atomic>
+#include <climits>
+#include <condition_variable>
+#include <cstring>
+#include <iterator>
 #include <iostream>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 #include "cram.h"
 #include "sam.h"
+#include "thread_pool.h"
 #include "annotation.hpp"
 #include "common.hpp"
+#include "parallel.hpp"
 #include "read_chimeric_alignments.hpp"
 #include "read_stats.hpp"
 
 using namespace std;
 
-typedef map<string,bam1_t*> buffered_bam_records_t;
+// buffer for BAM records whose mate has not been seen yet
+// records are stored in an open-addressing hash table (linear probing) keyed by the hash of the read name;
+// the read names need not be stored separately, because they are part of the buffered records
+// records which are no longer needed are kept in a free list, so that their memory can be reused for new records
+class buffered_bam_records_t {
+	private:
+		struct slot_t {
+			uint64_t hash;
+			bam1_t* bam_record; // NULL means the slot is empty
+		};
+		vector<slot_t> slots; // the number of slots is always a power of 2
+		size_t buffered_count;
+		vector<bam1_t*> free_bam_records;
+		static uint64_t hash_read_name(const char* read_name) { // FNV-1a
+			uint64_t hash = 14695981039346656037ULL;
+			for (; *read_name != '\0'; ++read_name)
+				hash = (hash ^ (unsigned char) *read_name) * 1099511628211ULL;
+			return hash;
+		};
+		size_t find_slot(const uint64_t hash, const char* read_name) const { // returns the slot of the read or the empty slot where it would go
+			size_t slot = hash & (slots.size() - 1);
+			while (slots[slot].bam_record != NULL && (slots[slot].hash != hash || strcmp(bam_get_qname(slots[slot].bam_record), read_name) != 0))
+				slot = (slot + 1) & (slots.size() - 1);
+			return slot;
+		};
+		void grow() {
+			vector<slot_t> old_slots(slots.size() * 2, slot_t());
+			old_slots.swap(slots);
+			for (auto old_slot = old_slots.begin(); old_slot != old_slots.end(); ++old_slot)
+				if (old_slot->bam_record != NULL)
+					slots[find_slot(old_slot->hash, bam_get_qname(old_slot->bam_record))] = *old_slot;
+		};
+		void erase_slot(size_t slot) { // shift subsequent records back, so that lookups need no tombstones
+			for (size_t next_slot = (slot + 1) & (slots.size() - 1); slots[next_slot].bam_record != NULL; next_slot = (next_slot + 1) & (slots.size() - 1)) {
+				size_t home_slot = slots[next_slot].hash & (slots.size() - 1);
+				if ((next_slot > slot) ? (home_slot <= slot || home_slot > next_slot) : (home_slot <= slot && home_slot > next_slot)) {
+					slots[slot] = slots[next_slot];
+					slot = next_slot;
+				}
+			}
+			slots[slot].bam_record = NULL;
+			buffered_count--;
+		};
+		buffered_bam_records_t(const buffered_bam_records_t&); // not copyable
+	public:
+		buffered_bam_records_t(): slots(1024, slot_t()), buffered_count(0) {};
+		~buffered_bam_records_t() {
+			for (auto slot = slots.begin(); slot != slots.end(); ++slot)
+				if (slot->bam_record != NULL)
+					bam_destroy1(slot->bam_record);
+			for (auto bam_record = free_bam_records.begin(); bam_record != free_bam_records.end(); ++bam_record)
+				bam_destroy1(*bam_record);
+		};
+		// if the mate of the given record is buffered, remove it from the buffer and return it,
+		// otherwise buffer the given record and return NULL
+		bam1_t* find_mate_or_insert(bam1_t* bam_record) {
+			uint64_t hash = hash_read_name(bam_get_qname(bam_record));
+			size_t slot = find_slot(hash, bam_get_qname(bam_record));
+			if (slots[slot].bam_record != NULL) {
+				bam1_t* mate = slots[slot].bam_record;
+				erase_slot(slot);
+				return mate;
+			}
+			if ((buffered_count + 1) * 2 > slots.size()) { // keep load factor below 0.5
+				grow();
+				slot = find_slot(hash, bam_get_qname(bam_record));
+			}
+			slots[slot].hash = hash;
+			slots[slot].bam_record = bam_record;
+			buffered_count++;
+			return NULL;
+		};
+		// remove all records from the buffer and hand them over to the caller
+		void extract_all(vector<bam1_t*>& bam_records) {
+			for (auto slot = slots.begin(); slot != slots.end(); ++slot)
+				if (slot->bam_record != NULL) {
+					bam_records.push_back(slot->bam_record);
+					slot->bam_record = NULL;
+				}
+			buffered_count = 0;
+		};
+		// get memory for a record from the free list or allocate new memory
+		bam1_t* new_bam_record() {
+			if (!free_bam_records.empty()) {
+				bam1_t* bam_record = free_bam_records.back();
+				free_bam_records.pop_back();
+				return bam_record;
+			}
+			bam1_t* bam_record = bam_init1();
+			if (bam_record == NULL) {
+				cerr << "ERROR: failed to allocate memory." << endl;
+				exit(1);
+			}
+			return bam_record;
+		};
+		// put a record that is no longer needed in the free list
+		void recycle_bam_record(bam1_t* bam_record) {
+			free_bam_records.push_back(bam_record);
+		};
+};
 typedef vector<contig_t> tid_to_contig_t;
 
+// when BAM records are decoded and classified in separate threads,
+// the records are passed between the threads in batches
+const unsigned int BAM_RECORD_BATCH_SIZE = 1000; // number of records per batch
+const unsigned int BAM_RECORD_BATCHES = 16; // number of batches in flight between the decoding and the classification stage
+const unsigned int FRAGMENTS_PER_ROUND = 65536; // number of complete fragments which are collected before they are classified in parallel
+struct bam_record_batch_t {
+	vector<bam1_t*> records;
+	unsigned int size; // number of valid records in <records>
+};
+
+// ring buffer for passing items between exactly one producer thread and one consumer thread
+// push() and pop() block while the buffer is full or empty, respectively:
+// they yield a few times first, because the other thread usually catches up quickly,
+// and then wait on a condition variable, such that a stalled thread does not keep a core busy
+const unsigned int BOUNDED_QUEUE_SPINS = 64; // number of times to yield before waiting on the condition variable
+template <class T> class bounded_queue_t {
+	private:
+		vector<T> items;
+		atomic<size_t> head; // next position to pop from (only written by the consumer)
+		atomic<size_t> tail; // next position to push to (only written by the producer)
+		mutex state_mutex;
+		condition_variable state_changed;
+		template <class P> void wait_until(P is_ready) {
+			for (unsigned int spins = 0; !is_ready(); ++spins) {
+				if (spins < BOUNDED_QUEUE_SPINS) {
+					this_thread::yield();
+				} else {
+					unique_lock<mutex> lock(state_mutex);
+					state_changed.wait(lock, is_ready);
+				}
+			}
+		};
+		void notify() {
+			lock_guard<mutex> lock(state_mutex); // a waiting thread checks the state while it holds the lock, so no notification is lost
+			state_changed.notify_one();
+		};
+	public:
+		bounded_queue_t(const size_t capacity): items(capacity+1), head(0), tail(0) {};
+		void push(const T& item) {
+			size_t current_tail = tail.load(memory_order_relaxed);
+			size_t next_tail = (current_tail + 1) % items.size();
+			wait_until([&]() { return next_tail != head.load(memory_order_acquire); }); // wait while queue is full
+			items[current_tail] = item;
+			tail.store(next_tail, memory_order_release);
+			notify();
+		};
+		T pop() {
+			size_t current_head = head.load(memory_order_relaxed);
+			wait_until([&]() { return current_head != tail.load(memory_order_acquire); }); // wait while queue is empty
+			T item = items[current_head];
+			head.store((current_head + 1) % items.size(), memory_order_release);
+			notify();
+			return item;
+		};
+};
+
 bool find_spanning_intron(const bam1_t* bam_record, const position_t gene1_end, const position_t gene2_start, unsigned int& cigar_op, position_t& read_pos) {
 
 	if (bam_record->core.n_cigar < 3)
@@ -43,6 +208,8 @@ void add_chimeric_alignment(chimeric_alignments_t& chimeric_alignments, const ba
 	string name = (char*) bam_get_qname(bam_record);
 	mates_t* mates = &chimeric_alignments[name];
 	mates->single_end = !(bam_record->core.flag & BAM_FPAIRED);
+	if (mates->empty())
+		mates->reserve(3); // a fragment has at most three alignments, reserve space to avoid reallocations
 	mates->resize(mates->size()+1);
 	alignment_t& alignment = (*mates)[mates->size()-1];
 	alignment.strand = (bam_record->core.flag & BAM_FREVERSE) ? REVERSE : FORWARD;
@@ -50,9 +217,7 @@ void add_chimeric_alignment(chimeric_alignments_t& chimeric_alignments, const ba
 	alignment.contig = bam_record->core.tid;
 	alignment.supplementary = is_supplementary;
 	if (!is_supplementary) { // only keep sequence in memory, if this is not the supplementary alignment (because then it's already stored in the split-read)
-		alignment.sequence.resize(bam_record->core.l_qseq);
-		for (int i = 0; i < bam_record->core.l_qseq; ++i)
-			alignment.sequence[i] = seq_nt16_str[bam_seqi(bam_get_seq(bam_record), i)];
+		alignment.sequence.assign_packed(bam_get_seq(bam_record), bam_record->core.l_qseq);
 	}
 
 	// read-through alignments need to be split into a split-read and a supplementary alignment
@@ -79,7 +244,8 @@ void add_chimeric_alignment(chimeric_alignments_t& chimeric_alignments, const ba
 	}
 }
 
-bool extract_read_through_alignment(chimeric_alignments_t& chimeric_alignments, bam1_t* forward_mate, bam1_t* reverse_mate, const gene_annotation_index_t& gene_annotation_index, const bool separate_chimeric_bam_file) {
+// <separate_chimeric_alignments> holds the alignments loaded from Chimeric.out.sam (if given) to avoid that the same read is added twice
+bool extract_read_through_alignment(chimeric_alignments_t& chimeric_alignments, const chimeric_alignments_t& separate_chimeric_alignments, bam1_t* forward_mate, bam1_t* reverse_mate, const gene_annotation_index_t& gene_annotation_index, const bool separate_chimeric_bam_file) {
 
 	if (forward_mate->core.flag & BAM_FUNMAP) // ignore unmapped reads
 		return false;
@@ -94,15 +260,12 @@ bool extract_read_through_alignment(chimeric_alignments_t& chimeric_alignments,
 		swap(forward_mate, reverse_mate);
 
 	// check if one mate maps inside the gene and the other outside
-	gene_set_t forward_mate_genes, reverse_mate_genes;
-	if (forward_mate != NULL)
-		get_annotation_by_coordinate(forward_mate->core.tid, forward_mate->core.pos, forward_mate->core.pos, forward_mate_genes, gene_annotation_index);
-	else
-		get_annotation_by_coordinate(reverse_mate->core.tid, reverse_mate->core.pos, reverse_mate->core.pos, forward_mate_genes, gene_annotation_index);
-	if (reverse_mate != NULL)
-		get_annotation_by_coordinate(reverse_mate->core.tid, bam_endpos(reverse_mate), bam_endpos(reverse_mate), reverse_mate_genes, gene_annotation_index);
-	else
-		get_annotation_by_coordinate(forward_mate->core.tid, bam_endpos(forward_mate), bam_endpos(forward_mate), reverse_mate_genes, gene_annotation_index);
+	gene_view_t forward_mate_genes = (forward_mate != NULL) ?
+		get_annotation_at_position(forward_mate->core.tid, forward_mate->core.pos, gene_annotation_index) :
+		get_annotation_at_position(reverse_mate->core.tid, reverse_mate->core.pos, gene_annotation_index);
+	gene_view_t reverse_mate_genes = (reverse_mate != NULL) ?
+		get_annotation_at_position(reverse_mate->core.tid, bam_endpos(reverse_mate), gene_annotation_index) :
+		get_annotation_at_position(forward_mate->core.tid, bam_endpos(forward_mate), gene_annotation_index);
 	gene_set_t common_genes;
 	combine_annotations(forward_mate_genes, reverse_mate_genes, common_genes, false);
 	if (common_genes.empty() && !(forward_mate_genes.empty() && reverse_mate_genes.empty())) { // mate1 and mate2 map to different genes => potential read-through fusion
@@ -133,7 +296,7 @@ bool extract_read_through_alignment(chimeric_alignments_t& chimeric_alignments,
 		    (!reverse_mate_has_intron || forward_read_pos < reverse_mate->core.l_qseq - reverse_read_pos)) { // if both mates are clipped, use the one with the longer segment as anchor
 
 			// only add the read-through alignment, if it is not also a chimeric alignment
-			if (!separate_chimeric_bam_file || chimeric_alignments.find((char*) bam_get_qname(forward_mate)) == chimeric_alignments.end()) {
+			if (!separate_chimeric_bam_file || separate_chimeric_alignments.find((char*) bam_get_qname(forward_mate)) == separate_chimeric_alignments.end()) {
 				// make split read and supplementary from forward mate
 				add_chimeric_alignment(chimeric_alignments, forward_mate, forward_cigar_op, forward_read_pos, true/*clip start*/, false, false/*split-read*/);
 				add_chimeric_alignment(chimeric_alignments, forward_mate, forward_cigar_op, forward_read_pos, false, true/*clip end*/, true/*supplementary*/);
@@ -151,7 +314,7 @@ bool extract_read_through_alignment(chimeric_alignments_t& chimeric_alignments,
 		} else if (reverse_mate_has_intron) {
 
 			// only add the read-through alignment, if it is not also a chimeric alignment
-			if (!separate_chimeric_bam_file || chimeric_alignments.find((char*) bam_get_qname(reverse_mate)) == chimeric_alignments.end()) {
+			if (!separate_chimeric_bam_file || separate_chimeric_alignments.find((char*) bam_get_qname(reverse_mate)) == separate_chimeric_alignments.end()) {
 				// make split read and supplementary from reverse mate
 				add_chimeric_alignment(chimeric_alignments, reverse_mate, reverse_cigar_op, reverse_read_pos, true/*clip start*/, false, true/*supplementary*/);
 				add_chimeric_alignment(chimeric_alignments, reverse_mate, reverse_cigar_op, reverse_read_pos, false, true/*clip end*/, false/*split-read*/);
@@ -172,7 +335,7 @@ bool extract_read_through_alignment(chimeric_alignments_t& chimeric_alignments,
 		           bam_endpos(forward_mate) <= forward_gene_end) {
 
 			// only add the read-through alignment, if it is not also a chimeric alignment
-			if (!separate_chimeric_bam_file || chimeric_alignments.find((char*) bam_get_qname(forward_mate)) == chimeric_alignments.end()) {
+			if (!separate_chimeric_bam_file || separate_chimeric_alignments.find((char*) bam_get_qname(forward_mate)) == separate_chimeric_alignments.end()) {
 				// add discordant mates to chimeric alignments file
 				add_chimeric_alignment(chimeric_alignments, forward_mate);
 				add_chimeric_alignment(chimeric_alignments, reverse_mate);
@@ -185,122 +348,444 @@ bool extract_read_through_alignment(chimeric_alignments_t& chimeric_alignments,
 	return false;
 }
 
-unsigned int read_chimeric_alignments(const string& bam_file_path, const string& assembly_file_path, chimeric_alignments_t& chimeric_alignments, unsigned long int& mapped_reads, coverage_t& coverage, contigs_t& contigs, const contigs_t& interesting_contigs, const gene_annotation_index_t& gene_annotation_index, const bool separate_chimeric_bam_file, const bool is_rna_bam_file) {
+// checks if a record is the supplementary alignment of a split read,
+// which is added to the chimeric alignments without waiting for the mates
+bool is_supplementary_alignment(const bam1_t* bam_record, const bool separate_chimeric_bam_file, const bool is_rna_bam_file) {
+	return separate_chimeric_bam_file && !is_rna_bam_file && (bam_record->core.flag & BAM_FSECONDARY) || // supplementary reads of Chimeric.out.sam
+	       is_rna_bam_file && (bam_record->core.flag & BAM_FSUPPLEMENTARY); // supplementary reads of Aligned.out.bam
+}
 
-	// open BAM file
-	samFile* bam_file = sam_open(bam_file_path.c_str(), "rb");
-	if (bam_file->is_cram)
-		cram_set_option(bam_file->fp.cram, CRAM_OPT_REFERENCE, assembly_file_path.c_str());
-	bam_hdr_t* bam_header = sam_hdr_read(bam_file);
+// checks if a complete fragment (both mates or a single-end read) is chimeric and adds it to the coverage
+// supplementary alignments are added to <chimeric_alignments> as they are
+// returns true, if the fragment was added to <chimeric_alignments>
+bool classify_fragment(bam1_t* bam_record, bam1_t* previously_seen_mate, chimeric_alignments_t& chimeric_alignments, const chimeric_alignments_t& separate_chimeric_alignments, coverage_t& coverage, const gene_annotation_index_t& gene_annotation_index, const bool separate_chimeric_bam_file, const bool is_rna_bam_file, bool& no_chimeric_reads) {
 
-	// add contigs which are not yet listed in <contigs>
-	// and make a map tid -> contig, because the contig IDs in the BAM file need not necessarily match the contig IDs in the GTF file
-	tid_to_contig_t tid_to_contig(bam_header->n_targets);
-	vector<bool> interesting_tids(bam_header->n_targets);
-	for (int target = 0; target < bam_header->n_targets; ++target) {
-		string contig_name = removeChr(bam_header->target_name[target]);
-		contigs.insert(pair<string,contig_t>(contig_name, contigs.size())); // this fails (i.e., nothing is inserted), if the contig already exists
-		tid_to_contig[target] = contigs[contig_name];
-		if (is_rna_bam_file) // only count reads of Aligned.out.bam, not of Chimeric.out.sam
-			interesting_tids[target] = (interesting_contigs.find(contig_name) != interesting_contigs.end()) || interesting_contigs.empty();
-	}
+	if (is_supplementary_alignment(bam_record, separate_chimeric_bam_file, is_rna_bam_file)) {
 
-	// read BAM records
-	bam1_t* bam_record = bam_init1();
-	if (bam_record == NULL) {
-		cerr << "ERROR: failed to allocate memory." << endl;
-		exit(1);
-	}
-	buffered_bam_records_t buffered_bam_records; // holds the first mate until we have found the second
-	bool no_chimeric_reads = true;
-	while (sam_read1(bam_file, bam_header, bam_record) >= 0) {
+		add_chimeric_alignment(chimeric_alignments, bam_record, 0, 0, false, false, true);
+		no_chimeric_reads = false;
+		return true;
 
-		if (is_rna_bam_file)
-			if ((bam_record->core.flag & (BAM_FSECONDARY | BAM_FUNMAP)) || (bam_record->core.flag & BAM_FPAIRED) && (bam_record->core.flag & BAM_FMUNMAP)) // ignore multi-mapping and unmapped reads
-				continue;
+	} else if (separate_chimeric_bam_file && !is_rna_bam_file) { // this is Chimeric.out.sam => load everything
 
-		// fix contig number to match ours
-		bam_record->core.tid = tid_to_contig[bam_record->core.tid];
+		add_chimeric_alignment(chimeric_alignments, bam_record);
+		if (previously_seen_mate != NULL)
+			add_chimeric_alignment(chimeric_alignments, previously_seen_mate);
+		no_chimeric_reads = false;
+		return true;
 
-		if (separate_chimeric_bam_file && !is_rna_bam_file && (bam_record->core.flag & BAM_FSECONDARY)) { // extract supplementary reads from Chimeric.out.sam
-			add_chimeric_alignment(chimeric_alignments, bam_record, 0, 0, false, false, true);
-			no_chimeric_reads = false;
-			continue; // supplementary alignments are added directly; all other reads need to be buffered until we have found the mate (see below)
-		}
+	} else { // this is Aligned.out.bam => load only discordant mates and split reads, and only when there is no Chimeric.out.sam
+
+		bool is_chimeric_alignment = false;
+		bool is_read_through_alignment = false;
 
-		if (is_rna_bam_file && (bam_record->core.flag & BAM_FSUPPLEMENTARY)) { // extract supplementary reads from Aligned.out.bam
-			if (!separate_chimeric_bam_file) { // don't load supplementary reads twice (from Chimeric.out.sam and from Aligned.out.bam)
-				add_chimeric_alignment(chimeric_alignments, bam_record, 0, 0, false, false, true);
+		if ((bam_record->core.flag & BAM_FPAIRED) && !(bam_record->core.flag & BAM_FPROPER_PAIR) || // discordant mates
+		    bam_aux_get(bam_record, "SA") != NULL || previously_seen_mate != NULL && bam_aux_get(previously_seen_mate, "SA") != NULL) { // split-read
+			if (!separate_chimeric_bam_file) {
+				add_chimeric_alignment(chimeric_alignments, bam_record);
+				if (previously_seen_mate != NULL)
+					add_chimeric_alignment(chimeric_alignments, previously_seen_mate);
 				no_chimeric_reads = false;
+				is_chimeric_alignment = true;
 			}
-			continue;
+		} else { // only add read-through alignment, if it is not already a chimeric alignment
+			is_read_through_alignment = extract_read_through_alignment(chimeric_alignments, separate_chimeric_alignments, bam_record, previously_seen_mate, gene_annotation_index, separate_chimeric_bam_file);
 		}
 
+		coverage.add_fragment(bam_record, previously_seen_mate, is_read_through_alignment);
+		return is_chimeric_alignment || is_read_through_alignment;
+	}
+}
+
+// processes a single record of a BAM file:
+// - paired-end reads are buffered until the mate has been seen
+// - supplementary alignments and complete fragments are passed on to classify_fragment() or, if <deferred_fragments> is given,
+//   they are appended to <deferred_fragments> in the order of the file to be classified later (the caller must recycle the records then)
+// returns true, if the record is retained (in <buffered_bam_records> or <deferred_fragments>), in which case the caller must not reuse it
+bool classify_bam_record(bam1_t* bam_record, buffered_bam_records_t& buffered_bam_records, const tid_to_contig_t& tid_to_contig, const vector<bool>& interesting_tids, chimeric_alignments_t& chimeric_alignments, const chimeric_alignments_t& separate_chimeric_alignments, unsigned long int& mapped_reads, coverage_t& coverage, const gene_annotation_index_t& gene_annotation_index, const bool separate_chimeric_bam_file, const bool is_rna_bam_file, bool& no_chimeric_reads, vector< pair<bam1_t*,bam1_t*> >* deferred_fragments = NULL) {
+
+	if (is_rna_bam_file)
+		if ((bam_record->core.flag & (BAM_FSECONDARY | BAM_FUNMAP)) || (bam_record->core.flag & BAM_FPAIRED) && (bam_record->core.flag & BAM_FMUNMAP)) // ignore multi-mapping and unmapped reads
+			return false;
+
+	// fix contig number to match ours
+	bam_record->core.tid = tid_to_contig[bam_record->core.tid];
+
+	bam1_t* previously_seen_mate = NULL;
+	if (is_supplementary_alignment(bam_record, separate_chimeric_bam_file, is_rna_bam_file)) {
+
+		// supplementary alignments are added directly; all other reads need to be buffered until we have found the mate (see below)
+		if (is_rna_bam_file && separate_chimeric_bam_file) // don't load supplementary reads twice (from Chimeric.out.sam and from Aligned.out.bam)
+			return false;
+
+	} else {
+
 		// count mapped reads on interesting contigs
 		if (interesting_tids[bam_record->core.tid])
 			mapped_reads++;
 
 		// for paired-end data we need to wait until we have read both mates
-		bam1_t* previously_seen_mate = NULL;
 		if (bam_record->core.flag & BAM_FPAIRED) {
 
-			// try to insert the mate into the buffered BAM records
-			// if there was already a record with the same read name, insertion will fail (->second set to false) and
-			// previously_seen_mate->first will point to the mate which was already in the buffered BAM records
-			pair<buffered_bam_records_t::iterator,bool> find_previously_seen_mate = buffered_bam_records.insert(pair<string,bam1_t*>((char*) bam_get_qname(bam_record), bam_record));
-			if (!find_previously_seen_mate.second) { // this is the second mate we have seen
-				previously_seen_mate = find_previously_seen_mate.first->second;
-				buffered_bam_records.erase(find_previously_seen_mate.first); // remove from lookup buffer, we don't need it anymore
-			}
+			// if the mate is already buffered, it is removed from the buffer and returned,
+			// otherwise the given record is buffered
+			previously_seen_mate = buffered_bam_records.find_mate_or_insert(bam_record);
+			if (previously_seen_mate == NULL)
+				return true; // this is the first mate with the given read name, which we encounter
 
 		}
+	}
 
-		if ((bam_record->core.flag & BAM_FPAIRED) && previously_seen_mate == NULL) { // this is the first mate with the given read name, which we encounter
-			
-			bam_record = bam_init1(); // allocate memory for the next record
-			if (bam_record == NULL) {
-				cerr << "ERROR: failed to allocate memory." << endl;
-				exit(1);
-			}
+	// supplementary alignment, single-end data, or we have already read the first mate previously
+	if (deferred_fragments != NULL) {
+		deferred_fragments->push_back(make_pair(bam_record, previously_seen_mate));
+		return true;
+	}
+	classify_fragment(bam_record, previously_seen_mate, chimeric_alignments, separate_chimeric_alignments, coverage, gene_annotation_index, separate_chimeric_bam_file, is_rna_bam_file, no_chimeric_reads);
 
+	if (previously_seen_mate != NULL)
+		buffered_bam_records.recycle_bam_record(previously_seen_mate);
 
-		} else { // single-end data or we have already read the first mate previously
+	return false;
+}
 
-			if (separate_chimeric_bam_file && !is_rna_bam_file) { // this is Chimeric.out.sam => load everything
+// add contigs which are not yet listed in <contigs>
+// and make a map tid -> contig, because the contig IDs in the BAM file need not necessarily match the contig IDs in the GTF file
+void map_tids_to_contigs(const bam_hdr_t* bam_header, contigs_t& contigs, const contigs_t& interesting_contigs, const bool is_rna_bam_file, tid_to_contig_t& tid_to_contig, vector<bool>& interesting_tids) {
+	tid_to_contig.resize(bam_header->n_targets);
+	interesting_tids.resize(bam_header->n_targets);
+	for (int target = 0; target < bam_header->n_targets; ++target) {
+		string contig_name = removeChr(bam_header->target_name[target]);
+		contigs.insert(pair<string,contig_t>(contig_name, contigs.size())); // this fails (i.e., nothing is inserted), if the contig already exists
+		tid_to_contig[target] = contigs[contig_name];
+		if (is_rna_bam_file) // only count reads of Aligned.out.bam, not of Chimeric.out.sam
+			interesting_tids[target] = (interesting_contigs.find(contig_name) != interesting_contigs.end()) || interesting_contigs.empty();
+	}
+}
 
-				add_chimeric_alignment(chimeric_alignments, bam_record);
-				if (previously_seen_mate != NULL)
-					add_chimeric_alignment(chimeric_alignments, previously_seen_mate);
-				no_chimeric_reads = false;
+// checks if the BAM file is sorted by coordinate and has an index (.bai/.crai)
+bool is_sorted_and_indexed(samFile* bam_file, const bam_hdr_t* bam_header, const string& bam_file_path) {
+
+	// the sort order is given in the @HD line of the header
+	string header(bam_header->text, bam_header->l_text);
+	if (header.substr(0, 3) != "@HD" || header.substr(0, header.find('\n')).find("\tSO:coordinate") == string::npos)
+		return false;
+
+	hts_idx_t* index = sam_index_load(bam_file, bam_file_path.c_str());
+	if (index == NULL)
+		return false;
+	hts_idx_destroy(index);
+	return true;
+}
+
+// the alignments of a read are appended to chimeric_alignments_t in the order of the file and
+// the order in which reads are first added determines the order in which they are iterated over later on,
+// which in turn affects the results (e.g., which of several equivalent alignments or duplicates is kept)
+// => when the records are classified in multiple threads, every shard remembers in which order reads were first added to it,
+//    such that the shards can be merged in the same order as when the file is read sequentially
+struct chimeric_alignments_shard_t {
+	chimeric_alignments_t chimeric_alignments;
+	vector<string> read_order;
+	// must be called after a record has been classified with the number of reads in the shard before
+	void track_read_order(const bam1_t* bam_record, const size_t reads_before) {
+		if (chimeric_alignments.size() > reads_before) // the read was added to the shard for the first time
+			read_order.push_back(bam_get_qname(bam_record));
+	};
+};
+
+// moves the alignments of the reads given by <read_order> from a shard to <chimeric_alignments>
+// the supplementary alignment of a split read may be in a different shard than the mates, so alignments are appended
+void merge_chimeric_alignments(chimeric_alignments_t& chimeric_alignments, chimeric_alignments_t& shard, const vector<string>::const_iterator& read_order_begin, const vector<string>::const_iterator& read_order_end) {
+	for (auto read = read_order_begin; read != read_order_end; ++read) {
+		chimeric_alignments_t::iterator fragment = shard.find(*read);
+		mates_t& mates = chimeric_alignments[*read];
+		mates.single_end = fragment->second.single_end;
+		mates.insert(mates.end(), make_move_iterator(fragment->second.begin()), make_move_iterator(fragment->second.end()));
+		shard.erase(fragment);
+	}
+}
+
+// when reading a coordinate-sorted, indexed BAM file in multiple threads,
+// every contig is processed separately and the results are stored in a shard
+struct bam_shard_t: public chimeric_alignments_shard_t {
+	unsigned long int mapped_reads;
+	bool no_chimeric_reads;
+	// mates which complete a fragment whose other mate is on the contig of a preceding shard,
+	// together with the number of reads in <read_order> which precede them in the file
+	vector< pair<size_t,bam1_t*> > cross_contig_mates;
+	vector<bam1_t*> unpaired_mates; // mates whose mate is on the contig of a subsequent shard
+	bam_shard_t(): mapped_reads(0), no_chimeric_reads(true) {};
+};
+
+unsigned int read_chimeric_alignments(const string& bam_file_path, const string& assembly_file_path, chimeric_alignments_t& chimeric_alignments, unsigned long int& mapped_reads, coverage_t& coverage, contigs_t& contigs, const contigs_t& interesting_contigs, const gene_annotation_index_t& gene_annotation_index, const bool separate_chimeric_bam_file, const bool is_rna_bam_file, const unsigned int threads) {
+
+	// open BAM file
+	samFile* bam_file = sam_open(bam_file_path.c_str(), "rb");
+	if (bam_file == NULL) {
+		cerr << "ERROR: failed to open file '" << bam_file_path << "'." << endl;
+		exit(1);
+	}
+	if (bam_file->is_cram)
+		cram_set_option(bam_file->fp.cram, CRAM_OPT_REFERENCE, assembly_file_path.c_str());
 
-			} else { // this is Aligned.out.bam => load only discordant mates and split reads, and only when there is no Chimeric.out.sam
+	// decompress BGZF blocks (or decode CRAM containers) in parallel,
+	// so that decompression overlaps with the parsing of records
+	// the threads are split between decompression and classification of the records, such that no more than
+	// <threads> threads are busy at a time; decompression is cheaper than classification, so it gets a smaller share
+	// with two threads, the records are decompressed by the thread which decodes them
+	const unsigned int decompression_threads = (threads > 2) ? max(1U, threads / 4) : 0;
+	htsThreadPool thread_pool = {NULL, 0};
+	if (decompression_threads > 0) {
+		thread_pool.pool = hts_tpool_init(decompression_threads);
+		if (thread_pool.pool == NULL) {
+			cerr << "ERROR: failed to create thread pool." << endl;
+			exit(1);
+		}
+		hts_set_opt(bam_file, HTS_OPT_THREAD_POOL, &thread_pool);
+	}
+	bam_hdr_t* bam_header = sam_hdr_read(bam_file);
 
-				bool is_read_through_alignment = false;
+	tid_to_contig_t tid_to_contig;
+	vector<bool> interesting_tids;
+	map_tids_to_contigs(bam_header, contigs, interesting_contigs, is_rna_bam_file, tid_to_contig, interesting_tids);
 
-				if ((bam_record->core.flag & BAM_FPAIRED) && !(bam_record->core.flag & BAM_FPROPER_PAIR) || // discordant mates
-				    bam_aux_get(bam_record, "SA") != NULL || previously_seen_mate != NULL && bam_aux_get(previously_seen_mate, "SA") != NULL) { // split-read
-					if (!separate_chimeric_bam_file) {
-						add_chimeric_alignment(chimeric_alignments, bam_record);
-						if (previously_seen_mate != NULL)
-							add_chimeric_alignment(chimeric_alignments, previously_seen_mate);
-						no_chimeric_reads = false;
+	buffered_bam_records_t buffered_bam_records; // holds the first mate until we have found the second
+	bool no_chimeric_reads = true;
+
+	if (threads <= 1) { // read and classify BAM records sequentially
+
+		bam1_t* bam_record = buffered_bam_records.new_bam_record();
+		while (sam_read1(bam_file, bam_header, bam_record) >= 0)
+			if (classify_bam_record(bam_record, buffered_bam_records, tid_to_contig, interesting_tids, chimeric_alignments, chimeric_alignments, mapped_reads, coverage, gene_annotation_index, separate_chimeric_bam_file, is_rna_bam_file, no_chimeric_reads))
+				bam_record = buffered_bam_records.new_bam_record(); // the record is retained in the buffer => get memory for the next record
+		buffered_bam_records.recycle_bam_record(bam_record);
+
+	} else if (is_rna_bam_file && is_sorted_and_indexed(bam_file, bam_header, bam_file_path)) { // process contigs in parallel
+
+		// targets whose names differ only by the prefix "chr" (e.g., "chr1" and "1") map to the same contig
+		// and must be processed by the same thread, because they write to the same coverage arrays,
+		// so one task processes all targets of a contig in the order of the file
+		vector< vector<int> > targets_by_task;
+		vector<long unsigned int> task_lengths;
+		vector<int> task_by_contig;
+		for (int target = 0; target < bam_header->n_targets; ++target) {
+			const contig_t contig = tid_to_contig[target];
+			if ((int) task_by_contig.size() <= contig)
+				task_by_contig.resize(contig+1, -1);
+			if (task_by_contig[contig] == -1) {
+				task_by_contig[contig] = targets_by_task.size();
+				targets_by_task.resize(targets_by_task.size() + 1);
+				task_lengths.push_back(0);
+			}
+			targets_by_task[task_by_contig[contig]].push_back(target);
+			task_lengths[task_by_contig[contig]] += bam_header->target_len[target];
+		}
+
+		// process the biggest contigs first for better load balancing
+		vector<unsigned int> tasks(targets_by_task.size());
+		for (unsigned int task = 0; task < tasks.size(); ++task)
+			tasks[task] = task;
+		sort(tasks.begin(), tasks.end(), [&](const unsigned int a, const unsigned int b) { return task_lengths[a] > task_lengths[b]; });
+
+		// every thread opens its own file handle, all of them share the thread pool for decompression
+		const unsigned int worker_threads = threads - decompression_threads;
+		vector<samFile*> thread_bam_files(worker_threads);
+		vector<bam_hdr_t*> thread_bam_headers(worker_threads);
+		vector<hts_idx_t*> thread_bam_indices(worker_threads);
+		vector<bam_shard_t> shards(targets_by_task.size());
+		run_in_parallel(worker_threads, tasks.size(), [&](const unsigned int task, const unsigned int thread_id) {
+
+			if (thread_bam_files[thread_id] == NULL) {
+				thread_bam_files[thread_id] = sam_open(bam_file_path.c_str(), "rb");
+				if (thread_bam_files[thread_id] == NULL) {
+					cerr << "ERROR: failed to open file '" << bam_file_path << "'." << endl;
+					exit(1);
+				}
+				if (thread_bam_files[thread_id]->is_cram)
+					cram_set_option(thread_bam_files[thread_id]->fp.cram, CRAM_OPT_REFERENCE, assembly_file_path.c_str());
+				if (thread_pool.pool != NULL)
+					hts_set_opt(thread_bam_files[thread_id], HTS_OPT_THREAD_POOL, &thread_pool);
+				thread_bam_headers[thread_id] = sam_hdr_read(thread_bam_files[thread_id]);
+				thread_bam_indices[thread_id] = sam_index_load(thread_bam_files[thread_id], bam_file_path.c_str());
+				if (thread_bam_headers[thread_id] == NULL || thread_bam_indices[thread_id] == NULL) {
+					cerr << "ERROR: failed to load index of file '" << bam_file_path << "'." << endl;
+					exit(1);
+				}
+			}
+
+			// each contig has its own shard, so threads never write to the same chimeric_alignments_t
+			// coverage_t is shared, but it keeps separate arrays for every contig and
+			// all fragments of a shard reside on the contig of the shard (mates on different contigs are deferred)
+			bam_shard_t& shard = shards[tasks[task]];
+			buffered_bam_records_t shard_buffered_bam_records;
+			bam1_t* bam_record = shard_buffered_bam_records.new_bam_record();
+			for (auto target = targets_by_task[tasks[task]].begin(); target != targets_by_task[tasks[task]].end(); ++target) {
+				hts_itr_t* iterator = sam_itr_queryi(thread_bam_indices[thread_id], *target, 0, INT_MAX);
+				if (iterator == NULL) {
+					cerr << "ERROR: failed to read contig '" << bam_header->target_name[*target] << "' from file '" << bam_file_path << "'." << endl;
+					exit(1);
+				}
+				while (sam_itr_next(thread_bam_files[thread_id], iterator, bam_record) >= 0) {
+					const size_t reads_before = shard.chimeric_alignments.size();
+					const bool retained = classify_bam_record(bam_record, shard_buffered_bam_records, tid_to_contig, interesting_tids, shard.chimeric_alignments, chimeric_alignments, shard.mapped_reads, coverage, gene_annotation_index, separate_chimeric_bam_file, is_rna_bam_file, shard.no_chimeric_reads);
+					shard.track_read_order(bam_record, reads_before);
+					if (retained) {
+						// when the file is read sequentially, a fragment whose mates are on different contigs is completed
+						// by the mate on the later contig => remember where in the order of the reads this happens
+						if ((bam_record->core.flag & BAM_FPAIRED) && bam_record->core.mtid >= 0 && task_by_contig[tid_to_contig[bam_record->core.mtid]] < (int) tasks[task])
+							shard.cross_contig_mates.push_back(make_pair(shard.read_order.size(), bam_record));
+						bam_record = shard_buffered_bam_records.new_bam_record(); // the record is retained in the buffer => get memory for the next record
 					}
-				} else { // only add read-through alignment, if it is not already a chimeric alignment
-					is_read_through_alignment = extract_read_through_alignment(chimeric_alignments, bam_record, previously_seen_mate, gene_annotation_index, separate_chimeric_bam_file);
 				}
+				hts_itr_destroy(iterator);
+			}
+			shard_buffered_bam_records.recycle_bam_record(bam_record);
+
+			// mates which have not been paired are on a different contig
+			// the ones which complete a fragment are taken care of via <cross_contig_mates>
+			shard_buffered_bam_records.extract_all(shard.unpaired_mates);
+			vector<bam1_t*> cross_contig_mates;
+			for (auto cross_contig_mate = shard.cross_contig_mates.begin(); cross_contig_mate != shard.cross_contig_mates.end(); ++cross_contig_mate)
+				cross_contig_mates.push_back(cross_contig_mate->second);
+			sort(cross_contig_mates.begin(), cross_contig_mates.end());
+			shard.unpaired_mates.erase(remove_if(shard.unpaired_mates.begin(), shard.unpaired_mates.end(), [&](bam1_t* unpaired_mate) { return binary_search(cross_contig_mates.begin(), cross_contig_mates.end(), unpaired_mate); }), shard.unpaired_mates.end());
+		});
+
+		for (unsigned int thread_id = 0; thread_id < worker_threads; ++thread_id) {
+			if (thread_bam_indices[thread_id] != NULL)
+				hts_idx_destroy(thread_bam_indices[thread_id]);
+			if (thread_bam_headers[thread_id] != NULL)
+				bam_hdr_destroy(thread_bam_headers[thread_id]);
+			if (thread_bam_files[thread_id] != NULL)
+				sam_close(thread_bam_files[thread_id]);
+		}
 
-				coverage.add_fragment(bam_record, previously_seen_mate, is_read_through_alignment);
+		// merge shards in the order of the contigs in the file and pair mates which reside on different contigs,
+		// such that reads and alignments are in the same order as when the file is read sequentially
+		// the record of the lower contig is treated as the previously seen mate, like when reading the file sequentially
+		auto pair_cross_contig_mate = [&](bam1_t* bam_record) {
+			bam1_t* previously_seen_mate = buffered_bam_records.find_mate_or_insert(bam_record);
+			if (previously_seen_mate != NULL) {
+				classify_fragment(bam_record, previously_seen_mate, chimeric_alignments, chimeric_alignments, coverage, gene_annotation_index, separate_chimeric_bam_file, is_rna_bam_file, no_chimeric_reads);
+				buffered_bam_records.recycle_bam_record(previously_seen_mate);
+				buffered_bam_records.recycle_bam_record(bam_record);
 			}
+		};
+		for (auto shard = shards.begin(); shard != shards.end(); ++shard) {
+			vector<string>::const_iterator merged_reads = shard->read_order.begin();
+			for (auto cross_contig_mate = shard->cross_contig_mates.begin(); cross_contig_mate != shard->cross_contig_mates.end(); ++cross_contig_mate) {
+				merge_chimeric_alignments(chimeric_alignments, shard->chimeric_alignments, merged_reads, shard->read_order.begin() + cross_contig_mate->first);
+				merged_reads = shard->read_order.begin() + cross_contig_mate->first;
+				pair_cross_contig_mate(cross_contig_mate->second);
+			}
+			merge_chimeric_alignments(chimeric_alignments, shard->chimeric_alignments, merged_reads, shard->read_order.end());
+			for (auto bam_record = shard->unpaired_mates.begin(); bam_record != shard->unpaired_mates.end(); ++bam_record)
+				pair_cross_contig_mate(*bam_record);
+			mapped_reads += shard->mapped_reads;
+			no_chimeric_reads = no_chimeric_reads && shard->no_chimeric_reads;
+		}
 
-			if (previously_seen_mate != NULL)
-				bam_destroy1(previously_seen_mate);
+	} else { // decode BAM records in a separate thread, while the current thread pairs the mates and classifies the fragments in parallel
+
+		// batches of decoded records are handed over to the classification stage via <full_batches>,
+		// processed batches are handed back to the decoding stage via <empty_batches> for reuse
+		vector<bam_record_batch_t> batches(BAM_RECORD_BATCHES);
+		bounded_queue_t<bam_record_batch_t*> full_batches(BAM_RECORD_BATCHES+1);
+		bounded_queue_t<bam_record_batch_t*> empty_batches(BAM_RECORD_BATCHES);
+		for (auto batch = batches.begin(); batch != batches.end(); ++batch) {
+			batch->records.resize(BAM_RECORD_BATCH_SIZE);
+			for (auto bam_record = batch->records.begin(); bam_record != batch->records.end(); ++bam_record) {
+				*bam_record = bam_init1();
+				if (*bam_record == NULL) {
+					cerr << "ERROR: failed to allocate memory." << endl;
+					exit(1);
+				}
+			}
+			empty_batches.push(&(*batch));
+		}
+
+		// decoding stage
+		thread decoder([&]() {
+			bool end_of_file = false;
+			while (!end_of_file) {
+				bam_record_batch_t* batch = empty_batches.pop();
+				for (batch->size = 0; batch->size < batch->records.size(); ++batch->size)
+					if (sam_read1(bam_file, bam_header, batch->records[batch->size]) < 0) {
+						end_of_file = true;
+						break;
+					}
+				full_batches.push(batch);
+			}
+			full_batches.push(NULL); // signal end of file
+		});
+
+		// classification stage
+		// mates are paired by the current thread, supplementary alignments and complete fragments are collected in the order of the file
+		// and classified in rounds by all threads
+		// every shard has its own chimeric_alignments_t and coverage_t, such that threads never write to the same data
+		// the shards only read <chimeric_alignments> when there is a separate Chimeric.out.sam, which is not written to
+		// before all threads of a round have finished
+		// the decoding stage runs in a thread of its own, so it is deducted from the threads for classification
+		const unsigned int classification_threads = threads - decompression_threads - 1;
+		vector< pair<bam1_t*,bam1_t*> > fragments;
+		fragments.reserve(FRAGMENTS_PER_ROUND);
+		vector<chimeric_alignments_shard_t> shard_chimeric_alignments(classification_threads);
+		vector<coverage_t> shard_coverage(classification_threads);
+		vector<char> shard_no_chimeric_reads(classification_threads, true); // not vector<bool>, because it is written concurrently
+		for (unsigned int shard = 0; shard < classification_threads; ++shard)
+			coverage.make_shard(shard_coverage[shard]);
+		auto classify_fragments = [&]() {
+			// fragments are assigned to shards by position rather than by thread, such that every shard holds a contiguous
+			// range of the file and the shards can be merged in the order of the file after every round
+			run_in_parallel(classification_threads, classification_threads, [&](const unsigned int shard, const unsigned int thread_id) {
+				chimeric_alignments_shard_t& shard_alignments = shard_chimeric_alignments[shard];
+				bool no_chimeric_reads_in_shard = shard_no_chimeric_reads[shard];
+				for (size_t fragment = fragments.size() * shard / classification_threads; fragment < fragments.size() * (shard + 1) / classification_threads; ++fragment) {
+					const size_t reads_before = shard_alignments.chimeric_alignments.size();
+					classify_fragment(fragments[fragment].first, fragments[fragment].second, shard_alignments.chimeric_alignments, chimeric_alignments, shard_coverage[shard], gene_annotation_index, separate_chimeric_bam_file, is_rna_bam_file, no_chimeric_reads_in_shard);
+					shard_alignments.track_read_order(fragments[fragment].first, reads_before);
+				}
+				shard_no_chimeric_reads[shard] = no_chimeric_reads_in_shard;
+			});
+			for (unsigned int shard = 0; shard < classification_threads; ++shard) {
+				merge_chimeric_alignments(chimeric_alignments, shard_chimeric_alignments[shard].chimeric_alignments, shard_chimeric_alignments[shard].read_order.begin(), shard_chimeric_alignments[shard].read_order.end());
+				shard_chimeric_alignments[shard].read_order.clear();
+			}
+			for (auto fragment = fragments.begin(); fragment != fragments.end(); ++fragment) {
+				buffered_bam_records.recycle_bam_record(fragment->first);
+				if (fragment->second != NULL)
+					buffered_bam_records.recycle_bam_record(fragment->second);
+			}
+			fragments.clear();
+		};
+		for (bam_record_batch_t* batch = full_batches.pop(); batch != NULL; batch = full_batches.pop()) {
+			for (unsigned int i = 0; i < batch->size; ++i) {
+				if (classify_bam_record(batch->records[i], buffered_bam_records, tid_to_contig, interesting_tids, chimeric_alignments, chimeric_alignments, mapped_reads, coverage, gene_annotation_index, separate_chimeric_bam_file, is_rna_bam_file, no_chimeric_reads, &fragments))
+					batch->records[i] = buffered_bam_records.new_bam_record(); // the record is retained => replace it in the batch
+			}
+			empty_batches.push(batch);
+			if (fragments.size() >= FRAGMENTS_PER_ROUND)
+				classify_fragments();
 		}
+		decoder.join();
+		classify_fragments();
+
+		// merge coverage of shards in a fixed order
+		for (unsigned int shard = 0; shard < classification_threads; ++shard) {
+			coverage.merge_shard(shard_coverage[shard]);
+			no_chimeric_reads = no_chimeric_reads && shard_no_chimeric_reads[shard];
+		}
+
+		for (auto batch = batches.begin(); batch != batches.end(); ++batch)
+			for (auto bam_record = batch->records.begin(); bam_record != batch->records.end(); ++bam_record)
+				bam_destroy1(*bam_record);
 	}
 
 	// close BAM file
-	bam_destroy1(bam_record);
 	bam_hdr_destroy(bam_header);
 	sam_close(bam_file);
+	if (thread_pool.pool != NULL)
+		hts_tpool_destroy(thread_pool.pool); // must be destroyed after the file is closed
 
 	// sanity check: input files should not be empty
 	if (is_rna_bam_file && mapped_reads == 0) {
@@ -318,6 +803,144 @@ unsigned int read_chimeric_alignments(const string& bam_file_path, const string&
 	return chimeric_alignments.size();
 }
 
+// copies the header of the input BAM file for the output of extract_chimeric_reads()
+// records are written when their fragment is complete, so the output is not sorted, even if the input is
+// => the sort order in the @HD line is set to "unsorted", such that the output is not mistaken for a sorted file
+bam_hdr_t* make_unsorted_bam_header(const bam_hdr_t* bam_header) {
+	bam_hdr_t* output_bam_header = bam_hdr_dup(bam_header);
+	if (output_bam_header == NULL)
+		return NULL;
+
+	string header(output_bam_header->text, output_bam_header->l_text);
+	if (header.substr(0, 3) != "@HD")
+		return output_bam_header; // without an @HD line, the sort order is unknown anyway
+	string::size_type hd_line_end = header.find('\n');
+	if (hd_line_end == string::npos)
+		hd_line_end = header.size();
+	string::size_type sort_order_start = header.find("\tSO:");
+	if (sort_order_start < hd_line_end) {
+		sort_order_start += 4; // skip "\tSO:"
+		const string::size_type sort_order_end = min(header.find('\t', sort_order_start), hd_line_end);
+		header.replace(sort_order_start, sort_order_end - sort_order_start, "unsorted");
+	} else {
+		header.insert(hd_line_end, "\tSO:unsorted");
+	}
+
+	free(output_bam_header->text);
+	output_bam_header->text = (char*) malloc(header.size() + 1);
+	if (output_bam_header->text == NULL) {
+		cerr << "ERROR: failed to allocate memory." << endl;
+		exit(1);
+	}
+	memcpy(output_bam_header->text, header.c_str(), header.size() + 1);
+	output_bam_header->l_text = header.size();
+	return output_bam_header;
+}
+
+unsigned int extract_chimeric_reads(const string& bam_file_path, const string& output_bam_file_path, const string& assembly_file_path, unsigned long int& mapped_reads, coverage_t& coverage, contigs_t& contigs, const contigs_t& interesting_contigs, const gene_annotation_index_t& gene_annotation_index, const unsigned int threads) {
+
+	// open input and output BAM files
+	samFile* bam_file = sam_open(bam_file_path.c_str(), "rb");
+	if (bam_file == NULL) {
+		cerr << "ERROR: failed to open file '" << bam_file_path << "'." << endl;
+		exit(1);
+	}
+	if (bam_file->is_cram)
+		cram_set_option(bam_file->fp.cram, CRAM_OPT_REFERENCE, assembly_file_path.c_str());
+	samFile* output_bam_file = sam_open(output_bam_file_path.c_str(), "wb");
+	if (output_bam_file == NULL) {
+		cerr << "ERROR: failed to open file '" << output_bam_file_path << "' for writing." << endl;
+		exit(1);
+	}
+
+	// decompress the input and compress the output in parallel
+	// the current thread classifies the records, so it is deducted from the threads for (de)compression
+	htsThreadPool thread_pool = {NULL, 0};
+	if (threads > 1) {
+		thread_pool.pool = hts_tpool_init(threads - 1);
+		if (thread_pool.pool == NULL) {
+			cerr << "ERROR: failed to create thread pool." << endl;
+			exit(1);
+		}
+		hts_set_opt(bam_file, HTS_OPT_THREAD_POOL, &thread_pool);
+		hts_set_opt(output_bam_file, HTS_OPT_THREAD_POOL, &thread_pool);
+	}
+
+	bam_hdr_t* bam_header = sam_hdr_read(bam_file);
+	bam_hdr_t* output_bam_header = (bam_header != NULL) ? make_unsorted_bam_header(bam_header) : NULL;
+	if (output_bam_header == NULL || sam_hdr_write(output_bam_file, output_bam_header) < 0) {
+		cerr << "ERROR: failed to copy header from '" << bam_file_path << "' to '" << output_bam_file_path << "'." << endl;
+		exit(1);
+	}
+	tid_to_contig_t tid_to_contig;
+	vector<bool> interesting_tids;
+	map_tids_to_contigs(bam_header, contigs, interesting_contigs, true, tid_to_contig, interesting_tids);
+
+	// classify_bam_record() replaces the tid of a record with our contig ID, which must be undone before the record is written
+	// when several tids map to the same contig (e.g., "chr1" and "1"), the first one is used, which makes no difference when the output is read again
+	vector<int32_t> contig_to_tid(contigs.size(), -1);
+	for (int target = bam_header->n_targets - 1; target >= 0; --target)
+		contig_to_tid[tid_to_contig[target]] = target;
+	unsigned int written_records = 0;
+	auto write_record = [&](bam1_t* bam_record) {
+		bam_record->core.tid = contig_to_tid[bam_record->core.tid];
+		if (sam_write1(output_bam_file, bam_header, bam_record) < 0) {
+			cerr << "ERROR: failed to write to file '" << output_bam_file_path << "'." << endl;
+			exit(1);
+		}
+		written_records++;
+	};
+
+	// the records are classified just like when reading them via read_chimeric_alignments(),
+	// but instead of keeping the chimeric alignments in memory, the records they were made from are written to the output
+	// the records are classified as if there was no Chimeric.out.sam, such that the output can be used with and without it
+	buffered_bam_records_t buffered_bam_records; // holds the first mate until we have found the second
+	chimeric_alignments_t chimeric_alignments; // holds the alignments of the current record only
+	vector< pair<bam1_t*,bam1_t*> > fragments; // holds the current fragment, if it is complete, or the current supplementary alignment
+	bool no_chimeric_reads = true;
+	bam1_t* bam_record = buffered_bam_records.new_bam_record();
+	while (sam_read1(bam_file, bam_header, bam_record) >= 0) {
+
+		if (classify_bam_record(bam_record, buffered_bam_records, tid_to_contig, interesting_tids, chimeric_alignments, chimeric_alignments, mapped_reads, coverage, gene_annotation_index, false, true, no_chimeric_reads, &fragments)) {
+
+			if (!fragments.empty()) { // fragment is complete or supplementary alignment
+				if (classify_fragment(fragments[0].first, fragments[0].second, chimeric_alignments, chimeric_alignments, coverage, gene_annotation_index, false, true, no_chimeric_reads)) {
+					if (fragments[0].second != NULL)
+						write_record(fragments[0].second); // write mates in the order in which they were read
+					write_record(fragments[0].first);
+				}
+				buffered_bam_records.recycle_bam_record(fragments[0].first);
+				if (fragments[0].second != NULL)
+					buffered_bam_records.recycle_bam_record(fragments[0].second);
+				fragments.clear();
+				chimeric_alignments.clear();
+			}
+			bam_record = buffered_bam_records.new_bam_record(); // the record is retained => get memory for the next record
+
+		}
+	}
+	buffered_bam_records.recycle_bam_record(bam_record);
+
+	// close BAM files
+	bam_hdr_destroy(output_bam_header);
+	bam_hdr_destroy(bam_header);
+	sam_close(bam_file);
+	if (sam_close(output_bam_file) < 0) {
+		cerr << "ERROR: failed to write to file '" << output_bam_file_path << "'." << endl;
+		exit(1);
+	}
+	if (thread_pool.pool != NULL)
+		hts_tpool_destroy(thread_pool.pool); // must be destroyed after the files are closed
+
+	// sanity check: input file should not be empty
+	if (mapped_reads == 0) {
+		cerr << "ERROR: no normal reads found" << endl;
+		exit(1);
+	}
+
+	return written_records;
+}
+
 void assign_strands_from_strandedness(chimeric_alignments_t& chimeric_alignments, const strandedness_t strandedness) {
 	if (strandedness != STRANDEDNESS_NO) {
 		for (chimeric_alignments_t::iterator chimeric_alignment = chimeric_alignments.begin(); chimeric_alignment != chimeric_alignments.end(); ++chimeric_alignment) {
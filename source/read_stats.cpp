@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <climits>
 #include <cmath>
 #include <iostream>
@@ -129,16 +130,95 @@ strandedness_t detect_strandedness(const chimeric_alignments_t& chimeric_alignme
 }
 
 // initialize data structure to compute coverage for windows of size <COVERAGE_RESOLUTION>
+// only the page table is allocated here, the pages are allocated as fragments are added
 coverage_t::coverage_t(const contigs_t& contigs, const assembly_t& assembly) {
-	fragment_starts.resize(contigs.size());
-	fragment_ends.resize(contigs.size());
-	coverage.resize(contigs.size());
+	pages.resize(contigs.size());
+	windows.resize(contigs.size());
 	for (assembly_t::const_iterator contig = assembly.begin(); contig != assembly.end(); ++contig) {
 		if (!contig->second.empty()) {
-			unsigned int windows = contig->second.size() / COVERAGE_RESOLUTION + 2; //+2 to avoid array-out-of-bounds errors
-			fragment_starts[contig->first].resize(windows);
-			fragment_ends[contig->first].resize(windows);
-			coverage[contig->first].resize(windows);
+			windows[contig->first] = contig->second.size() / COVERAGE_RESOLUTION + 2; //+2 to avoid array-out-of-bounds errors
+			pages[contig->first].resize((windows[contig->first] + COVERAGE_PAGE_SIZE - 1) / COVERAGE_PAGE_SIZE);
+		}
+	}
+}
+
+coverage_t::~coverage_t() {
+	for (auto contig = pages.begin(); contig != pages.end(); ++contig)
+		for (auto page = contig->begin(); page != contig->end(); ++page)
+			delete *page;
+}
+
+// returns the page which holds the given window and allocates it, if need be
+// pages of different contigs may be allocated concurrently, but not pages of the same contig
+coverage_t::page_t* coverage_t::get_page(const contig_t contig, const unsigned int window) {
+	if (window >= windows[contig])
+		return NULL;
+	page_t*& page = pages[contig][window / COVERAGE_PAGE_SIZE];
+	if (page == NULL)
+		page = new page_t();
+	return page;
+}
+
+// the counters of a page have 8 bits, until one of them overflows, then the page switches to 16-bit counters
+void coverage_t::increase_coverage(const contig_t contig, const unsigned int window) {
+	page_t* page = get_page(contig, window);
+	if (page == NULL)
+		return;
+	const unsigned int window_in_page = window % COVERAGE_PAGE_SIZE;
+	if (page->wide_coverage.empty()) {
+		if (page->coverage[window_in_page] < UCHAR_MAX) {
+			page->coverage[window_in_page]++;
+			return;
+		}
+		page->wide_coverage.assign(page->coverage, page->coverage + COVERAGE_PAGE_SIZE);
+	}
+	if (page->wide_coverage[window_in_page] < USHRT_MAX)
+		page->wide_coverage[window_in_page]++;
+}
+
+// prepare an empty coverage_t with the same windows as this one,
+// such that fragments can be added to it by a separate thread and merged later via merge_shard()
+void coverage_t::make_shard(coverage_t& shard) const {
+	shard.windows = windows;
+	shard.pages.clear();
+	shard.pages.resize(pages.size());
+	for (unsigned int contig = 0; contig < pages.size(); ++contig)
+		shard.pages[contig].resize(pages[contig].size());
+}
+
+// add the coverage of a shard to this one and empty the shard
+// since the counters saturate, the result is the same as if all fragments had been added to this coverage_t
+void coverage_t::merge_shard(coverage_t& shard) {
+	for (unsigned int contig = 0; contig < pages.size() && contig < shard.pages.size(); ++contig) {
+		for (unsigned int page_index = 0; page_index < pages[contig].size() && page_index < shard.pages[contig].size(); ++page_index) {
+
+			page_t*& shard_page = shard.pages[contig][page_index];
+			if (shard_page == NULL)
+				continue;
+			page_t*& page = pages[contig][page_index];
+			if (page == NULL) { // take over the page of the shard, if we have none
+				page = shard_page;
+				shard_page = NULL;
+				continue;
+			}
+
+			page->fragment_starts |= shard_page->fragment_starts;
+			page->fragment_ends |= shard_page->fragment_ends;
+			for (unsigned int window = 0; window < COVERAGE_PAGE_SIZE; ++window) {
+				unsigned int sum = (page->wide_coverage.empty()) ? page->coverage[window] : page->wide_coverage[window];
+				sum += (shard_page->wide_coverage.empty()) ? shard_page->coverage[window] : shard_page->wide_coverage[window];
+				if (page->wide_coverage.empty()) {
+					if (sum <= UCHAR_MAX) {
+						page->coverage[window] = sum;
+						continue;
+					}
+					page->wide_coverage.assign(page->coverage, page->coverage + COVERAGE_PAGE_SIZE);
+				}
+				page->wide_coverage[window] = min(sum, (unsigned int) USHRT_MAX);
+			}
+
+			delete shard_page;
+			shard_page = NULL;
 		}
 	}
 }
@@ -150,8 +230,8 @@ void coverage_t::add_fragment(bam1_t* mate1, bam1_t* mate2, const bool is_read_t
 	if (mate2 == NULL)
 		mate2 = mate1;
 
-	if ((unsigned int) mate1->core.tid >= fragment_starts.size() || fragment_starts[mate1->core.tid].empty() ||
-	    (unsigned int) mate2->core.tid >= fragment_starts.size() || fragment_starts[mate2->core.tid].empty())
+	if ((unsigned int) mate1->core.tid >= windows.size() || windows[mate1->core.tid] == 0 ||
+	    (unsigned int) mate2->core.tid >= windows.size() || windows[mate2->core.tid] == 0)
 		return; // ignore reads on uninteresting contigs
 
 	bool is_chimeric = is_read_through_alignment;
@@ -170,10 +250,10 @@ void coverage_t::add_fragment(bam1_t* mate1, bam1_t* mate2, const bool is_read_t
 
 	// store start of fragment
 	if (!is_chimeric) { // the 'no_coverage' filter should only consider non-chimeric reads
-		if (!(mate1->core.flag & BAM_FREVERSE) || !(mate1->core.flag & BAM_FPAIRED))
-			fragment_starts[mate1->core.tid][mate1->core.pos/COVERAGE_RESOLUTION] = true;
-		else
-			fragment_starts[mate2->core.tid][mate2->core.pos/COVERAGE_RESOLUTION] = true;
+		bam1_t* first_mate = (!(mate1->core.flag & BAM_FREVERSE) || !(mate1->core.flag & BAM_FPAIRED)) ? mate1 : mate2;
+		page_t* page = get_page(first_mate->core.tid, first_mate->core.pos/COVERAGE_RESOLUTION);
+		if (page != NULL)
+			page->fragment_starts[first_mate->core.pos/COVERAGE_RESOLUTION % COVERAGE_PAGE_SIZE] = true;
 	}
 
 	// compute coverage from CIGAR string
@@ -232,9 +312,8 @@ void coverage_t::add_fragment(bam1_t* mate1, bam1_t* mate2, const bool is_read_t
 		// increase coverage counter of windows that CIGAR element overlaps with
 		if (bam_cigar_type(bam_cigar_op(cigar_op)) & 1/*consume query*/) {
 			while (window <= position/COVERAGE_RESOLUTION) {
-				if (coverage[contig][window] < USHRT_MAX)
-					if (position - window * COVERAGE_RESOLUTION >= COVERAGE_RESOLUTION/2) // read must overlap at least half of the window
-						coverage[contig][window]++;
+				if (position - window * COVERAGE_RESOLUTION >= COVERAGE_RESOLUTION/2) // read must overlap at least half of the window
+					increase_coverage(contig, window);
 				++window;
 			}
 		} else {
@@ -245,21 +324,23 @@ void coverage_t::add_fragment(bam1_t* mate1, bam1_t* mate2, const bool is_read_t
 
 	// store end of fragment
 	if (!is_chimeric) { // the 'no_coverage' filter should only consider non-chimeric reads
-		if ((mate1->core.flag & BAM_FREVERSE) || !(mate1->core.flag & BAM_FPAIRED))
-			fragment_ends[mate1->core.tid][(position1-1)/COVERAGE_RESOLUTION] = true;
-		else
-			fragment_ends[mate2->core.tid][(position2-1)/COVERAGE_RESOLUTION] = true;
+		bam1_t* last_mate = ((mate1->core.flag & BAM_FREVERSE) || !(mate1->core.flag & BAM_FPAIRED)) ? mate1 : mate2;
+		const int last_window = (((last_mate == mate1) ? position1 : position2) - 1) / COVERAGE_RESOLUTION;
+		page_t* page = get_page(last_mate->core.tid, last_window);
+		if (page != NULL)
+			page->fragment_ends[last_window % COVERAGE_PAGE_SIZE] = true;
 	}
 }
 
 // returns true, if a fragment begins at the given position
 bool coverage_t::fragment_starts_here(const contig_t contig, const position_t start, const position_t end) const {
-	if ((unsigned int) contig >= fragment_starts.size())
+	if ((unsigned int) contig >= windows.size())
 		return false;
 	for (int window = start/COVERAGE_RESOLUTION + 1; window <= end/COVERAGE_RESOLUTION; ++window) {
-		if ((unsigned int) window >= fragment_starts[contig].size())
+		if ((unsigned int) window >= windows[contig])
 			return false;
-		if (fragment_starts[contig][window])
+		const page_t* page = find_page(contig, window);
+		if (page != NULL && page->fragment_starts[window % COVERAGE_PAGE_SIZE])
 			return true;
 	}
 	return false;
@@ -267,12 +348,13 @@ bool coverage_t::fragment_starts_here(const contig_t contig, const position_t st
 
 // returns true, if a fragment ends at the given position
 bool coverage_t::fragment_ends_here(const contig_t contig, const position_t start, const position_t end) const {
-	if ((unsigned int) contig >= fragment_ends.size())
+	if ((unsigned int) contig >= windows.size())
 		return false;
 	for (int window = start/COVERAGE_RESOLUTION; window < end/COVERAGE_RESOLUTION; ++window) {
-		if ((unsigned int) window >= fragment_ends[contig].size())
+		if ((unsigned int) window >= windows[contig])
 			return false;
-		if (fragment_ends[contig][window])
+		const page_t* page = find_page(contig, window);
+		if (page != NULL && page->fragment_ends[window % COVERAGE_PAGE_SIZE])
 			return true;
 	}
 	return false;
@@ -280,15 +362,23 @@ bool coverage_t::fragment_ends_here(const contig_t contig, const position_t star
 
 // get coverage within a window of <COVERAGE_RESOLUTION> upstream or downstream of given position
 int coverage_t::get_coverage(const contig_t contig, const position_t position, const direction_t direction) const {
-	if ((unsigned int) contig >= coverage.size() || coverage[contig].empty())
+	if ((unsigned int) contig >= windows.size() || windows[contig] == 0)
 		return -1;
+	int window;
 	if (direction == UPSTREAM) {
 		if (position < COVERAGE_RESOLUTION)
 			return 0;
 		else
-			return coverage[contig][position/COVERAGE_RESOLUTION-1];
+			window = position/COVERAGE_RESOLUTION-1;
 	} else { // direction == DOWNSTREAM
-		return coverage[contig][position/COVERAGE_RESOLUTION+1];
+		window = position/COVERAGE_RESOLUTION+1;
 	}
+	const page_t* page = find_page(contig, window);
+	if (page == NULL)
+		return 0;
+	else if (page->wide_coverage.empty())
+		return page->coverage[window % COVERAGE_PAGE_SIZE];
+	else
+		return page->wide_coverage[window % COVERAGE_PAGE_SIZE];
 }
 
@@ -1,7 +1,11 @@
 #ifndef _READ_STATS_H
 #define _READ_STATS_H 1
 
+#include <bitset>
+#include <cstring>
+#include <string>
 #include <vector>
+#include "bgzf.h"
 #include "common.hpp"
 #include "annotation.hpp"
 
@@ -12,15 +16,36 @@ bool estimate_mate_gap_distribution(const chimeric_alignments_t& chimeric_alignm
 strandedness_t detect_strandedness(const chimeric_alignments_t& chimeric_alignments, const gene_annotation_index_t& gene_annotation_index, const exon_annotation_index_t& exon_annotation_index);
 
 const int COVERAGE_RESOLUTION = 20; // at what resolution in bp to calculate the coverage
+const int COVERAGE_PAGE_SIZE = 128; // number of windows which are allocated at once
 // for each contig store for every window of <COVERAGE_RESOLUTION> bp whether a read starts/ends here
 // this information is needed by the 'no_coverage' filter
+// most windows are never covered by a fragment, so the windows are grouped into pages, which are only allocated when a fragment lands in them
 class coverage_t {
 	private:
-		vector< vector<bool> > fragment_starts; // for each window, store if a fragment starts here
-		vector< vector<bool> > fragment_ends; // for each window, store if a fragment ends here
-		vector< vector<unsigned short int> > coverage; // for each window, store the coverage
+		struct page_t {
+			unsigned char coverage[COVERAGE_PAGE_SIZE]; // for each window, store the coverage as long as it fits into 8 bits
+			vector<unsigned short int> wide_coverage; // replaces <coverage> once a window of the page reaches UCHAR_MAX
+			bitset<COVERAGE_PAGE_SIZE> fragment_starts; // for each window, store if a fragment starts here
+			bitset<COVERAGE_PAGE_SIZE> fragment_ends; // for each window, store if a fragment ends here
+			page_t(): fragment_starts(), fragment_ends() { memset(coverage, 0, sizeof(coverage)); }
+		};
+		vector< vector<page_t*> > pages; // for each contig, the pages of windows or NULL where no fragment has been seen
+		vector<unsigned int> windows; // number of windows of each contig
+		coverage_t(const coverage_t&); // not copyable
+		coverage_t& operator=(const coverage_t&);
+		const page_t* find_page(const contig_t contig, const unsigned int window) const {
+			return (window < windows[contig]) ? pages[contig][window / COVERAGE_PAGE_SIZE] : NULL;
+		}
+		page_t* get_page(const contig_t contig, const unsigned int window);
+		void increase_coverage(const contig_t contig, const unsigned int window);
+		friend void write_coverage(BGZF* file, const coverage_t& coverage, const contigs_t& contigs, const unsigned long int mapped_reads, bool& failed);
+		friend bool read_coverage(BGZF* file, const string& coverage_file, coverage_t& coverage, const contigs_t& contigs, unsigned long int& mapped_reads);
 	public:
+		coverage_t() {};
 		coverage_t(const contigs_t& contigs, const assembly_t& assembly);
+		~coverage_t();
+		void make_shard(coverage_t& shard) const;
+		void merge_shard(coverage_t& shard);
 		void add_fragment(bam1_t* mate1, bam1_t* mate2, const bool is_read_through_alignment);
 		bool fragment_starts_here(const contig_t contig, const position_t start, const position_t end) const;
 		bool fragment_ends_here(const contig_t contig, const position_t start, const position_t end) const;
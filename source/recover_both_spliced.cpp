@@ -16,11 +16,11 @@ unsigned int recover_both_spliced(fusions_t& fusions, const unsigned int max_fus
 	map< tuple<gene_t,gene_t,direction_t,direction_t>, vector<fusion_t*> > fusions_by_gene_pair;
 	for (fusions_t::iterator fusion = fusions.begin(); fusion != fusions.end(); ++fusion)
 		if (fusion->second.filter == NULL ||
-		    (fusion->second.both_breakpoints_spliced() && fusion->second.filter != FILTERS.at("merge_adjacent")) ||
-		    (fusion->second.both_breakpoints_spliced() && fusion->second.filter == FILTERS.at("pcr_fusions")) || // when there is risk of PCR-mediated fusions, only consider spliced events
-		    fusion->second.filter == FILTERS.at("intronic") ||
-		    fusion->second.filter == FILTERS.at("relative_support") ||
-		    fusion->second.filter == FILTERS.at("min_support")) {
+		    (fusion->second.both_breakpoints_spliced() && fusion->second.filter != get_filter(FILTER_MERGE_ADJACENT)) ||
+		    (fusion->second.both_breakpoints_spliced() && fusion->second.filter == get_filter(FILTER_PCR_FUSIONS)) || // when there is risk of PCR-mediated fusions, only consider spliced events
+		    fusion->second.filter == get_filter(FILTER_INTRONIC) ||
+		    fusion->second.filter == get_filter(FILTER_RELATIVE_SUPPORT) ||
+		    fusion->second.filter == get_filter(FILTER_MIN_SUPPORT)) {
 			fusions_by_gene_pair[make_tuple(fusion->second.gene1, fusion->second.gene2, (direction_t) fusion->second.direction1, (direction_t) fusion->second.direction2)].push_back(&fusion->second);
 		}
 
@@ -42,9 +42,9 @@ unsigned int recover_both_spliced(fusions_t& fusions, const unsigned int max_fus
 				continue; // don't recover intragenic events (this would produce too many hits)
 
 			if (fusion->second.filter != NULL &&
-			    fusion->second.filter != FILTERS.at("relative_support") &&
-			    fusion->second.filter != FILTERS.at("min_support") &&
-			    fusion->second.filter != FILTERS.at("pcr_fusions") && fusion->second.discordant_mates <= fusion->second.split_reads1 + fusion->second.split_reads2)
+			    fusion->second.filter != get_filter(FILTER_RELATIVE_SUPPORT) &&
+			    fusion->second.filter != get_filter(FILTER_MIN_SUPPORT) &&
+			    fusion->second.filter != get_filter(FILTER_PCR_FUSIONS) && fusion->second.discordant_mates <= fusion->second.split_reads1 + fusion->second.split_reads2)
 				continue; // we won't recover fusions which were not discarded due to low support
 
 			if (!fusion->second.both_breakpoints_spliced())
@@ -57,7 +57,7 @@ unsigned int recover_both_spliced(fusions_t& fusions, const unsigned int max_fus
 			auto fusions_of_given_gene_pair = fusions_by_gene_pair.find(make_tuple(fusion->second.gene1, fusion->second.gene2, (direction_t) fusion->second.direction1, (direction_t) fusion->second.direction2));
 			if (fusions_of_given_gene_pair != fusions_by_gene_pair.end())
 				for (auto another_fusion = fusions_of_given_gene_pair->second.begin(); another_fusion != fusions_of_given_gene_pair->second.end(); ++another_fusion)
-					if (fusion->second.filter == FILTERS.at("pcr_fusions")) {
+					if (fusion->second.filter == get_filter(FILTER_PCR_FUSIONS)) {
 						if ((**another_fusion).both_breakpoints_spliced() && (**another_fusion).discordant_mates <= (**another_fusion).split_reads1 + (**another_fusion).split_reads2)
 							sum_of_supporting_reads++; // if there is risk of PCR-mediated fusions, ignore the number of supporting reads and count the event as 1 read
 					} else { // the event is probably not PCR-mediated => actually count the number of supporting reads
@@ -74,7 +74,7 @@ unsigned int recover_both_spliced(fusions_t& fusions, const unsigned int max_fus
 						if ((**another_fusion).both_breakpoints_spliced() ||
 						    (((fusion->second.direction1 == DOWNSTREAM) != /*xor*/ (fusion->second.breakpoint1 > (**another_fusion).breakpoint1)) &&
 						     ((fusion->second.direction2 == DOWNSTREAM) != /*xor*/ (fusion->second.breakpoint2 > (**another_fusion).breakpoint2))))
-							if (fusion->second.filter == FILTERS.at("pcr_fusions")) {
+							if (fusion->second.filter == get_filter(FILTER_PCR_FUSIONS)) {
 								if ((**another_fusion).both_breakpoints_spliced() && (**another_fusion).discordant_mates <= (**another_fusion).split_reads1 + (**another_fusion).split_reads2)
 									sum_of_supporting_reads++; // if there is risk of PCR-mediated fusions, ignore the number of supporting reads and count the event as 1 read
 							} else { // the event is probably not PCR-mediated => actually count the number of supporting reads
@@ -23,10 +23,10 @@ unsigned int recover_isoforms(fusions_t& fusions) {
 			continue;
 		}
 
-		if (fusion->second.filter == FILTERS.at("merge_adjacent") || // don't recover alternative alignments
-		    fusion->second.filter == FILTERS.at("blacklist") || // don't recover normal splice variants and artifacts
-		    fusion->second.filter == FILTERS.at("end_to_end") || // don't recover alignments that happen to end at splice-sites
-		    fusion->second.filter == FILTERS.at("duplicates") || // don't recover fusions supported by nothing but duplicates
+		if (fusion->second.filter == get_filter(FILTER_MERGE_ADJACENT) || // don't recover alternative alignments
+		    fusion->second.filter == get_filter(FILTER_BLACKLIST) || // don't recover normal splice variants and artifacts
+		    fusion->second.filter == get_filter(FILTER_END_TO_END) || // don't recover alignments that happen to end at splice-sites
+		    fusion->second.filter == get_filter(FILTER_DUPLICATES) || // don't recover fusions supported by nothing but duplicates
 		    fusion->second.gene1 == fusion->second.gene2) // don't recover circular RNAs
 			continue;
 
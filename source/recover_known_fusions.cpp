@@ -46,7 +46,7 @@ unsigned int recover_known_fusions(fusions_t& fusions, const string& known_fusio
 			continue;
 
 		if (fusion->second.filter != NULL && // fusion has been filtered
-		    fusion->second.filter != FILTERS.at("relative_support") && fusion->second.filter != FILTERS.at("min_support")) // reason is not low support
+		    fusion->second.filter != get_filter(FILTER_RELATIVE_SUPPORT) && fusion->second.filter != get_filter(FILTER_MIN_SUPPORT)) // reason is not low support
 			continue; // we won't recover fusions which were not discarded due to low support
 
 		if (fusion->second.supporting_reads() >= 2 || // we still require at least two reads, otherwise there will be too many false positives
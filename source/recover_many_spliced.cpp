@@ -15,11 +15,11 @@ unsigned int recover_many_spliced(fusions_t& fusions, const unsigned int min_spl
 		    fusion->second.gene1 != fusion->second.gene2 &&
 		    !fusion->second.breakpoint_overlaps_both_genes() &&
 		    (fusion->second.filter == NULL ||
-		     fusion->second.filter == FILTERS.at("inconsistently_clipped") ||
-		     fusion->second.filter == FILTERS.at("homopolymer") ||
-		     fusion->second.filter == FILTERS.at("relative_support") ||
-		     fusion->second.filter == FILTERS.at("min_support") ||
-		     fusion->second.filter == FILTERS.at("select_best"))) {
+		     fusion->second.filter == get_filter(FILTER_INCONSISTENTLY_CLIPPED) ||
+		     fusion->second.filter == get_filter(FILTER_HOMOPOLYMER) ||
+		     fusion->second.filter == get_filter(FILTER_RELATIVE_SUPPORT) ||
+		     fusion->second.filter == get_filter(FILTER_MIN_SUPPORT) ||
+		     fusion->second.filter == get_filter(FILTER_SELECT_BEST))) {
 			spliced_fusions_by_gene_pair[make_tuple(fusion->second.gene1, fusion->second.gene2)]++;
 		}
 
@@ -36,11 +36,11 @@ unsigned int recover_many_spliced(fusions_t& fusions, const unsigned int min_spl
 		    fusion->second.breakpoint_overlaps_both_genes())
 			continue; // don't recover events between partners which are likely to occur by chance
 
-		if (fusion->second.filter == FILTERS.at("inconsistently_clipped") ||
-                    fusion->second.filter == FILTERS.at("homopolymer") ||
-                    fusion->second.filter == FILTERS.at("relative_support") ||
-                    fusion->second.filter == FILTERS.at("min_support") ||
-                    fusion->second.filter == FILTERS.at("select_best")) {
+		if (fusion->second.filter == get_filter(FILTER_INCONSISTENTLY_CLIPPED) ||
+                    fusion->second.filter == get_filter(FILTER_HOMOPOLYMER) ||
+                    fusion->second.filter == get_filter(FILTER_RELATIVE_SUPPORT) ||
+                    fusion->second.filter == get_filter(FILTER_MIN_SUPPORT) ||
+                    fusion->second.filter == get_filter(FILTER_SELECT_BEST)) {
 			if ((fusion->second.spliced1 || fusion->second.spliced2) &&
 			    spliced_fusions_by_gene_pair[make_tuple(fusion->second.gene1, fusion->second.gene2)] >= min_spliced_events) {
 				fusion->second.filter = NULL;
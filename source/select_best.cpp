@@ -66,7 +66,7 @@ unsigned int select_most_supported_breakpoints(fusions_t& fusions) {
 		if (fusion == best_breakpoints[make_tuple(fusion->second.gene1, fusion->second.gene2, (direction_t) fusion->second.direction1, (direction_t) fusion->second.direction2)])
 			remaining++;
 		else
-			fusion->second.filter = FILTERS.at("select_best");
+			fusion->second.filter = get_filter(FILTER_SELECT_BEST);
 
 	}
 	return remaining;